@@ -45,6 +45,9 @@
 #if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
  #include <stdint.h>
  extern uint32_t SystemD2Clock;
+ void vGenerateM4ToM7Interrupt( void * xUpdatedMessageBuffer );
+ void CpuRunTimeInit( void );
+ uint32_t u32CpuRunTimeGet( void );
 #endif
 
 #define configUSE_PREEMPTION                    1
@@ -66,7 +69,8 @@
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_APPLICATION_TASK_TAG          0
 #define configUSE_COUNTING_SEMAPHORES           1
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1  // CPU占用率统计(遥测), 计数器是DWT周期计数器
+#define configSUPPORT_STATIC_ALLOCATION         1  // ipc_stream的message buffer静态创建在SRAM4
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES                   0
@@ -125,6 +129,17 @@ header file. */
 #define vPortSVCHandler    SVC_Handler
 #define xPortPendSVHandler PendSV_Handler
 
+/* Override the default implementation of sbSEND_COMPLETED/sbRECEIVE_COMPLETED and
+their _FROM_ISR variants so the macros create an interrupt in the M7 core (see ipc_msgbuf.h). */
+#define sbSIGNAL_OTHER_CORE( pxStreamBuffer ) vGenerateM4ToM7Interrupt( pxStreamBuffer )
+#include "ipc_msgbuf.h"
+
+// 用于统计CPU占用率: DWT周期计数器(tim.c), 约18s回绕一次, 遥测每TLM_PERIOD_MS取差值, 不受影响
+#if (configGENERATE_RUN_TIME_STATS == 1)
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() CpuRunTimeInit()
+    #define portGET_RUN_TIME_COUNTER_VALUE()         u32CpuRunTimeGet()
+#endif
+
 /* IMPORTANT: This define MUST be commented when used with STM32Cube firmware,
               to prevent overwriting SysTick_Handler defined within STM32Cube HAL */
 //#define xPortSysTickHandler SysTick_Handler
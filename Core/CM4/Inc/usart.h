@@ -30,25 +30,23 @@ extern "C" {
 #include <stdbool.h>
 
 /* USER CODE BEGIN Includes */
-
+#include "uart_drv.h"
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart8;
 extern DMA_HandleTypeDef hdma_uart8_tx;
 extern DMA_HandleTypeDef hdma_uart8_rx;
+extern UartDrv_t stUart8Drv;
 
 /* USER CODE BEGIN Private defines */
 
 /* USER CODE END Private defines */
 
 void MX_UART8_Init(void);
-bool Uart_bReceive_NonBlocking(UART_HandleTypeDef*  UARTx, uint8_t *pDstAddr, uint32_t u32DataLen);
-bool Uart_bSend_NonBlocking(UART_HandleTypeDef*  UARTx, uint8_t *pSrcAddr, uint32_t u32DataLen);
-uint8_t GetUart8TxStatus(void);
 uint8_t GetUart8TxStatus(void);
+uint8_t GetUart8RxStatus(void);
 uint8_t ReadOneByteFromBuff(char *data);
 void PutUart8ToLisen(void);
-void UART8_Task(void);
 /* USER CODE BEGIN Prototypes */
 
 /* USER CODE END Prototypes */
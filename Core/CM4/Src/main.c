@@ -22,6 +22,8 @@
 #include "gpio.h"
 #include "usart.h"
 #include "stm32h747i_discovery.h"
+#include "ipc_notify.h"
+#include "ipc_stream.h"
 
 
 
@@ -68,6 +70,8 @@ int main(void)
   /* Initialize all configured peripherals */
   // MX_RTC_Init();
   MX_UART8_Init();
+  IPC_NotifyPortInit();  // 共享内存已经由CM7初始化
+  (void)IPC_bStreamInit();
 
 
   HAL_Delay(200); 
@@ -263,7 +263,7 @@ void ETH_WKUP_IRQHandler(void)
 void UART8_IRQHandler(void)
 {
   /* USER CODE BEGIN UART8_IRQn 0 */
-
+  UartDrv_IRQHandler(&stUart8Drv);  // 先处理Modbus帧间隔超时和接收错误, 不让HAL停止DMA接收
   /* USER CODE END UART8_IRQn 0 */
   HAL_UART_IRQHandler(&huart8);
   /* USER CODE BEGIN UART8_IRQn 1 */
@@ -271,6 +271,14 @@ void UART8_IRQHandler(void)
   /* USER CODE END UART8_IRQn 1 */
 }
 
+/**
+  * @brief This function handles HSEM2 (CM4) global interrupt, doorbell from CM7.
+  */
+void HSEM2_IRQHandler(void)
+{
+  HAL_HSEM_IRQHandler();
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
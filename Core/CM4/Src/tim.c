@@ -246,4 +246,16 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* tim_baseHandle)
 
 /* USER CODE BEGIN 1 */
 
+// CPU占用率统计的计数器: DWT周期计数器, CM7用TIM2中断计数, CM4不再占用定时器和中断
+void CpuRunTimeInit(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0U;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t u32CpuRunTimeGet(void)
+{
+  return DWT->CYCCNT;
+}
 /* USER CODE END 1 */
@@ -48,12 +48,12 @@
 #endif
 
 #define configUSE_PREEMPTION                    1  // 1：抢占式
-#define configUSE_IDLE_HOOK                     1  // 1：调用用户的IDLE任务
+#define configUSE_IDLE_HOOK                     0  // shell在单独的任务里运行, 不使用IDLE钩子
 #define configUSE_TICK_HOOK                     0
 #define configCPU_CLOCK_HZ                      ( SystemCoreClock )
 #define configTICK_RATE_HZ                      ( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES                    ( 16 )
-#define configMINIMAL_STACK_SIZE                ( ( uint16_t ) 1024 )
+#define configMINIMAL_STACK_SIZE                ( ( uint16_t ) 256 )
 #define configTOTAL_HEAP_SIZE                   ( ( size_t ) ( 20 * 1024 ) )
 #define configMAX_TASK_NAME_LEN                 ( 16 )
 #define configUSE_TRACE_FACILITY                1
@@ -68,7 +68,7 @@
 #define configUSE_COUNTING_SEMAPHORES           1
 #define configGENERATE_RUN_TIME_STATS           1  // 任务运行时间统计，CPU占用率统计
 
-#define configSUPPORT_STATIC_ALLOCATION         0
+#define configSUPPORT_STATIC_ALLOCATION         1
 
 /* Software timer definitions. */
 #define configUSE_TIMERS                        1        // 使用软件定时器
@@ -87,6 +87,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xQueueGetMutexHolder            1
 #define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetIdleTaskHandle          1
 #define INCLUDE_eTaskGetState                   1
 #define INCLUDE_xTimerPendFunctionCall          1
 
@@ -125,9 +126,10 @@ header file. */
 #define xPortPendSVHandler PendSV_Handler
 //#define xPortSysTickHandler SysTick_Handler
 
-/* Override the default implementation of sbSEND_COMPLETED so the macro creates
-an interrupt in the M4 core.  See the comments at the top of main.c. */
-#define sbSEND_COMPLETED( pxStreamBuffer ) vGenerateM7ToM4Interrupt( pxStreamBuffer )
+/* Override the default implementation of sbSEND_COMPLETED/sbRECEIVE_COMPLETED and
+their _FROM_ISR variants so the macros create an interrupt in the M4 core (see ipc_msgbuf.h). */
+#define sbSIGNAL_OTHER_CORE( pxStreamBuffer ) vGenerateM7ToM4Interrupt( pxStreamBuffer )
+#include "ipc_msgbuf.h"
 
 // 用于统计CPU占用率
 #ifdef configGENERATE_RUN_TIME_STATS
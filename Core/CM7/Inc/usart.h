@@ -30,6 +30,7 @@ extern "C" {
 #include <stdbool.h>
 
 /* USER CODE BEGIN Includes */
+#include "uart_drv.h"
 #define PRINT_BSIZE (512)    // 长度需要是32字节的整数倍,使用D-CACHE需要32字节对齐
 /* USER CODE END Includes */
 
@@ -37,6 +38,7 @@ extern UART_HandleTypeDef huart1;
 extern DMA_HandleTypeDef hdma_usart1_tx;
 extern DMA_HandleTypeDef hdma_usart1_rx;
 extern uint8_t Com1RxBuff[];
+extern UartDrv_t stUart1Drv;
 
 
 /* USER CODE BEGIN Private defines */
@@ -46,10 +48,6 @@ extern uint8_t Com1RxBuff[];
 void MX_USART1_UART_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-bool Uart_bReceive_NonBlocking(UART_HandleTypeDef*  UARTx, uint8_t *pDstAddr, uint32_t u32DataLen);
-bool Uart_bSend_NonBlocking(UART_HandleTypeDef*  UARTx, uint8_t *pSrcAddr, uint32_t u32DataLen);
-uint8_t GetUart1TxStatus(void);
-uint8_t GetUart1TxStatus(void);
 uint8_t ReadOneByteFromBuff(char *data);
 void PutUart1ToLisen(void);
 
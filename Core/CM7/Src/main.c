@@ -31,6 +31,8 @@
 #include "button.h"
 #include "shell_port.h"
 #include "littlefsapi.h"
+#include "sharemem.h"
+#include "ipc_stream.h"
 //#include "fatfsapi.h"
 
 
@@ -94,6 +96,11 @@ int main(void)
   /*HW semaphore Clock enable*/
   __HAL_RCC_HSEM_CLK_ENABLE();
 
+  // 共享内存必须在CM4运行之前初始化
+  ShareMemInit();
+  IPC_NotifyPortInit();
+  (void)IPC_bStreamInit();
+
   /*Take HSEM */
   /*Release HSEM in order to notify the CPU2(CM4)*/     
   HAL_HSEM_FastTake(HSEM_ID_0);
@@ -318,6 +325,21 @@ static void MPU_Config(void)
 
   HAL_MPU_ConfigRegion(&MPU_InitStruct);
 
+  /* Configure SRAM4 (share memory with CM4) as Non-cacheable and Shareable */
+  MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+  MPU_InitStruct.BaseAddress = SHARE_MEM_START;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_64KB;
+  MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+  MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+  MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+  MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+  MPU_InitStruct.Number = MPU_REGION_NUMBER1;
+  MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+  MPU_InitStruct.SubRegionDisable = 0x00;
+  MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
   /* Enable the MPU */
   HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
 }
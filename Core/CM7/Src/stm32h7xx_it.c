@@ -282,9 +282,20 @@ void EXTI15_10_IRQHandler(void)
   */
 void USART1_IRQHandler(void)
 {
+  UartDrv_IRQHandler(&stUart1Drv);  // 先处理批量接收的突发结束超时和接收错误, 不让HAL停止DMA接收
   HAL_UART_IRQHandler(&huart1);
 }
 
+/**
+  * @brief  This function handles HSEM1 (CM7) interrupt request, doorbell from CM4.
+  * @param  None
+  * @retval None
+  */
+void HSEM1_IRQHandler(void)
+{
+  HAL_HSEM_IRQHandler();
+}
+
 #if 1
 /* --------------------------------------------------------
  * DMA2
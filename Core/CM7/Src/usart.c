@@ -30,10 +30,10 @@
   #warning "Not define the printf buff size!"
 #endif
 
-#define INTER_FRM_SILENCE         (uint32_t)(11 * 3.5)      // 3.5 chars of 11 bits of INTER_FRM_SILENCE between frames
 #define INIT_FINISH_STR ("UART1 init finished.")
 #define STR_LEN (sizeof(INIT_FINISH_STR))
-#define COM1_RX_BLEN (256) 
+#define COM1_RX_BLEN (16384)      // 循环接收缓存, 2的整数次幂, 32字节的整数倍
+                                  // 文件传输写FLASH时不读, 要放得下整个窗口(FXP_SLOTS块和帧头)
 
 UART_HandleTypeDef huart1;
 DMA_HandleTypeDef hdma_usart1_tx;
@@ -41,18 +41,11 @@ DMA_HandleTypeDef hdma_usart1_rx;
 
 
 uint8_t Rxdata = 0;
-static uint8_t u8Uart1TxProgress = 0;  // UART1正在发送
-static uint8_t u8Uart1RxFinished = 0;  // UART1帧接收完成，待处理
-int16_t s16Uart1ReadIdx = 0;           // 从接收缓存读取的索引
-static uint8_t u8Uart1LisenStatus = 0; // UART1是否已处于Lisen状态
-
 
 //uint8_t Com1RxBuff[256] = {0};
 ALIGN_32BYTES(uint8_t Com1RxBuff[COM1_RX_BLEN]) = {0}; // DMA访问, 内存地址需要32字节对齐，长度需要是32字节的整数倍
 
-
-uint32_t u32RxDataCount = 0;   // 每次帧接收的数据字节数量
-uint32_t u32DmaRxDataLen = 0;  // 每次启动DMA接收设定的接收数量
+UartDrv_t stUart1Drv;                                  // UART1通道: 循环DMA接收 + 发送描述符队列
 
 /* USART1 init function */
 
@@ -85,6 +78,11 @@ void MX_USART1_UART_Init(void)
   {
     Error_Handler();
   }
+  if (!UartDrv_bInit(&stUart1Drv, "UART1", &huart1, Com1RxBuff, COM1_RX_BLEN))
+  {
+    Error_Handler();
+  }
+  (void)UartDrv_bSetRxAdaptive(&stUart1Drv, true);   // 命令行用空闲线事件, 文件传输时切换到批量模式
 
 #if 0
   /* USER CODE BEGIN USART1_Init 2 */
@@ -161,7 +159,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     hdma_usart1_rx.Init.MemInc = DMA_MINC_ENABLE;
     hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_usart1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_usart1_rx.Init.Mode = DMA_NORMAL;
+    hdma_usart1_rx.Init.Mode = DMA_CIRCULAR;                 // 循环接收, 不需要重新启动
     hdma_usart1_rx.Init.Priority = DMA_PRIORITY_VERY_HIGH;
     if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
     {
@@ -223,164 +221,17 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
   }
 }
 
-// USART接收完成中断,回调函数,中断标志清除在上一层完成
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
-{
-    if (huart == NULL) {
-      Error_Handler();
-    }
-
-    // 接收的字节数 = DMA_RX期望字节数 - DMA_RX剩余的字节数(DMAx, Channelx)
-    u32RxDataCount = (u32DmaRxDataLen - LL_DMA_GetDataLength(DMA2, LL_DMA_STREAM_1));
-}
-
-// USART发送完成中断,回调函数,中断标志清除在上一层完成
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
-{
-  if (huart == NULL) {
-    Error_Handler();
-  }
-
-  __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_TCF); // 清除发送完成标志
-  u8Uart1TxProgress = 0U;                       // UART1发送完成
-}
-
-
-// USART错误中断,回调函数,中断标志清除在上一层完成
-// 回调函数主要用于处理接收超时(帧间隔),其他仅累计次数
-void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
-{
-  if (huart == NULL) {
-    Error_Handler();
-  }
-
-  // Clear the Error flags in the ICR register
-  __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_OREF | UART_CLEAR_NEF | UART_CLEAR_PEF | UART_CLEAR_FEF);
-
-  // Send request to clear the Rx Not Empty flag
-  __HAL_UART_SEND_REQ(huart, UART_RXDATA_FLUSH_REQUEST);
-
-  if ((huart->ErrorCode & HAL_UART_ERROR_RTO) == HAL_UART_ERROR_RTO) // 接收超时
-  {
-    LL_USART_DisableIT_RTO(huart->Instance);     // USARTx
-    LL_USART_DisableRxTimeout(huart->Instance);  // USARTx
-
-    LL_USART_ClearFlag_RTO(huart->Instance);
-
-    // 在Abort之前，存储接收的字节数 = DMA_RX期望字节数 - DMA_RX剩余的字节数(DMAx, Channelx)
-    u32RxDataCount = (u32DmaRxDataLen - LL_DMA_GetDataLength(DMA2, LL_DMA_STREAM_1));
-    HAL_UART_AbortReceive(huart);
-
-
-    // 通知数据处理任务进行处理
-    u8Uart1LisenStatus = 0U;   // 不是监听状态
-    u8Uart1RxFinished = 0xFU;  // 新数据接收完成，允许处理
-    s16Uart1ReadIdx = 0;       // 新数据读取位置从0开始
-
-    // 在处理完数据的函数内需要重新使能DMA接收
-  }
-  else
-  {
-      //u16RxErrorCounter++;   // 其他 Error 累计错误次数
-  }
-}
-
-
-/*--------------------------------------------------------------------------------------*/
-// Class Method : Receive N bytes in non-blocking mode (IRQ or DMA)
-// DMA1/DMA2不能访问DTCM RAM, 所以用于接收和发送的buff需要定位到其他区域，比如D1
-// DMA访问的内存地址需要32字节对齐
-// DMA接收方式：设置一个缓存能接收的最大值，通过帧间隔超时来接收一次接收
-bool Uart_bReceive_NonBlocking(UART_HandleTypeDef *hUARTx, uint8_t *pDstAddr, uint32_t u32DataLen)
-{
-  HAL_StatusTypeDef result = HAL_ERROR;
-
-  if ((hUARTx == NULL) || (pDstAddr == NULL)) {
-    Error_Handler();
-  }
-
-  u32DmaRxDataLen = u32DataLen; // DMA接收的预期字节数，如果接收的字节数达到将会触发DMA_RX中断
-  u8Uart1RxFinished = 0U;       // 准备进行下一次接收
-
-  //Enable RX (UARTx);
-
-  // 清缓存，避免CM7读取的只是CACHE内的值
-  //SCB_CleanDCache_by_Addr((uint32_t *)pDstAddr, COM1_RX_BLEN);
-  result = HAL_UART_Receive_DMA(hUARTx, pDstAddr, u32DataLen);           // RX with DMA
-  //result = HAL_UART_Receive_IT(UARTx, pDstAddr, u32DataLen); // RX with IT
-
-  // Enable Rx Timeout (integrated to peripheral)
-  LL_USART_SetRxTimeout(hUARTx->Instance, INTER_FRM_SILENCE);
-  LL_USART_EnableIT_RTO(hUARTx->Instance);
-  LL_USART_EnableRxTimeout(hUARTx->Instance);
-
-  return (result == HAL_OK ? true : false);
-}
-
-/*--------------------------------------------------------------------------------------*/
-// Class Method : Send N bytes in non-blocking mode (IRQ or DMA)
-// DMA1/DMA2不能访问DTCM RAM, 所以用于接收和发送的buff需要定位到其他区域，比如D1
-// DMA访问的内存地址需要32字节对齐
-bool Uart_bSend_NonBlocking(UART_HandleTypeDef *hUARTx, uint8_t *pSrcAddr, uint32_t u32DataLen)
-{
-  HAL_StatusTypeDef result = HAL_ERROR;
-
-  if ((hUARTx == NULL) || (pSrcAddr == NULL)) {
-    Error_Handler();
-  }
-
-  //Enable RX (UARTx);
-  u8Uart1TxProgress = 0x0AU;
-  SCB_CleanDCache_by_Addr((uint32_t *)pSrcAddr, PRINT_BSIZE);     // 安装32字节的方式对齐,长度以字节为单位
-  result = HAL_UART_Transmit_DMA(hUARTx, pSrcAddr, u32DataLen);   // TX with DMA
-  //result = HAL_UART_Transmit_IT(hUARTx, pSrcAddr, u32DataLen);  // TX with IT
-
-  return  (result == HAL_OK ? true : false);
-}
-
-
+// 启动UART1的循环接收, 已经启动时不做任何事
 void PutUart1ToLisen(void)
 {
-  // 接收完成 && 数据处理完成
-  if ((u8Uart1LisenStatus == 0U) && (u8Uart1RxFinished == 0U)) {
-        Uart_bReceive_NonBlocking(&huart1, Com1RxBuff, (COM1_RX_BLEN / 2));
-        u8Uart1LisenStatus = 0xFU;
-  }
+  (void)UartDrv_bListen(&stUart1Drv);
 }
 
-uint8_t GetUart1TxStatus(void)
-{
-  return (u8Uart1TxProgress);
-}
-
-uint8_t GetUart1RxStatus(void)
-{
-  return (u8Uart1RxFinished);
-}
-
-
-
 // 从UART1的接收缓存里读取一字节
 // 返回值：
 // 0：没有数据
 // 1：获取1字节数据
 uint8_t ReadOneByteFromBuff(char *data)
 {
-    if ((u8Uart1RxFinished != 0U) && (s16Uart1ReadIdx >= u32RxDataCount)) {
-        s16Uart1ReadIdx = 0;
-        u8Uart1RxFinished = 0U; // 已经被读取了
-    }
-
-    if (0U == u8Uart1RxFinished) {
-        return 0U;
-    }
-
-    *data = (s16Uart1ReadIdx < COM1_RX_BLEN ? Com1RxBuff[s16Uart1ReadIdx] : 0U);
-    s16Uart1ReadIdx++;
-
-    return 1U;
+  return (uint8_t)UartDrv_u32Read(&stUart1Drv, (uint8_t *)data, 1U);
 }
-
-
-
-
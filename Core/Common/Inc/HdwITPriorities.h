@@ -52,6 +52,9 @@ static inline unsigned char HDW_IT_GETSUBPRIORITY(unsigned short _GlobalPriority
 #define HDW_IT_PRIORITY_SHELL_TXDMA               (HDW_IT_PRIORITY_5 + HDW_IT_SUBPRIORITY_0)     // DMA used
 #define HDW_IT_PRIORITY_SHELL_USART               (HDW_IT_PRIORITY_5 + HDW_IT_SUBPRIORITY_0)     // Rx, Tx, Rx Timeout
 
+// Inter-core doorbell (HSEM), 中断里调用FreeRTOS API, 优先级不能高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#define HDW_IT_PRIORITY_IPC_HSEM                (HDW_IT_PRIORITY_5 + HDW_IT_SUBPRIORITY_0)
+
 // Tasks
 #define HDW_IT_PRIORITY_TIM2                    (HDW_IT_PRIORITY_1 + HDW_IT_SUBPRIORITY_0)
 #define HDW_IT_PRIORITY_TSK_FAST                (HDW_IT_PRIORITY_1)
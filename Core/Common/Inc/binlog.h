@@ -0,0 +1,83 @@
+/**
+  ******************************************************************************
+  * @file    binlog.h
+  * @author  Drive FW team
+  * @brief   Header file of deferred binary logging
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 调用处不做格式化, 只把格式字符串的地址、时间戳和原始参数写入日志缓存,
+  * 格式字符串单独放在.logstr段里, 由主机工具Tools/binlog_decode.py从ELF文件
+  * 读出后还原成文本.
+  *
+  * 记录格式(小端): 0x00 | 参数个数 | 格式字符串地址(4) | DWT时间戳(4) | 参数(4*n)
+  * 文本日志里不会出现0x00, 主机工具据此区分文本和二进制记录.
+  * 参数都按32位整数记录, 格式字符串里只能用整数类的转换(%d %u %x %c %p ...),
+  * 不能用%s和%f.
+  * 调用处总是只写二进制记录. 日志和shell共用USART1, 默认(BLOG_BINARY_EN为0)由打印任务
+  * 在发送前把记录展开成文本; 用主机工具接收日志时在编译选项里定义BLOG_BINARY_EN=1,
+  * 记录原样发送.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BINLOG_H__
+#define __BINLOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// 1: 串口上发送二进制记录; 0: 打印任务发送前展开成文本(调用处都不格式化)
+// 日志和shell共用USART1, 二进制记录会让终端显示乱码, 只有用主机工具接收日志时才打开
+#ifndef BLOG_BINARY_EN
+#define BLOG_BINARY_EN     (0)
+#endif
+#define BLOG_ARGS_MAX      (4U)         // 单条记录最多参数个数
+#define BLOG_SYNC          (0x00U)      // 记录起始字节
+#define BLOG_REC_HDR_SIZE  (10U)        // 起始字节 + 参数个数 + 地址 + 时间戳
+#define BLOG_REC_MAX       (BLOG_REC_HDR_SIZE + BLOG_ARGS_MAX * 4U)
+#define BLOG_REC_LEN(n)    (BLOG_REC_HDR_SIZE + (uint32_t)(n) * 4U)  // n个参数的记录长度
+#define BLOG_TEXT_SIZE     (96U)        // 展开后单条日志最大长度, 32字节的整数倍(DMA发送)
+
+// 格式字符串放在.logstr段
+#if defined ( __ICCARM__ )
+#define BLOG_STR_DEF(name, fmt)    static const char name[] @ ".logstr" = fmt
+#else
+#define BLOG_STR_DEF(name, fmt)    static const char name[] __attribute__((section(".logstr"), used)) = fmt
+#endif
+
+// 按参数个数(包含格式字符串, 最多1+BLOG_ARGS_MAX个)选择BLOG0~BLOG4,
+// 格式字符串只展开一次, 只放在.logstr段里; 参数都转换成uint32_t
+#define BLOG_SEL_(_1, _2, _3, _4, _5, NAME, ...)  NAME
+#define BLOG0(fmt)                 do { BLOG_STR_DEF(s_BlogFmt, fmt); BLOG_Write(s_BlogFmt, 0U); } while (0)
+#define BLOG1(fmt, a)              do { BLOG_STR_DEF(s_BlogFmt, fmt);                                     \
+        BLOG_Write(s_BlogFmt, 1U, (uint32_t)(a)); } while (0)
+#define BLOG2(fmt, a, b)           do { BLOG_STR_DEF(s_BlogFmt, fmt);                                     \
+        BLOG_Write(s_BlogFmt, 2U, (uint32_t)(a), (uint32_t)(b)); } while (0)
+#define BLOG3(fmt, a, b, c)        do { BLOG_STR_DEF(s_BlogFmt, fmt);                                     \
+        BLOG_Write(s_BlogFmt, 3U, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c)); } while (0)
+#define BLOG4(fmt, a, b, c, d)     do { BLOG_STR_DEF(s_BlogFmt, fmt);                                     \
+        BLOG_Write(s_BlogFmt, 4U, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d)); } while (0)
+
+// 用法: BLOG("adc = %u, err = %d\r\n", u32Adc, s32Err);
+#define BLOG(...)                  BLOG_SEL_(__VA_ARGS__, BLOG4, BLOG3, BLOG2, BLOG1, BLOG0, 0)(__VA_ARGS__)
+
+
+void BLOG_Init(void);
+void BLOG_Write(const char *pFmt, uint32_t u32Nargs, ...);
+uint32_t BLOG_u32Expand(const uint8_t *pu8Rec, char *pBuff, uint32_t u32Size);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __BINLOG_H__ */
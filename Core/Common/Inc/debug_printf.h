@@ -25,6 +25,46 @@ extern "C" {
 #define JOYSEL_EVENT   (0x0002U)        // 按键事件
 #define DEBUG_PRINT_EN (1)              // 使能/禁能调试信息打印
 
+#include <stdint.h>
+#include <stdbool.h>
+
+// 日志等级, 数字越大越详细
+typedef enum {
+    LOG_LVL_NONE = 0,
+    LOG_LVL_ERR,
+    LOG_LVL_WARN,
+    LOG_LVL_INFO,
+    LOG_LVL_DEBUG,
+    LOG_LVL_MAX
+} LOG_Level_e;
+
+// 日志模块, 每个模块有自己的等级门限和限流
+typedef enum {
+    LOG_MOD_SYS = 0,
+    LOG_MOD_TASK,
+    LOG_MOD_KEY,
+    LOG_MOD_UART,
+    LOG_MOD_IPC,
+    LOG_MOD_FS,
+    LOG_MOD_MAX
+} LOG_Module_e;
+
+#define LOG_LEVEL_BUILD    (LOG_LVL_DEBUG)  // 编译时门限, 高于此等级的调用直接被编译器去掉
+#define LOG_LEVEL_DEFAULT  (LOG_LVL_INFO)   // 运行时门限的初始值, 可以用shell命令loglevel修改
+
+extern volatile uint8_t au8LogLevel[LOG_MOD_MAX];
+
+// 等级过滤在调用处完成, 被过滤的日志不做任何格式化; 限流在等级过滤之后
+#define LOG_ON(mod, lvl)   (((lvl) <= LOG_LEVEL_BUILD) && ((lvl) <= au8LogLevel[(mod)]))
+#define LOG_PASS(mod, lvl) (LOG_ON(mod, lvl) && LOG_bRateOk(mod))
+// ERROR及以上的日志写入后, 日志文件收到时马上sync, 不等定时(等级是常量时编译器直接去掉)
+#define LOG_URGENT(lvl)    do { if ((lvl) <= LOG_LVL_ERR) { LOG_MarkUrgent(); } } while (0)
+
+// 文本日志: LOGS(LOG_MOD_KEY, LOG_LVL_INFO, "key pressed\r\n");
+#define LOGS(mod, lvl, str)  do { if (LOG_PASS(mod, lvl)) { printf2buff(str); LOG_URGENT(lvl); } } while (0)
+// 二进制日志(binlog.h): LOGB(LOG_MOD_UART, LOG_LVL_WARN, "overrun %u\r\n", u32Cnt);
+#define LOGB(mod, lvl, ...)  do { if (LOG_PASS(mod, lvl)) { BLOG(__VA_ARGS__); LOG_URGENT(lvl); } } while (0)
+
 #if (DEBUG_PRINT_EN == 1)
 void debug_printf(char const *str);
 #define printf(str) debug_printf(str)
@@ -37,6 +77,15 @@ void printf2buff(char const *str);
 void printf2bufffromISR(char const *str);
 void printf2buffatinit(char const *str);
 void nprintf2buff(char const *str, uint16_t len);
+bool LOG_bWrite(const char *pStr, uint32_t u32Len);
+uint32_t LOG_u32Drops(void);
+uint32_t LOG_u32Used(void);
+void LOG_TxDoneFromISR(void *pArg);
+void LOG_Hold(bool bHold);
+bool LOG_bRateOk(LOG_Module_e eMod);
+void LOG_MarkUrgent(void);
+void LOG_SetLevel(LOG_Module_e eMod, LOG_Level_e eLevel);
+void LOG_SetRate(LOG_Module_e eMod, uint16_t u16PerSec, uint16_t u16Burst);
 
 
 
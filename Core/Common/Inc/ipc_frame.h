@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    ipc_frame.h
+  * @author  Drive FW team
+  * @brief   Header file of batched multi-record frames over sharemem lending slots
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 一个借用块(SHM_LEND_SLOT_SIZE)就是一帧, 帧里顺序存放多条记录, 一帧只提交/通知一次:
+  *   帧头:   u16Count(记录数) + u16Seq(帧序号)
+  *   记录头: u16Type(低14位类型 + 分片标志) + u16Len(本片数据长度), 数据4字节对齐
+  * 一帧放不下的记录分成多片, 除最后一片外都带IPC_FRM_MORE, 除第一片外都带IPC_FRM_CONT,
+  * 接收方把分片拼接到重组缓存后再交给处理函数.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IPC_FRAME_H__
+#define __IPC_FRAME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sharemem.h"
+
+#define IPC_FRM_HDR_SIZE       (4U)
+#define IPC_FRM_REC_HDR_SIZE   (4U)
+#define IPC_FRM_TYPE_MASK      (0x3FFFU)
+#define IPC_FRM_MORE           (0x8000U)               // 后面还有分片
+#define IPC_FRM_CONT           (0x4000U)               // 接着上一片
+
+typedef struct _IPC_FrameWriter_ {
+    SHM_Lend_t stLend;                                 // 正在填写的借用块
+    uint16_t u16Used;                                  // 已使用的字节数(包含帧头)
+    uint16_t u16Count;                                 // 帧里的记录数
+    uint16_t u16Seq;                                   // 下一帧的序号
+    bool     bOpen;                                    // stLend有效
+    uint32_t u32Frames;                                // 已提交的帧数
+    uint32_t u32Drops;                                 // 没有空闲块或提交失败丢弃的记录数
+} IPC_FrameWriter_t;
+
+// pData: 完整的记录数据(分片已重组), 只在回调里有效
+typedef void (*IPC_FrameHandler_t)(uint16_t u16Type, const uint8_t *pData, uint32_t u32Len, void *pArg);
+
+typedef struct _IPC_FrameReader_ {
+    uint8_t  *pu8Reasm;                                // 重组缓存, 由调用者提供
+    uint32_t u32ReasmSize;
+    uint32_t u32ReasmLen;
+    uint16_t u16ReasmType;
+    bool     bReasm;                                   // 正在重组
+    uint16_t u16Seq;                                   // 期望的下一帧序号
+    uint32_t u32Frames;                                // 已处理的帧数
+    uint32_t u32SeqErr;                                // 帧序号不连续的次数
+    uint32_t u32Drops;                                 // 丢弃的记录/分片数
+} IPC_FrameReader_t;
+
+
+void IPC_FrameWriterInit(IPC_FrameWriter_t *pW);
+bool IPC_bFramePut(IPC_FrameWriter_t *pW, uint16_t u16Type, const void *pData, uint32_t u32Len);
+bool IPC_bFrameFlush(IPC_FrameWriter_t *pW);
+
+void IPC_FrameReaderInit(IPC_FrameReader_t *pR, uint8_t *pu8Reasm, uint32_t u32ReasmSize);
+uint32_t IPC_u32FrameProcess(IPC_FrameReader_t *pR, IPC_FrameHandler_t pfHandler, void *pArg);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __IPC_FRAME_H__ */
@@ -0,0 +1,113 @@
+/**
+  ******************************************************************************
+  * @file    ipc_msgbuf.h
+  * @author  Drive FW team
+  * @brief   Stream/message buffer completion hooks shared by the CM7 and CM4 FreeRTOSConfig.h
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 由两个核的FreeRTOSConfig.h包含, 替换stream_buffer.c里的sbSEND_COMPLETED/sbRECEIVE_COMPLETED
+  * 和中断版本的sbSEND_COMPLETE_FROM_ISR/sbRECEIVE_COMPLETED_FROM_ISR(见ipc_stream.h).
+  * 包含之前先定义sbSIGNAL_OTHER_CORE(pxStreamBuffer): 敲对方核的门铃(vGenerateM7ToM4Interrupt等).
+  * 只有放在共享SRAM4里的buffer通知对方核, 本核的buffer和FreeRTOS默认实现一样通知等待的任务.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IPC_MSGBUF_H__
+#define __IPC_MSGBUF_H__
+
+#ifndef sbSIGNAL_OTHER_CORE
+#error "define sbSIGNAL_OTHER_CORE before including ipc_msgbuf.h"
+#endif
+
+#define sbIS_SHARED( pxStreamBuffer ) ( ( ( uint32_t ) ( pxStreamBuffer ) & 0xFFFF0000UL ) == 0x38000000UL )
+
+#define sbSEND_COMPLETED( pxStreamBuffer )                                       \
+    do {                                                                         \
+        if( sbIS_SHARED( pxStreamBuffer ) )                                      \
+        {                                                                        \
+            sbSIGNAL_OTHER_CORE( pxStreamBuffer );                               \
+        }                                                                        \
+        else                                                                     \
+        {                                                                        \
+            vTaskSuspendAll();                                                   \
+            if( ( pxStreamBuffer )->xTaskWaitingToReceive != NULL )              \
+            {                                                                    \
+                ( void ) xTaskNotify( ( pxStreamBuffer )->xTaskWaitingToReceive, \
+                                      ( uint32_t ) 0, eNoAction );               \
+                ( pxStreamBuffer )->xTaskWaitingToReceive = NULL;                \
+            }                                                                    \
+            ( void ) xTaskResumeAll();                                           \
+        }                                                                        \
+    } while( 0 )
+
+#define sbRECEIVE_COMPLETED( pxStreamBuffer )                                    \
+    do {                                                                         \
+        if( sbIS_SHARED( pxStreamBuffer ) )                                      \
+        {                                                                        \
+            sbSIGNAL_OTHER_CORE( pxStreamBuffer );                               \
+        }                                                                        \
+        else                                                                     \
+        {                                                                        \
+            vTaskSuspendAll();                                                   \
+            if( ( pxStreamBuffer )->xTaskWaitingToSend != NULL )                 \
+            {                                                                    \
+                ( void ) xTaskNotify( ( pxStreamBuffer )->xTaskWaitingToSend,    \
+                                      ( uint32_t ) 0, eNoAction );               \
+                ( pxStreamBuffer )->xTaskWaitingToSend = NULL;                   \
+            }                                                                    \
+            ( void ) xTaskResumeAll();                                           \
+        }                                                                        \
+    } while( 0 )
+
+// 中断里收发共享buffer时也要敲门铃, 否则对方核的任务一直等不到; 门铃(IPC_bNotifySignal)可以在中断里调用
+#define sbSEND_COMPLETE_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken )       \
+    do {                                                                            \
+        if( sbIS_SHARED( pxStreamBuffer ) )                                         \
+        {                                                                           \
+            sbSIGNAL_OTHER_CORE( pxStreamBuffer );                                  \
+        }                                                                           \
+        else                                                                        \
+        {                                                                           \
+            UBaseType_t uxSavedInterruptStatus;                                     \
+                                                                                    \
+            uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();             \
+            if( ( pxStreamBuffer )->xTaskWaitingToReceive != NULL )                 \
+            {                                                                       \
+                ( void ) xTaskNotifyFromISR( ( pxStreamBuffer )->xTaskWaitingToReceive, \
+                                             ( uint32_t ) 0, eNoAction,             \
+                                             ( pxHigherPriorityTaskWoken ) );       \
+                ( pxStreamBuffer )->xTaskWaitingToReceive = NULL;                   \
+            }                                                                       \
+            portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );            \
+        }                                                                           \
+    } while( 0 )
+
+#define sbRECEIVE_COMPLETED_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken )   \
+    do {                                                                            \
+        if( sbIS_SHARED( pxStreamBuffer ) )                                         \
+        {                                                                           \
+            sbSIGNAL_OTHER_CORE( pxStreamBuffer );                                  \
+        }                                                                           \
+        else                                                                        \
+        {                                                                           \
+            UBaseType_t uxSavedInterruptStatus;                                     \
+                                                                                    \
+            uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();             \
+            if( ( pxStreamBuffer )->xTaskWaitingToSend != NULL )                    \
+            {                                                                       \
+                ( void ) xTaskNotifyFromISR( ( pxStreamBuffer )->xTaskWaitingToSend, \
+                                             ( uint32_t ) 0, eNoAction,             \
+                                             ( pxHigherPriorityTaskWoken ) );       \
+                ( pxStreamBuffer )->xTaskWaitingToSend = NULL;                      \
+            }                                                                       \
+            portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );            \
+        }                                                                           \
+    } while( 0 )
+
+#endif /* __IPC_MSGBUF_H__ */
@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file    ipc_notify.h
+  * @author  Drive FW team
+  * @brief   Header file of doorbell notification between CM7 and CM4
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 每个方向一组挂起位: 发送方只写u32Req, 接收方只写u32Ack, (Req ^ Ack)为挂起的通道.
+  * 发送方翻转通道位后调用门铃函数, 接收方在门铃中断里调用IPC_u32NotifyDispatch().
+  * 门铃函数可以替换, 板上用HSEM(ipc_notify_port.c), 主机测试可以用条件变量代替.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IPC_NOTIFY_H__
+#define __IPC_NOTIFY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ipc_ring.h"
+
+// 通道号
+#define IPC_CH_MAILBOX         (0U)                    // sharemem环形缓存
+#define IPC_CH_LEND            (1U)                    // sharemem借用块
+#define IPC_CH_STREAM          (2U)                    // FreeRTOS stream/message buffer
+#define IPC_CH_RPC             (3U)                    // ipc_rpc请求/应答
+#define IPC_CH_MAX             (8U)
+
+// 门铃用的硬件信号量
+#define IPC_HSEM_ID_7TO4       (1U)
+#define IPC_HSEM_ID_4TO7       (2U)
+
+typedef struct _IPC_NotifyBits_ {
+    volatile uint32_t u32Req;                          // 只由发送方修改
+    uint8_t  au8Pad0[IPC_CACHE_LINE - sizeof(uint32_t)];
+    volatile uint32_t u32Ack;                          // 只由接收方修改
+    uint8_t  au8Pad1[IPC_CACHE_LINE - sizeof(uint32_t)];
+} IPC_NotifyBits_t;
+
+typedef void (*IPC_Doorbell_t)(void);
+typedef void (*IPC_NotifyHandler_t)(uint8_t u8Ch, void *pArg);
+
+
+void IPC_NotifyInit(IPC_NotifyBits_t *pTx, IPC_NotifyBits_t *pRx, IPC_Doorbell_t pfDoorbell);
+void IPC_NotifySetDoorbell(IPC_Doorbell_t pfDoorbell);
+bool IPC_bNotifyRegister(uint8_t u8Ch, IPC_NotifyHandler_t pfHandler, void *pArg);
+bool IPC_bNotifySignal(uint8_t u8Ch);
+uint32_t IPC_u32NotifyDispatch(void);
+
+// ipc_notify_port.c: HSEM门铃和FreeRTOS任务唤醒
+void IPC_NotifyPortInit(void);
+#if defined ( INC_TASK_H )
+bool IPC_bNotifyAttachTask(uint8_t u8Ch, TaskHandle_t xTask);
+uint32_t IPC_u32NotifyWait(TickType_t xTicksToWait);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __IPC_NOTIFY_H__ */
@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    ipc_ring.h
+  * @author  Drive FW team
+  * @brief   Header file of single-producer/single-consumer ring between CM7 and CM4
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 一个方向一个环形缓存: 生产者只写u32Head, 消费者只写u32Tail, 不需要锁.
+  * 缓存里存放变长记录: 4字节记录头(低16位长度,高16位类型) + 数据(4字节对齐).
+  * 记录放不下缓存尾部时写一个填充记录(IPC_REC_TYPE_PAD)后回到缓存头部.
+  * 本模块不依赖HAL, 可以在主机上用两个线程代替两个核进行测试.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IPC_RING_H__
+#define __IPC_RING_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined ( __ICCARM__ ) || defined ( __CC_ARM ) || defined ( __ARMCC_VERSION ) || defined ( __arm__ )
+#include "cmsis_compiler.h"
+#define IPC_DMB()              __DMB()                 // 数据存储器屏障,保证另一个核看到的写顺序
+#else
+#define IPC_DMB()              __sync_synchronize()    // 主机测试
+#endif
+
+#define IPC_CACHE_LINE         (32U)                   // CM7 D-Cache行长度
+#define IPC_REC_HDR_SIZE       (4U)                    // 记录头长度
+#define IPC_REC_TYPE_PAD       (0xFFFFU)               // 填充记录, 消费者直接跳到缓存头部
+#define IPC_REC_LEN_MAX        (0xFFFFU)               // 单条记录最大数据长度
+#define IPC_REC_ALIGN(len)     (((uint32_t)(len) + 3U) & ~3U)
+
+typedef struct _IPC_Ring_ {
+    volatile uint32_t u32Head;                         // 写索引(自由增长), 只由生产者修改
+    volatile uint32_t u32Drops;                        // 缓存满丢弃的记录数, 只由生产者修改
+    uint8_t  au8Pad0[IPC_CACHE_LINE - 2 * sizeof(uint32_t)];
+    volatile uint32_t u32Tail;                         // 读索引(自由增长), 只由消费者修改
+    uint8_t  au8Pad1[IPC_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t u32Size;                                  // 数据区长度, 2的整数次幂
+    uint8_t  *pu8Data;                                 // 数据区地址, 两个核看到的地址相同
+    uint8_t  au8Pad2[IPC_CACHE_LINE - sizeof(uint32_t) - sizeof(uint8_t *)];
+} IPC_Ring_t;
+
+
+void IPC_RingInit(IPC_Ring_t *pRing, uint8_t *pu8Buff, uint32_t u32Size);
+bool IPC_bRingWrite(IPC_Ring_t *pRing, uint16_t u16Type, const void *pData, uint16_t u16Len);
+int32_t IPC_s32RingRead(IPC_Ring_t *pRing, uint16_t *pu16Type, void *pData, uint16_t u16MaxLen);
+uint32_t IPC_u32RingFree(const IPC_Ring_t *pRing);
+bool IPC_bRingEmpty(const IPC_Ring_t *pRing);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __IPC_RING_H__ */
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    ipc_rpc.h
+  * @author  Drive FW team
+  * @brief   Header file of remote procedure call from CM7 to CM4
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * CM7是客户端, CM4是服务端, 请求和应答各用一个SRAM4中的环形缓存(stRpcReq/stRpcRsp).
+  * 每次调用分配一个调用号, 应答按调用号找到回调, 可以同时有IPC_RPC_PENDING_MAX个调用没有完成,
+  * 再调用返回IPC_RPC_EBUSY, 调用者用IPC_bRpcWaitSlot等一个调用完成后重试.
+  * 应答缓存满时服务端阻塞等待, 客户端取走应答后敲门铃(IPC_CH_RPC)唤醒它.
+  * 回调在CM7的IPC_RpcClientTask中执行, 服务函数在CM4的IPC_RpcServerTask中执行.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IPC_RPC_H__
+#define __IPC_RPC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IPC_RPC_ARG_MAX        (256U)                  // 参数/结果最大长度
+#define IPC_RPC_PENDING_MAX    (16U)                   // 最多未完成的调用数
+#define IPC_RPC_FUNC_MAX       (16U)                   // 函数表长度
+#define IPC_RPC_POLL_MS        (10U)                   // 客户端检查超时的周期
+
+// 函数号
+#define IPC_RPC_FN_ECHO        (0U)                    // 原样返回参数
+#define IPC_RPC_FN_FIR         (1U)                    // int16采样滑动平均滤波
+
+// 状态
+#define IPC_RPC_OK             (0)
+#define IPC_RPC_ENOFUNC        (-1)                    // 函数号没有注册
+#define IPC_RPC_EARG           (-2)                    // 参数错误
+#define IPC_RPC_ETIMEOUT       (-3)                    // 超时没有应答
+#define IPC_RPC_EBUSY          (-4)                    // 调用记录用完或请求缓存满, 稍后重试
+
+typedef struct _IPC_RpcHdr_ {
+    uint32_t u32CallId;
+    uint16_t u16Func;
+    int16_t  s16Status;                                // 请求中不使用
+} IPC_RpcHdr_t;
+
+// 服务函数: 返回状态, 结果写到pRes, 长度写到pu16ResLen(最大IPC_RPC_ARG_MAX)
+typedef int16_t (*IPC_RpcFunc_t)(const void *pArgs, uint16_t u16Len, void *pRes, uint16_t *pu16ResLen);
+// 完成回调: pRes只在回调里有效
+typedef void (*IPC_RpcDone_t)(uint32_t u32CallId, int16_t s16Status, const void *pRes, uint16_t u16Len, void *pArg);
+
+
+#if defined (CORE_CM4)
+bool IPC_bRpcRegister(uint16_t u16Func, IPC_RpcFunc_t pfFunc);
+void IPC_RpcServerTask(void *pvParameters);
+#else
+int16_t IPC_s16RpcCall(uint16_t u16Func, const void *pArgs, uint16_t u16Len,
+                       IPC_RpcDone_t pfDone, void *pArg, uint32_t u32TimeoutMs, uint32_t *pu32CallId);
+#if defined ( INC_TASK_H )
+bool IPC_bRpcWaitSlot(TickType_t xTicksToWait);
+#endif
+void IPC_RpcClientTask(void *pvParameters);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __IPC_RPC_H__ */
@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file    ipc_stream.h
+  * @author  Drive FW team
+  * @brief   Header file of named FreeRTOS message buffer channels between CM7 and CM4
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 通道的message buffer控制块和数据区都在SRAM4(静态分配), 由CM7在释放CM4之前创建,
+  * 通道表也放在SRAM4, 两个核用IPC_xStreamFind()按名字得到同一个句柄.
+  * sbSEND_COMPLETED/sbRECEIVE_COMPLETED和它们的中断版本(ipc_msgbuf.h)通过门铃(IPC_CH_STREAM)通知对方核,
+  * 对方核在中断里调用xMessageBufferSendCompletedFromISR/ReceiveCompletedFromISR.
+  * 注意:
+  *  1. 两个核的FreeRTOS版本和配置必须一致(StreamBuffer_t结构相同);
+  *  2. 每个通道只有一个发送者和一个接收者(任务或中断).
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IPC_STREAM_H__
+#define __IPC_STREAM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "message_buffer.h"
+
+#define IPC_STREAM_MAX         (8U)                    // 最多通道数
+#define IPC_STREAM_NAME_LEN    (16U)                   // 通道名长度(包含结束符)
+#define IPC_STREAM_MAGIC       (0x5354524DU)           // "STRM", 通道表创建完成标志
+
+#define IPC_STREAM_TO_CM7      (7U)                    // 接收方是CM7
+#define IPC_STREAM_TO_CM4      (4U)                    // 接收方是CM4
+
+// 通道名
+#define IPC_STREAM_CMD         "cmd7to4"
+#define IPC_STREAM_DATA        "data4to7"
+#define IPC_STREAM_BENCH_TX    "bench7to4"             // ampbench: CM7发送, CM4回送
+#define IPC_STREAM_BENCH_RX    "bench4to7"
+#define IPC_BENCH_MSG_MAX      (4096U)                 // ampbench最大消息长度
+
+typedef struct _IPC_StreamEntry_ {
+    char     acName[IPC_STREAM_NAME_LEN];
+    MessageBufferHandle_t xBuff;
+    uint32_t u32Size;                                  // 数据区长度
+    uint8_t  u8RxCore;                                 // IPC_STREAM_TO_CM7/IPC_STREAM_TO_CM4
+} IPC_StreamEntry_t;
+
+
+bool IPC_bStreamInit(void);
+MessageBufferHandle_t IPC_xStreamFind(const char *pcName);
+const IPC_StreamEntry_t *IPC_pStreamEntry(uint8_t u8Index);
+
+#if defined (CORE_CM4)
+void AMP_BenchEchoTask(void *pvParameters);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __IPC_STREAM_H__ */
@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    modbus.h
+  * @author  Drive FW team
+  * @brief   Header file of Modbus RTU slave engine
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 分帧由UART的接收超时(3.5个字符时间)完成, 本模块只处理一个完整的帧:
+  * 检查地址和CRC, 查寄存器表, 把应答直接写到DMA发送缓存里.
+  * 寄存器表按地址升序排列, 每一项是一段连续的寄存器, 可以直接映射到RAM数组,
+  * 也可以用读写回调(例如只读的状态量).
+  * 支持的功能码: 0x03 读保持寄存器, 0x04 读输入寄存器, 0x06 写单个寄存器, 0x10 写多个寄存器.
+  *
+  * 协议处理部分不依赖HAL和RTOS, 主机测试时定义MB_HOST.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MODBUS_H__
+#define __MODBUS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MB_ADU_MAX              (256U)          // RTU帧最大长度(地址+PDU+CRC)
+#define MB_ADU_MIN              (4U)            // 地址 + 功能码 + CRC
+#define MB_ADDR_BROADCAST       (0U)
+#define MB_T35_CHAR10           (35U)           // 帧间隔3.5个字符, 按通道的字符格式换算成位数
+// 协议规定波特率高于19200时帧间隔固定为1.75ms: 115200时是202个位时间, 比3.5个字符(39位)长得多,
+// 应答最早在最后一个字节之后1.75ms开始, 低延时的目标在高波特率下达不到.
+// 主站的字符间隔足够小时可以定义为0, 只用3.5个字符
+#ifndef MB_T35_MIN_US
+#define MB_T35_MIN_US           (1750U)
+#endif
+
+// 功能码
+#define MB_FC_READ_HOLDING      (0x03U)
+#define MB_FC_READ_INPUT        (0x04U)
+#define MB_FC_WRITE_SINGLE      (0x06U)
+#define MB_FC_WRITE_MULTIPLE    (0x10U)
+
+// 异常码
+#define MB_EX_NONE              (0x00U)
+#define MB_EX_ILLEGAL_FUNCTION  (0x01U)
+#define MB_EX_ILLEGAL_ADDRESS   (0x02U)
+#define MB_EX_ILLEGAL_VALUE     (0x03U)
+#define MB_EX_DEVICE_FAILURE    (0x04U)
+
+typedef uint8_t (*MB_RegRead_t)(uint16_t u16Addr, uint16_t *pu16Val);   // 返回异常码
+typedef uint8_t (*MB_RegWrite_t)(uint16_t u16Addr, uint16_t u16Val);
+
+typedef struct _MB_Reg_ {
+    uint16_t u16Addr;                           // 起始地址
+    uint16_t u16Num;                            // 寄存器个数
+    uint16_t *pu16Data;                         // 直接映射的RAM数组, NULL时使用回调
+    MB_RegRead_t pfRead;
+    MB_RegWrite_t pfWrite;                      // pu16Data和pfWrite都为NULL时只读
+} MB_Reg_t;
+
+typedef struct _MB_Map_ {
+    const MB_Reg_t *pstHolding;                 // 保持寄存器表, 按地址升序
+    uint16_t u16HoldingNum;
+    const MB_Reg_t *pstInput;                   // 输入寄存器表, 按地址升序
+    uint16_t u16InputNum;
+} MB_Map_t;
+
+typedef struct _MB_Stat_ {
+    uint32_t u32Frames;                         // 收到的帧数
+    uint32_t u32CrcErrors;                      // CRC错误或长度错误的帧数
+    uint32_t u32Exceptions;                     // 回复的异常应答数
+    uint32_t u32Responses;                      // 回复的应答数(包括异常应答)
+    uint32_t u32Ignored;                        // 不是发给本站的帧数
+} MB_Stat_t;
+
+typedef struct _MB_Latency_ {
+    uint32_t u32Count;                          // 统计的应答数
+    uint32_t u32LastUs;                         // 请求的最后一个字节到应答开始发送, 单位us, 包括帧间隔
+    uint32_t u32AvgUs;                          // 指数平均(1/8)
+    uint32_t u32MaxUs;
+    uint32_t u32GapUs;                          // 其中的帧间隔(接收超时), 由波特率决定
+} MB_Latency_t;
+
+typedef struct _MB_Slave_ {
+    uint8_t u8Addr;                             // 从站地址 1~247
+    const MB_Map_t *pMap;
+    MB_Stat_t stStat;
+} MB_Slave_t;
+
+
+uint16_t MB_u16Crc(const uint8_t *pu8Data, uint32_t u32Len);
+uint32_t MB_u32Process(MB_Slave_t *pSlave, const uint8_t *pu8Req, uint32_t u32ReqLen, uint8_t *pu8Rsp);
+
+#if !defined (MB_HOST)
+// RTOS: UART8上的从站任务
+void MB_Task(void *pvParameters);
+const MB_Latency_t *MB_pLatency(void);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __MODBUS_H__ */
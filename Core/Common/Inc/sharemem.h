@@ -9,6 +9,16 @@
   * Copyright (C) 2023 Schneider-Electric.
   * All rights reserved.
   *
+  * 共享内存放在SRAM4, CM7侧由MPU配置为Non-cacheable/Shareable.
+  * 每个方向一个SPSC环形缓存(ipc_ring), CM7在释放CM4之前调用ShareMemInit().
+  * 大块数据用借出/归还接口(SHM_bBorrow...), 直接在SRAM4里读写, 不需要拷贝:
+  *   生产者: SHM_bBorrow -> 写pu8Data -> SHM_bCommit (不发送或提交失败时用SHM_bCancel归还)
+  *   消费者: SHM_bAcquire -> 读pu8Data -> SHM_bRelease
+  * 每个方向同一个核内只允许一个任务生产, 一个任务消费.
+  * 发送和提交之后会通知对方核(IPC_CH_MAILBOX/IPC_CH_LEND), 消费者不需要轮询.
+  * IPC_CH_LEND/IPC_CH_MAILBOX的消费者: CM4的AMP_ShmEchoTask, CM7上shmbench运行期间的测试任务(ipc_bench.c);
+  * CM4上环形缓存只有这一个消费者, 不要再调用ReadM7Data.
+  * 主机测试时定义SHM_HOST, 借出/提交和取得/归还用同一个块池(Tools/ipc_frame_test.c).
   *
   ******************************************************************************
   */
@@ -21,18 +31,119 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "ipc_ring.h"
+#include "ipc_notify.h"
+#include "telemetry.h"
 
+// SRAM4:   0x38000000 <----> 0x3800FFFF 64kByte
+// SRAM3:   0x30040000 <----> 0x30047FFF 32kByte
+// SRAM2:   0x30020000 <----> 0x3003FFFF 128kByte
+// SRAM1:   0x30000000 <----> 0x3001FFFF 128kByte
+// AXI RAM: 0x24000000 <----> 0x2407FFFF 512kByte
+#define SHARE_MEM_START     (0x38000000)
+#define SHARE_MEM_SIZE      (0x10000)
+#define SHARE_MEM_MAGIC     (0x53484D31U)               // "SHM1", CM7初始化完成标志
 
+#define SHM_RING_SIZE       (4096U)                     // 每个方向的环形缓存长度, 2的整数次幂
+#define SHM_RPC_RING_SIZE   (4096U)                     // ipc_rpc请求/应答环形缓存长度, 2的整数次幂
+#define M4_U32DATA_NUM      (64)
+#define M7_U32DATA_NUM      (64)
 
+#define SHM_LEND_SLOTS      (16U)                       // 每个方向可借出的缓存块数
+#define SHM_LEND_SLOT_SIZE  (512U)                      // 缓存块长度, 32字节的整数倍
+#define SHM_LEND_QSIZE      (256U)                      // 已提交块号队列长度, 2的整数次幂
+#define SHM_STREAM_SIZE     (28U * 1024U)               // ipc_stream通道表和message buffer
 
+// 1: 用代号检查过期的借用指针; 默认只在调试版本(工程里定义DEBUG)打开, 发布版本不检查
+#ifndef SHM_LEND_CHECK
+#ifdef DEBUG
+#define SHM_LEND_CHECK      (1)
+#else
+#define SHM_LEND_CHECK      (0)
+#endif
+#endif
+
+// 记录类型, IPC_REC_TYPE_PAD保留
+#define SHM_TYPE_RAW        (0x0001U)                   // 兼容原来的64字数据帧
+#define SHM_TYPE_LEND       (0x0002U)                   // 借用块提交记录, 只在块号队列中使用
+#define SHM_TYPE_ECHO       (0x0003U)                   // shmbench的环形缓存记录, CM4原样送回
+
+// 借用块的状态, 生产者: FREE->BORROWED->READY, 消费者: READY->ACQUIRED->FREE
+#define SHM_SLOT_FREE       (0U)
+#define SHM_SLOT_BORROWED   (1U)
+#define SHM_SLOT_READY      (2U)
+#define SHM_SLOT_ACQUIRED   (3U)
+
+typedef struct _SHM_Lend_ {
+    uint8_t  *pu8Data;                                  // 块地址, 在SRAM4中
+    uint16_t u16Size;                                   // 借出时为块容量, 取得时为有效数据长度
+    uint16_t u16Slot;                                   // 块号
+    uint32_t u32Gen;                                    // 借出时块的代号, 每次归还加1
+} SHM_Lend_t;
+
+typedef struct _SHM_LendPool_ {
+    IPC_Ring_t stQueue;                                 // 已提交的块号, 按提交顺序交给消费者
+    uint8_t  au8Queue[SHM_LEND_QSIZE];
+    volatile uint8_t  au8State[SHM_LEND_SLOTS];
+    volatile uint32_t au32Gen[SHM_LEND_SLOTS];
+    volatile uint32_t u32GenErr;                        // 检测到的过期指针次数
+    uint8_t  au8Pad0[IPC_CACHE_LINE - ((SHM_LEND_SLOTS * 5U + 4U) % IPC_CACHE_LINE)];
+    uint8_t  au8Slot[SHM_LEND_SLOTS][SHM_LEND_SLOT_SIZE];
+} SHM_LendPool_t;
 
 
+typedef struct _MEM_Shared_Data_ {
+    volatile uint32_t u32Magic;                         // SHARE_MEM_MAGIC: 环形缓存已初始化
+    uint8_t  au8Pad0[IPC_CACHE_LINE - sizeof(uint32_t)];
+    IPC_Ring_t stRing4to7;                              // CM4 -> CM7
+    IPC_Ring_t stRing7to4;                              // CM7 -> CM4
+    uint8_t  au8Data4to7[SHM_RING_SIZE];
+    uint8_t  au8Data7to4[SHM_RING_SIZE];
+    SHM_LendPool_t stLend4to7;                          // CM4生产, CM7消费
+    SHM_LendPool_t stLend7to4;                          // CM7生产, CM4消费
+    IPC_NotifyBits_t stNotify4to7;                      // CM4 -> CM7 门铃通知
+    IPC_NotifyBits_t stNotify7to4;                      // CM7 -> CM4 门铃通知
+    uint8_t  au8Stream[SHM_STREAM_SIZE];                // 由ipc_stream.c分配
+    TLM_Block_t astTlm[TLM_CORE_NUM];                   // 遥测快照, 每个核一块
+    uint8_t  au8Pad1[IPC_CACHE_LINE - ((TLM_CORE_NUM * sizeof(TLM_Block_t)) % IPC_CACHE_LINE)];
+    IPC_Ring_t stRpcReq;                                // ipc_rpc请求 CM7 -> CM4
+    IPC_Ring_t stRpcRsp;                                // ipc_rpc应答 CM4 -> CM7
+    uint8_t  au8RpcReq[SHM_RPC_RING_SIZE];
+    uint8_t  au8RpcRsp[SHM_RPC_RING_SIZE];
+} MEM_Shared_Data_t;
 
 
+extern MEM_Shared_Data_t *const pShareData;
+
+bool ShareMem_bIsReady(void);
+
+// 本核发送方向借出/提交, 本核接收方向取得/归还
+bool SHM_bBorrow(SHM_Lend_t *pLend);
+bool SHM_bCommit(SHM_Lend_t *pLend, uint16_t u16Len);
+bool SHM_bCancel(SHM_Lend_t *pLend);
+bool SHM_bAcquire(SHM_Lend_t *pLend);
+bool SHM_bRelease(SHM_Lend_t *pLend);
+
+#if defined (CORE_CM4)
+bool ShareMem_bSend(uint16_t u16Type, const void *pData, uint16_t u16Len);          // CM4 -> CM7
+int32_t ShareMem_s32Receive(uint16_t *pu16Type, void *pData, uint16_t u16MaxLen);  // CM7 -> CM4
+bool WriteM4Data(uint32_t *dataBuff);
+uint32_t *ReadM7Data(void);
+void AMP_ShmEchoTask(void *pvParameters);                                           // ipc_bench.c, shmbench的回送任务
+#else
+void ShareMemInit(void);
+bool ShareMem_bSend(uint16_t u16Type, const void *pData, uint16_t u16Len);          // CM7 -> CM4
+int32_t ShareMem_s32Receive(uint16_t *pu16Type, void *pData, uint16_t u16MaxLen);  // CM4 -> CM7
+bool WriteM7Data(uint32_t *dataBuff);
+uint32_t *getM4Data(void);
+#endif
+
 
 #ifdef __cplusplus
 }
 #endif
 
 
-#endif /* __SHAREMEM_H__ */
\ No newline at end of file
+#endif /* __SHAREMEM_H__ */
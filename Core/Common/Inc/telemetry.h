@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file    telemetry.h
+  * @author  Drive FW team
+  * @brief   Header file of seqlock telemetry snapshot in share memery
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 每个核在SRAM4里有一个遥测块, 只由本核的TLM_Task周期写入(TLM_PERIOD_MS).
+  * 写: u32Seq加1(奇数) -> 写数据 -> u32Seq加1(偶数); 读: 前后两次u32Seq相同且为偶数才有效.
+  * 读的一方不加锁, 也不会阻塞写的一方, 两个核和shell都可以读.
+  *
+  * TLM_Write/TLM_bRead不依赖RTOS, 主机测试时定义TLM_HOST.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TLM_PERIOD_MS          (100U)                  // 发布周期
+#define TLM_TASK_MAX           (16U)                  // CM7约10个任务, 超过的不发布, 见u8TaskTotal
+#define TLM_QUEUE_MAX          (4U)
+#define TLM_NAME_LEN           (8U)
+#define TLM_READ_RETRY         (16U)                   // 读到写了一半的数据时的重试次数
+#define TLM_LOAD_UNKNOWN       (0xFFFFU)               // 没有使能运行时间统计
+#define TLM_UART_ERR_NUM       (5U)                    // 串口错误类别: 校验/噪声/帧/溢出/DMA
+
+#define TLM_CORE_CM7           (0U)
+#define TLM_CORE_CM4           (1U)
+#define TLM_CORE_NUM           (2U)
+
+typedef struct _TLM_Data_ {
+    uint32_t u32Publish;                               // 发布次数
+    uint32_t u32TaskTotal;                             // 本核的任务总数, 大于u8TaskNum表示任务列表被截断
+    uint32_t u32UpTime;                                // 系统tick
+    uint16_t u16CpuLoad;                               // CPU占用率, 单位0.01%
+    uint8_t  u8TaskNum;                                // 发布的任务数
+    uint8_t  u8QueueNum;
+    uint32_t u32UartErr;                               // 串口错误次数
+    uint32_t u32IpcDrops;                              // 共享内存发送丢弃次数
+    uint32_t u32HeapFree;                              // 堆剩余
+    uint32_t u32RspCount;                              // 串口协议(Modbus)应答数, 没有协议时为0
+    uint32_t u32RspLatAvgUs;                           // 请求的最后一个字节到应答开始发送的时间(包括帧间隔), 单位us
+    uint32_t u32RspLatMaxUs;
+    uint32_t u32UartRxBytes;                           // 本核协议串口(CM7: USART1, CM4: UART8)的统计
+    uint32_t u32UartTxBytes;
+    uint32_t u32UartRxFrames;
+    uint32_t u32UartTxFrames;
+    uint32_t u32UartLost;                              // 接收缓存被覆盖 + 帧队列满丢弃的帧
+    uint16_t au16UartErr[TLM_UART_ERR_NUM];            // 按类别的错误次数
+    uint16_t u16UartRestarts;                          // 接收DMA重新启动次数
+    uint16_t u16UartIsrMaxUs;                          // 中断处理函数的最长执行时间(不含响应延迟)
+    uint16_t u16UartTxqHigh;                           // 发送队列深度的最大值
+    char     acTask[TLM_TASK_MAX][TLM_NAME_LEN];
+    uint16_t au16StackFree[TLM_TASK_MAX];              // 任务堆栈剩余最小值, 单位word
+    char     acQueue[TLM_QUEUE_MAX][TLM_NAME_LEN];
+    uint16_t au16QueueUsed[TLM_QUEUE_MAX];             // 队列中的消息数, 或缓存中的字节数(TLM_bAddLevel)
+} TLM_Data_t;
+
+typedef struct _TLM_Block_ {
+    volatile uint32_t u32Seq;                          // 奇数: 正在写
+    TLM_Data_t stData;
+} TLM_Block_t;
+
+typedef uint32_t (*TLM_Level_t)(void);                 // 返回缓存的当前占用量
+
+
+void TLM_Write(TLM_Block_t *pBlock, const TLM_Data_t *pData);
+bool TLM_bRead(const TLM_Block_t *pBlock, TLM_Data_t *pData);
+bool TLM_bSnapshot(uint8_t u8Core, TLM_Data_t *pData);
+
+#if !defined (TLM_HOST)
+// 依赖FreeRTOS的部分
+void TLM_Task(void *pvParameters);
+bool TLM_bAddLevel(const char *pcName, TLM_Level_t pfLevel);
+#if defined ( QUEUE_H )
+bool TLM_bAddQueue(const char *pcName, QueueHandle_t xQueue);
+#endif
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __TELEMETRY_H__ */
@@ -0,0 +1,188 @@
+/**
+  ******************************************************************************
+  * @file    uart_drv.h
+  * @author  Drive FW team
+  * @brief   Header file of multi-instance UART channel driver
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 每个UART口一个通道对象(UartDrv_t), 里面放接收环形缓存、发送描述符队列、
+  * 统计和回调, 不再使用文件内的全局变量, 几个口可以同时以DMA全速工作.
+  * 接收: 循环DMA一直不停, DMA半满/全满/空闲事件时更新写索引, 读的一方直接在缓存里读.
+  * 发送: 生产者只放入缓存地址, 发送完成中断里直接启动下一个描述符.
+  * HAL的回调函数(HAL_UARTEx_RxEventCallback等)在本模块里实现, 按句柄查表分发到通道.
+  *
+  * 需要按帧间隔分帧的协议(Modbus RTU)可以再使能接收超时(RTO): 超时中断在HAL之前处理,
+  * 不会停止DMA, 只记录帧结束时的写索引并调用帧回调. 超时按字符数(和最小时间)给出,
+  * 由通道配置的波特率和字符格式换算成位数.
+  *
+  * 不分帧的通道(shell)可以使能自适应接收事件: 平均突发长度短时用空闲线事件(延时1个字符),
+  * 长时(批量传输)关闭空闲线中断, 数据由DMA半满/全满事件按半个缓存送出, 突发结束用较长的
+  * 接收超时, 减少每字节的中断数.
+  *
+  * 主机测试时定义UART_DRV_HOST, 通道的底层换成伪终端(pty)的文件描述符,
+  * 由UartDrv_HostPoll()模拟DMA接收和发送完成中断.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_DRV_H__
+#define __UART_DRV_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined (UART_DRV_HOST)
+typedef struct _UartDrv_Port_ {
+    int s32Fd;                                  // 伪终端主设备的文件描述符
+    uint32_t u32Baud;                           // 用于超时换算, 0: 115200(8N1)
+} UartDrv_Port_t;
+#else
+#include "main.h"
+typedef UART_HandleTypeDef UartDrv_Port_t;
+#endif
+
+#define UART_DRV_NUM        (4U)                // 最多注册的通道个数
+#define UART_DRV_TXQ_DEPTH  (8U)                // 发送描述符队列深度
+#define UART_DRV_FRAMEQ_DEPTH (4U)              // 接收超时分帧时, 等待读取的帧个数, 2的整数次幂
+#define UART_DRV_BULK_CHAR10  (80U)             // 批量模式的突发结束超时: 8个字符,
+#define UART_DRV_BULK_MIN_US  (1000U)           // 且不少于1ms, 跨过USB转串口的包间隔
+
+// 接收错误类别, UartDrv_ErrorFromISR()的参数, 可以同时有几个; 数值和HAL_UART_ERROR_xx相同
+#define UART_DRV_ERR_PARITY   (0x01U)
+#define UART_DRV_ERR_NOISE    (0x02U)
+#define UART_DRV_ERR_FRAMING  (0x04U)
+#define UART_DRV_ERR_OVERRUN  (0x08U)
+#define UART_DRV_ERR_DMA      (0x10U)
+
+struct _UartDrv_;
+
+typedef void (*Uart_TxDone_t)(void *pArg);                     // 发送完成回调, 在中断里调用
+typedef void (*UartDrv_RxNotify_t)(struct _UartDrv_ *pDrv);    // 有新数据/帧结束, 在中断里调用
+
+typedef struct _UartDrv_TxDesc_ {
+    const uint8_t *pu8Data;
+    uint32_t u32Len;
+    Uart_TxDone_t pfDone;                       // 可以为NULL
+    void *pArg;
+} UartDrv_TxDesc_t;
+
+typedef struct _UartDrv_Frame_ {
+    uint32_t u32End;                            // 帧结束时的写索引
+    uint32_t u32Stamp;                          // 帧结束(接收超时中断)时的DWT周期计数
+} UartDrv_Frame_t;
+
+typedef struct _UartDrv_Stat_ {
+    uint32_t u32RxBytes;                        // DMA接收的字节数
+    uint32_t u32RxEvents;                       // 接收事件(中断)次数, 和u32RxBytes一起看每字节的中断数
+    uint32_t u32RxModeSwitch;                   // 自适应接收在空闲线/批量模式之间切换的次数
+    uint32_t u32RxStale;                        // 过期的全满事件(数据已经由回绕后的接收超时/空闲线事件计入)
+    uint32_t u32TxBytes;                        // 发送完成的字节数
+    uint32_t u32RxFrames;                       // 接收超时分帧得到的帧数
+    uint32_t u32TxFrames;                       // 发送完成的描述符个数
+    uint32_t u32RxLost;                         // 来不及读被覆盖(或重新启动时丢弃)的次数
+    uint32_t u32FrameDrops;                     // 帧队列满被合并(由协议层丢弃)的帧数
+    uint32_t u32Errors;                         // 接收错误次数(下面各类错误的总和)
+    uint32_t u32ErrParity;
+    uint32_t u32ErrNoise;
+    uint32_t u32ErrFraming;
+    uint32_t u32ErrOverrun;                     // 硬件溢出检测已关闭, 是DMA覆盖了未读数据的次数
+    uint32_t u32ErrDma;
+    uint32_t u32RxRestarts;                     // 接收DMA被停止后重新启动的次数
+    uint32_t u32TxFull;                         // 发送队列满被拒绝的次数
+    uint32_t u32TxqHigh;                        // 发送队列深度的最大值
+    uint32_t u32IsrMaxCycles;                   // 中断处理函数的最长执行时间(不含响应延迟), 单位DWT周期(主机测试时为0)
+} UartDrv_Stat_t;
+
+typedef struct _UartDrv_ {
+    const char *pName;
+    UartDrv_Port_t *pPort;                      // HAL句柄(主机测试时是pty)
+
+    // 接收环形缓存, 长度是2的整数次幂且是32字节的整数倍, DMA访问的缓存要32字节对齐
+    uint8_t *pu8RxBuff;
+    uint32_t u32RxSize;
+    volatile uint32_t u32RxHead;                // 写索引(自由增长), 只在接收事件中断里修改
+    uint32_t u32RxTail;                         // 读索引(自由增长), 只由读的一方修改
+    uint16_t u16RxLastPos;                      // 上次接收事件时DMA在缓存里的位置
+    uint32_t u32RxStart;                        // 最近一次启动接收时的写索引
+    volatile uint8_t u8RxResync;                // 接收被重新启动过, 读的一方丢弃u32RxStart之前未读的数据
+    volatile uint8_t u8Listen;                  // 循环接收已启动
+    UartDrv_RxNotify_t pfRxNotify;
+    void *pRxArg;
+    // 接收超时(帧间隔)分帧: 中断里记录每一帧的结束位置, 读的一方处理上一帧时下一帧可以继续接收
+    UartDrv_Frame_t astRxFrame[UART_DRV_FRAMEQ_DEPTH];
+    volatile uint32_t u32RxFrameIn;             // 只在中断里修改
+    uint32_t u32RxFrameOut;                     // 只由读的一方修改
+    UartDrv_RxNotify_t pfRxFrame;               // 接收超时回调, 没有使能接收超时时为NULL
+    uint32_t u32RtoBits;                        // 接收超时(位), 0: 没有使能
+    // 自适应接收事件, 只用于没有使能接收超时分帧的通道
+    uint8_t u8RxAdapt;
+    volatile uint8_t u8RxBulk;                  // 当前是批量模式(接收超时代替空闲线事件)
+    uint32_t u32RxBurstHead;                    // 上一个突发结束时的写索引
+    uint32_t u32RxBurstAvg;                     // 突发长度(字节)的滑动平均
+
+    // 发送描述符队列
+    UartDrv_TxDesc_t astTxQ[UART_DRV_TXQ_DEPTH];
+    volatile uint32_t u32TxHead;                // 放入位置(自由增长)
+    volatile uint32_t u32TxTail;                // 正在发送/下一个要发送的位置(自由增长)
+    volatile uint8_t u8TxBusy;                  // 队首描述符已启动
+
+    UartDrv_Stat_t stStat;
+} UartDrv_t;
+
+
+bool UartDrv_bInit(UartDrv_t *pDrv, const char *pName, UartDrv_Port_t *pPort, uint8_t *pu8RxBuff, uint32_t u32RxSize);
+UartDrv_t *UartDrv_pFind(const UartDrv_Port_t *pPort);
+void UartDrv_SetRxNotify(UartDrv_t *pDrv, UartDrv_RxNotify_t pfNotify, void *pArg);
+uint32_t UartDrv_u32TimeoutBits(const UartDrv_t *pDrv, uint32_t u32Char10, uint32_t u32MinUs);
+bool UartDrv_bSetRxTimeout(UartDrv_t *pDrv, uint32_t u32Char10, uint32_t u32MinUs, UartDrv_RxNotify_t pfFrame);
+bool UartDrv_bSetRxAdaptive(UartDrv_t *pDrv, bool bEnable);
+uint32_t UartDrv_u32Num(void);
+UartDrv_t *UartDrv_pGet(uint32_t u32Index);
+void UartDrv_ClearStat(UartDrv_t *pDrv);
+
+// 接收
+bool UartDrv_bListen(UartDrv_t *pDrv);
+uint32_t UartDrv_u32RxPeek(UartDrv_t *pDrv, const uint8_t **ppData);
+void UartDrv_RxConsume(UartDrv_t *pDrv, uint32_t u32Len);
+uint32_t UartDrv_u32Read(UartDrv_t *pDrv, uint8_t *pu8Dst, uint32_t u32Max);
+bool UartDrv_bRxReady(const UartDrv_t *pDrv);
+uint32_t UartDrv_u32ReadFrame(UartDrv_t *pDrv, uint8_t *pu8Dst, uint32_t u32Max, uint32_t *pu32Stamp);
+bool UartDrv_bFrameReady(const UartDrv_t *pDrv);
+
+// 发送, 缓存在发送完成(pfDone被调用)之前不能修改; 任务和中断都可以调用
+bool UartDrv_bSend(UartDrv_t *pDrv, const uint8_t *pu8Data, uint32_t u32Len, Uart_TxDone_t pfDone, void *pArg);
+bool UartDrv_bTxKick(UartDrv_t *pDrv);
+uint32_t UartDrv_u32TxPending(const UartDrv_t *pDrv);
+
+// 底层事件, 由HAL回调(或主机测试的UartDrv_HostPoll)调用
+void UartDrv_RxEventFromISR(UartDrv_t *pDrv, uint16_t u16Pos);
+void UartDrv_RxIdleFromISR(UartDrv_t *pDrv, uint16_t u16Pos);
+void UartDrv_TxDoneFromISR(UartDrv_t *pDrv);
+void UartDrv_ErrorFromISR(UartDrv_t *pDrv, uint32_t u32ErrCode);
+void UartDrv_RxTimeoutFromISR(UartDrv_t *pDrv, uint16_t u16Pos);
+
+#if defined (UART_DRV_HOST)
+void UartDrv_HostPoll(UartDrv_t *pDrv);
+#else
+// 在UARTx_IRQHandler()里HAL_UART_IRQHandler()之前调用, 先处理接收超时和校验/帧/噪声错误
+void UartDrv_IRQHandler(UartDrv_t *pDrv);
+// 按HAL句柄发送(句柄要已经登记), 没有完成回调
+bool Uart_bSend_NonBlocking(UART_HandleTypeDef *hUARTx, uint8_t *pSrcAddr, uint32_t u32DataLen);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __UART_DRV_H__ */
@@ -0,0 +1,78 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "stm32h7xx_hal.h"
+#include "debug_printf.h"
+#include "binlog.h"
+
+
+// 打开DWT周期计数器作为时间戳, CPU主频计数(CM7 400MHz时约10.7秒回绕一次)
+void BLOG_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// 写一条日志, 任务和中断都可以调用
+// u32Nargs不包含格式字符串, 可变参数都是uint32_t(BLOG宏转换)
+// 调用处只拷贝记录, 不格式化; 文本模式下由打印任务展开(BLOG_u32Expand)
+void BLOG_Write(const char *pFmt, uint32_t u32Nargs, ...)
+{
+    va_list args;
+    uint8_t au8Rec[BLOG_REC_MAX];
+    uint32_t u32Val, i;
+    uint32_t u32Pos = 0U;
+
+    if (u32Nargs > BLOG_ARGS_MAX) {
+        u32Nargs = BLOG_ARGS_MAX;
+    }
+
+    au8Rec[u32Pos++] = BLOG_SYNC;
+    au8Rec[u32Pos++] = (uint8_t)u32Nargs;
+    u32Val = (uint32_t)pFmt;
+    memcpy(&au8Rec[u32Pos], &u32Val, sizeof(uint32_t));
+    u32Pos += sizeof(uint32_t);
+    u32Val = DWT->CYCCNT;
+    memcpy(&au8Rec[u32Pos], &u32Val, sizeof(uint32_t));
+    u32Pos += sizeof(uint32_t);
+
+    va_start(args, u32Nargs);
+    for (i = 0U; i < u32Nargs; i++) {
+        u32Val = va_arg(args, uint32_t);
+        memcpy(&au8Rec[u32Pos], &u32Val, sizeof(uint32_t));
+        u32Pos += sizeof(uint32_t);
+    }
+    va_end(args);
+
+    (void)LOG_bWrite((const char *)au8Rec, u32Pos);   // 整条记录一次写入, 不会和其他日志交错
+}
+
+// 把一条完整的记录展开成文本(不写时间戳), 返回文本长度; 超长时截断
+uint32_t BLOG_u32Expand(const uint8_t *pu8Rec, char *pBuff, uint32_t u32Size)
+{
+    uint32_t au32Arg[BLOG_ARGS_MAX] = {0U};
+    uint32_t u32Nargs = pu8Rec[1];
+    uint32_t u32Val, i;
+    int len;
+
+    if (u32Nargs > BLOG_ARGS_MAX) {
+        u32Nargs = BLOG_ARGS_MAX;
+    }
+    memcpy(&u32Val, &pu8Rec[2], sizeof(uint32_t));
+    for (i = 0U; i < u32Nargs; i++) {
+        memcpy(&au32Arg[i], &pu8Rec[BLOG_REC_LEN(i)], sizeof(uint32_t));
+    }
+
+    // 多余的参数被忽略
+    len = snprintf(pBuff, u32Size, (const char *)u32Val, au32Arg[0], au32Arg[1], au32Arg[2], au32Arg[3]);
+    if (len <= 0) {
+        return 0U;
+    }
+    return ((uint32_t)len < u32Size) ? (uint32_t)len : (u32Size - 1U);
+}
@@ -47,19 +47,19 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
         xResult = xEventGroupSetBitsFromISR(xEvent_eFlag, JOYSEL_EVENT, &xHigherPriorityTaskWoken);
     }
     else if ((GPIO_Pin & JOY1_DOWN_PIN) == JOY1_DOWN_PIN) {
-        printf2bufffromISR("JOY_DOWN Key Pressed\r\n");
+        LOGS(LOG_MOD_KEY, LOG_LVL_INFO, "JOY_DOWN Key Pressed\r\n");
     }
     else if ((GPIO_Pin & JOY1_LEFT_PIN) == JOY1_LEFT_PIN) {
-        printf2bufffromISR("JOY_LEFT Key Pressed\r\n");
+        LOGS(LOG_MOD_KEY, LOG_LVL_INFO, "JOY_LEFT Key Pressed\r\n");
     }
     else if ((GPIO_Pin & JOY1_RIGHT_PIN) == JOY1_RIGHT_PIN) {
-        printf2bufffromISR("JOY_RIGHT Key Pressed\r\n");
+        LOGS(LOG_MOD_KEY, LOG_LVL_INFO, "JOY_RIGHT Key Pressed\r\n");
     }
     else if ((GPIO_Pin & JOY1_UP_PIN) == JOY1_UP_PIN) {
-        printf2bufffromISR("JOY_UP Key Pressed\r\n");
+        LOGS(LOG_MOD_KEY, LOG_LVL_INFO, "JOY_UP Key Pressed\r\n");
     }
     else {
-        printf2bufffromISR("Key Press has something wrong\r\n");
+        LOGS(LOG_MOD_KEY, LOG_LVL_WARN, "Key Press has something wrong\r\n");
     }
 
     if (xResult == pdPASS) {
@@ -6,144 +6,531 @@
 #include <string.h>
 #include <stdbool.h>
 #include "FreeRTOS.h"	// FreeRTOS
-#include "semphr.h"		// FreeRTOS semaphore
+#include "task.h"		// FreeRTOS task
 #include "usart.h"
+#include "logjournal.h"           // 包含stdio.h, 要在debug_printf.h之前
+#include "debug_printf.h"
+#include "binlog.h"
 
 
 #define COM_SEND_TIMEOUT   pdMS_TO_TICKS(10) // 发送等待延时为10ms
 #define COM_SEMPHR_TIMEOUT pdMS_TO_TICKS(10) // 信号量等待延时为10ms
 #define ULONG_MAX 0xffffffffUL
 
-extern SemaphoreHandle_t xSemphr_Printf;
-extern SemaphoreHandle_t xMutex_Uart1;
-extern QueueHandle_t xQueue_Printf;
-extern QueueHandle_t xQueue_PB;
+// 日志环形缓存: 多个任务/中断可以同时写入(无锁), 打印任务用DMA直接发送缓存中的连续数据
+// u32LogState: [31:24]正在写的写者数, [23:0]已预留的写位置; 位置都是自由增长的24位计数
+#define LOG_RING_SIZE      (4096U)                   // 2的整数次幂, 32字节的整数倍
+#define LOG_SPAN_MAX       (PRINT_BSIZE)             // 一次DMA发送的最大长度
+#define LOG_SPAN_QUEUED    (2U)                      // 同时放在UART发送队列里的段数, 发送完一段马上发下一段
+#define LOG_POS_MASK       (0x00FFFFFFUL)
+#define LOG_NEST_ONE       (0x01000000UL)
 
-ALIGN_32BYTES(static char PrintBuff[PRINT_BSIZE]) = {0}; // 使用DMA，内存地址需要32字节对齐
+// 打印任务的通知位
+#define LOG_EVT_DATA       (0x0001UL)                // 有新的日志
+#define LOG_EVT_TXDONE     (0x0002UL)                // DMA发送完成
+#define LOG_RETRY_TICKS    pdMS_TO_TICKS(10)         // UART被占用(阻塞发送)时重试的间隔
 
-static bool isPrintTaskReady = false;
+// 每个模块的令牌桶限流: 信用按tick累加u16PerSec, 每条日志消耗configTICK_RATE_HZ
+typedef struct _LOG_Bucket_ {
+    uint16_t u16PerSec;                      // 每秒允许的日志条数, 0: 不限流
+    uint16_t u16Burst;                       // 允许连续突发的条数
+    uint32_t u32Credit;                      // 当前信用
+    TickType_t xLastTick;                    // 上次累加信用的tick
+    uint32_t u32Limited;                     // 被限流丢弃的条数
+} LOG_Bucket_t;
 
+extern TaskHandle_t PrintfTaskHandle;
 
-void debug_printf(const char *str)
+ALIGN_32BYTES(static uint8_t au8LogRing[LOG_RING_SIZE]) = {0}; // 使用DMA，内存地址需要32字节对齐
+
+static volatile uint32_t u32LogState = 0U;   // 写者数 + 预留位置
+static volatile uint32_t u32LogCommit = 0U;  // 已写完的位置, 打印任务只发送到这里
+static volatile uint32_t u32LogTail = 0U;    // 已发送完的位置, 只由打印任务修改
+static uint32_t u32LogSend = 0U;             // 已放入UART发送队列的位置, 只由打印任务修改
+static volatile uint32_t u32LogTxDone = 0U;  // 发送完成的段数, 只在发送完成中断里修改
+static volatile uint32_t u32LogDrops = 0U;   // 缓存满丢弃的字节数
+static uint32_t u32LogUrgent = 0U;           // 最近一条ERROR及以上日志的结束位置(不早于)
+static volatile bool bLogUrgent = false;     // u32LogUrgent之前的日志还没交给日志文件
+
+static volatile bool isPrintTaskReady = false;
+static volatile bool bLogHold = false;      // 暂停发送(串口被二进制传输占用), 日志留在缓存里
+
+#if (BLOG_BINARY_EN == 0)
+ALIGN_32BYTES(static char acLogText[LOG_SPAN_QUEUED][BLOG_TEXT_SIZE]);   // 二进制记录展开后的文本, 每个发送段一个
+#endif
+
+volatile uint8_t au8LogLevel[LOG_MOD_MAX] = {
+    LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT,
+    LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT,
+};
+
+static LOG_Bucket_t astLogBucket[LOG_MOD_MAX] = {
+    [LOG_MOD_KEY]  = {10U, 5U, 5U * configTICK_RATE_HZ, 0U, 0U},     // 按键中断, 抖动时会连续触发
+    [LOG_MOD_UART] = {20U, 10U, 10U * configTICK_RATE_HZ, 0U, 0U},   // 串口错误中断
+};
+
+static const char * const apcLogModName[LOG_MOD_MAX] = {
+    "sys", "task", "key", "uart", "ipc", "fs",
+};
+static const char * const apcLogLvlName[LOG_LVL_MAX] = {
+    "none", "err", "warn", "info", "debug",
+};
+
+
+// 比较并交换, 成功返回true
+static inline bool LOG_bCas(volatile uint32_t *pu32Addr, uint32_t u32Old, uint32_t u32New)
 {
-    int len = 0;
-    if ((str == NULL) || ((len = strlen(str)) == 0)) {
+    if (__LDREXW(pu32Addr) != u32Old) {
+        __CLREX();
+        return false;
+    }
+    return (__STREXW(u32New, pu32Addr) == 0U);
+}
+
+// 唤醒打印任务, 任务和中断都可以调用
+static void LOG_Kick(uint32_t u32Evt)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (!isPrintTaskReady) {                 // 打印任务运行前的日志, 任务运行后一起发送
         return;
     }
- 
-    HAL_UART_Transmit(&huart1, (const uint8_t *)str, len, COM_SEND_TIMEOUT);
+    if (__get_IPSR() != 0U) {
+        (void)xTaskNotifyFromISR(PrintfTaskHandle, u32Evt, eSetBits, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    } else {
+        (void)xTaskNotify(PrintfTaskHandle, u32Evt, eSetBits);
+    }
 }
 
-// 专门用于调试信息打印的任务
-// 由信号量触发调用
-void RTOS_DebugPrintTask(void)
+// 发布已写完的位置, 只会向前移动(被打断的写者可能后发布较小的位置)
+static void LOG_Publish(uint32_t u32Pos)
 {
-    isPrintTaskReady = true;
-    uint8_t strBuff[64] = {0};
-    uint32_t buffAddr = 0;
+    uint32_t u32Old;
 
-    while(1) {
-        if (0U == GetUart1TxStatus()) {
-            
-            // 其他任务往buff内写打印内容, 并通过信号量通知
-            if (pdTRUE == xSemaphoreTake(xSemphr_Printf, 0)) { //发送缓存有要发送的内容
-                //HAL_UART_Transmit(&huart1, (const uint8_t *)PrintBuff, strlen(PrintBuff), COM_SEND_TIMEOUT);
-                (void)Uart_bSend_NonBlocking(&huart1, (uint8_t *)PrintBuff, strlen(PrintBuff));
-            }
+    do {
+        u32Old = u32LogCommit;
+        if (((u32Pos - u32Old) & LOG_POS_MASK) > (LOG_POS_MASK >> 1)) {
+            return;
+        }
+    } while (!LOG_bCas(&u32LogCommit, u32Old, u32Pos));
+}
 
-            // 其他任务通过消息队列发送要打印的内容
-            else if (pdTRUE ==  xQueueReceive(xQueue_Printf, strBuff, 0)) {
-                (void)Uart_bSend_NonBlocking(&huart1, strBuff, strlen((char const *)strBuff));
-            }
+// 写入日志, 任务和中断都可以调用, 不阻塞
+// 返回值: false 缓存空间不足, 整条丢弃
+bool LOG_bWrite(const char *pStr, uint32_t u32Len)
+{
+    uint32_t u32Old, u32New, u32Pos, u32Off, u32First;
 
-            // 其他任务通过消息队列发送要打印的内容,消息值是缓存地址
-            else if (pdTRUE ==  xQueueReceive(xQueue_PB, &buffAddr, 0)) {
-                (void)Uart_bSend_NonBlocking(&huart1, (uint8_t *)buffAddr, strlen((char const *)buffAddr));
-            }
-            // 其他任务通过任务通知发送要打印的内容,通知值是缓存地址, 接收完退出前清除通知值
-            else if (pdTRUE ==  xTaskNotifyWait(0, ULONG_MAX, &buffAddr, 0)) {
-                (void)Uart_bSend_NonBlocking(&huart1, (uint8_t *)buffAddr, strlen((char const *)buffAddr));
-            }
+    if ((pStr == NULL) || (u32Len == 0U) || (u32Len > LOG_RING_SIZE)) {
+        return false;
+    }
 
-            vTaskDelay(50);
-        } else {
-            vTaskDelay(500);
-        }        
+    // 1.预留空间, 同时写者数加1
+    do {
+        u32Old = u32LogState;
+        u32Pos = u32Old & LOG_POS_MASK;
+        if ((((u32Pos - u32LogTail) & LOG_POS_MASK) + u32Len) > LOG_RING_SIZE) {
+            do {
+                u32New = u32LogDrops;
+            } while (!LOG_bCas(&u32LogDrops, u32New, u32New + u32Len));
+            return false;
+        }
+        u32New = ((u32Old & ~LOG_POS_MASK) + LOG_NEST_ONE) | ((u32Pos + u32Len) & LOG_POS_MASK);
+    } while (!LOG_bCas(&u32LogState, u32Old, u32New));
+
+    // 2.拷贝数据, 缓存尾部放不下时分两段
+    u32Off = u32Pos & (LOG_RING_SIZE - 1U);
+    u32First = LOG_RING_SIZE - u32Off;
+    if (u32First >= u32Len) {
+        memcpy(&au8LogRing[u32Off], pStr, u32Len);
+    } else {
+        memcpy(&au8LogRing[u32Off], pStr, u32First);
+        memcpy(au8LogRing, pStr + u32First, u32Len - u32First);
+    }
+    __DMB();
+
+    // 3.写者数减1, 最后一个写完的写者发布所有预留的数据
+    do {
+        u32Old = u32LogState;
+        u32New = u32Old - LOG_NEST_ONE;
+    } while (!LOG_bCas(&u32LogState, u32Old, u32New));
+    if ((u32New & ~LOG_POS_MASK) == 0U) {
+        LOG_Publish(u32New & LOG_POS_MASK);
+        LOG_Kick(LOG_EVT_DATA);
     }
+    return true;
 }
 
-// 把需要打印的字符串拷贝到打印缓存
-void printf2buff(char const *str)
+uint32_t LOG_u32Drops(void)
 {
-    if (isPrintTaskReady == false) {
-        return;
+    return u32LogDrops;
+}
+
+// 日志环形缓存里还没有发送完的字节数(包括正在写的), 遥测用
+uint32_t LOG_u32Used(void)
+{
+    return (u32LogState - u32LogTail) & LOG_POS_MASK;
+}
+
+// 限流检查, 任务和中断都可以调用; 返回false时这条日志应当丢弃
+bool LOG_bRateOk(LOG_Module_e eMod)
+{
+    LOG_Bucket_t *pBucket;
+    UBaseType_t uxSaved;
+    TickType_t xNow, xElapsed;
+    uint32_t u32Cap;
+    bool bOk;
+
+    if ((uint32_t)eMod >= LOG_MOD_MAX) {
+        return false;
+    }
+    pBucket = &astLogBucket[eMod];
+    if (pBucket->u16PerSec == 0U) {
+        return true;
     }
-    // 对字符串进行长度合法检查
 
-    // 成功释放信号量后进行拷贝
-    if (pdTRUE == xSemaphoreGive(xSemphr_Printf)) {
-        //strncpy(PrintBuff, str, strlen(str));
-        strcpy(PrintBuff, str);
-        xSemaphoreGive(xSemphr_Printf);
+    xNow = (__get_IPSR() != 0U) ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+    uxSaved = portSET_INTERRUPT_MASK_FROM_ISR();  // 任务里也可以用, 只屏蔽可管理的中断
+    xElapsed = xNow - pBucket->xLastTick;
+    if (xElapsed > 0xFFFFU) {
+        xElapsed = 0xFFFFU;                  // 乘以u16PerSec不会溢出
     }
+    pBucket->xLastTick = xNow;
+    u32Cap = (uint32_t)pBucket->u16Burst * configTICK_RATE_HZ;
+    pBucket->u32Credit += (uint32_t)xElapsed * pBucket->u16PerSec;
+    if (pBucket->u32Credit > u32Cap) {
+        pBucket->u32Credit = u32Cap;
+    }
+    bOk = (pBucket->u32Credit >= configTICK_RATE_HZ);
+    if (bOk) {
+        pBucket->u32Credit -= configTICK_RATE_HZ;
+    } else {
+        pBucket->u32Limited++;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(uxSaved);
+    return bOk;
 }
 
-// 把需要打印的字符串拷贝到打印缓存
-void nprintf2buff(char const *str, uint16_t len)
+// ERROR及以上的日志写入后调用(LOGS/LOGB), 日志文件收到这条日志后马上sync
+// 记下预留位置: 同时在写的其他日志可能也算进去, 只会多sync
+void LOG_MarkUrgent(void)
 {
-    if (isPrintTaskReady == false) {
-        return;
+    UBaseType_t uxSaved;
+
+    uxSaved = portSET_INTERRUPT_MASK_FROM_ISR();
+    u32LogUrgent = u32LogState & LOG_POS_MASK;
+    bLogUrgent = true;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(uxSaved);
+}
+
+// 打印任务释放到u32Pos时调用: 最近一条ERROR日志已经在释放的范围里, 返回true
+static bool LOG_bUrgentDone(uint32_t u32Pos)
+{
+    UBaseType_t uxSaved;
+    bool bDone = false;
+
+    if (!bLogUrgent) {
+        return false;
+    }
+    uxSaved = portSET_INTERRUPT_MASK_FROM_ISR();
+    if (bLogUrgent && (((u32Pos - u32LogUrgent) & LOG_POS_MASK) <= (LOG_POS_MASK >> 1))) {
+        bLogUrgent = false;
+        bDone = true;
     }
-    // 对字符串进行长度合法检查
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(uxSaved);
+    return bDone;
+}
 
-    // 成功释放信号量后进行拷贝
-    if (pdTRUE == xSemaphoreGive(xSemphr_Printf)) {
-        //strncpy(PrintBuff, str, strlen(str));
-        strncpy(PrintBuff, str, len);
-        PrintBuff[len] = '\0';
-        xSemaphoreGive(xSemphr_Printf);
+void LOG_SetLevel(LOG_Module_e eMod, LOG_Level_e eLevel)
+{
+    if (((uint32_t)eMod < LOG_MOD_MAX) && ((uint32_t)eLevel < LOG_LVL_MAX)) {
+        au8LogLevel[eMod] = (uint8_t)eLevel;
     }
 }
 
-// 把需要打印的字符串拷贝到打印缓存
-void printf2bufffromISR(char const *str)
+// u16PerSec = 0: 不限流
+void LOG_SetRate(LOG_Module_e eMod, uint16_t u16PerSec, uint16_t u16Burst)
 {
-    BaseType_t xHigherPriorityTaskWoken;
-    if (isPrintTaskReady == false) {
+    UBaseType_t uxSaved;
+
+    if ((uint32_t)eMod >= LOG_MOD_MAX) {
         return;
     }
+    if (u16Burst == 0U) {
+        u16Burst = 1U;
+    }
+    uxSaved = portSET_INTERRUPT_MASK_FROM_ISR();
+    astLogBucket[eMod].u16PerSec = u16PerSec;
+    astLogBucket[eMod].u16Burst = u16Burst;
+    astLogBucket[eMod].u32Credit = (uint32_t)u16Burst * configTICK_RATE_HZ;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(uxSaved);
+}
+
+
+#include <stdlib.h>
+#include "shell.h"
+#include "shell_port.h"
+
+// 模块名或等级名转换成编号, 等级也可以直接用数字; 找不到返回-1
+static int LOG_s32Lookup(const char *pcName, const char * const *ppcTable, int s32Num)
+{
+    char *pcEnd = NULL;
+    long lVal;
+    int i;
+
+    for (i = 0; i < s32Num; i++) {
+        if (strcmp(pcName, ppcTable[i]) == 0) {
+            return i;
+        }
+    }
+    lVal = strtol(pcName, &pcEnd, 0);
+    if ((pcEnd != pcName) && (*pcEnd == '\0') && (lVal >= 0) && (lVal < s32Num)) {
+        return (int)lVal;
+    }
+    return -1;
+}
+
+// shell: loglevel                         显示所有模块的等级和限流
+//        loglevel <mod|all> <level>       设置等级 none/err/warn/info/debug 或 0~4
+//        loglevel <mod|all> rate <n> [b]  每秒最多n条, 突发b条; n=0不限流
+int LOG_LevelShell(int argc, char *argv[])
+{
+    int s32Mod = 0, s32Lvl = 0, s32First, s32Last, i;
+    uint16_t u16Rate, u16Burst;
+
+    if (argc >= 3) {
+        if (strcmp(argv[1], "all") == 0) {
+            s32First = 0;
+            s32Last = LOG_MOD_MAX - 1;
+        } else if ((s32Mod = LOG_s32Lookup(argv[1], apcLogModName, LOG_MOD_MAX)) >= 0) {
+            s32First = s32Last = s32Mod;
+        } else {
+            shellPrint(&shell, "unknown module %s\r\n", argv[1]);
+            return -1;
+        }
+
+        if (strcmp(argv[2], "rate") == 0) {
+            if (argc < 4) {
+                shellPrint(&shell, "usage: loglevel <mod|all> rate <n> [burst]\r\n");
+                return -1;
+            }
+            u16Rate = (uint16_t)strtoul(argv[3], NULL, 0);
+            u16Burst = (argc >= 5) ? (uint16_t)strtoul(argv[4], NULL, 0) : u16Rate;
+            for (i = s32First; i <= s32Last; i++) {
+                LOG_SetRate((LOG_Module_e)i, u16Rate, u16Burst);
+            }
+        } else if ((s32Lvl = LOG_s32Lookup(argv[2], apcLogLvlName, LOG_LVL_MAX)) >= 0) {
+            for (i = s32First; i <= s32Last; i++) {
+                LOG_SetLevel((LOG_Module_e)i, (LOG_Level_e)s32Lvl);
+            }
+        } else {
+            shellPrint(&shell, "unknown level %s\r\n", argv[2]);
+            return -1;
+        }
+    } else if (argc != 1) {
+        shellPrint(&shell, "usage: loglevel [<mod|all> <level> | <mod|all> rate <n> [burst]]\r\n");
+        return -1;
+    }
 
-    // 对字符串进行长度合法检查
+    shellPrint(&shell, "module level  rate/s burst limited\r\n");
+    for (i = 0; i < LOG_MOD_MAX; i++) {
+        shellPrint(&shell, "%-6s %-6s %6u %5u %lu\r\n", apcLogModName[i], apcLogLvlName[au8LogLevel[i]],
+                   astLogBucket[i].u16PerSec, astLogBucket[i].u16Burst, astLogBucket[i].u32Limited);
+    }
+    shellPrint(&shell, "ring drops %lu bytes\r\n", u32LogDrops);
+    return 0;
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                 loglevel, LOG_LevelShell, Show or set log level and rate limit per module);
+
+
+// 取缓存中下一段连续的数据, 返回长度
+// 文本模式下在二进制记录的起始字节前截断, 记录由LOG_u32Expand单独处理
+static uint32_t LOG_u32NextSpan(uint8_t **ppu8Span)
+{
+    uint32_t u32Send = u32LogSend;
+    uint32_t u32Off = u32Send & (LOG_RING_SIZE - 1U);
+    uint32_t u32Len = (u32LogCommit - u32Send) & LOG_POS_MASK;
+#if (BLOG_BINARY_EN == 0)
+    uint8_t *pu8Sync;
+#endif
 
-    // 成功释放信号量后进行拷贝
-    xHigherPriorityTaskWoken = pdFALSE;
-    if (pdTRUE == xSemaphoreGiveFromISR(xSemphr_Printf, &xHigherPriorityTaskWoken)) {
-        //strncpy(PrintBuff, str, strlen(str));
-        strcpy(PrintBuff, str);
-        xSemaphoreGiveFromISR(xSemphr_Printf, &xHigherPriorityTaskWoken);
+    if (u32Len > (LOG_RING_SIZE - u32Off)) {
+        u32Len = LOG_RING_SIZE - u32Off;
     }
+    if (u32Len > LOG_SPAN_MAX) {
+        u32Len = LOG_SPAN_MAX;
+    }
+    *ppu8Span = &au8LogRing[u32Off];
+#if (BLOG_BINARY_EN == 0)
+    pu8Sync = memchr(*ppu8Span, BLOG_SYNC, u32Len);
+    if ((pu8Sync != NULL) && (pu8Sync != *ppu8Span)) {
+        u32Len = (uint32_t)(pu8Sync - *ppu8Span);
+    }
+#endif
+    return u32Len;
+}
 
-    // 
-    if(xHigherPriorityTaskWoken != pdFALSE) {
+#if (BLOG_BINARY_EN == 0)
+// 从缓存的u32Pos处拷贝u32Len字节, 缓存尾部放不下时分两段
+static void LOG_Copy(uint32_t u32Pos, uint8_t *pu8Dst, uint32_t u32Len)
+{
+    uint32_t u32Off = u32Pos & (LOG_RING_SIZE - 1U);
+    uint32_t u32First = LOG_RING_SIZE - u32Off;
 
+    if (u32First >= u32Len) {
+        memcpy(pu8Dst, &au8LogRing[u32Off], u32Len);
+    } else {
+        memcpy(pu8Dst, &au8LogRing[u32Off], u32First);
+        memcpy(pu8Dst + u32First, au8LogRing, u32Len - u32First);
     }
 }
 
+// 把u32LogSend处的二进制记录展开成文本, *pu32Text返回文本长度
+// 返回记录在缓存里占的长度; 记录是整条发布的, 已发布的部分里总是完整的
+static uint32_t LOG_u32Expand(char *pBuff, uint32_t *pu32Text)
+{
+    uint8_t au8Rec[BLOG_REC_MAX];
+    uint32_t u32Len;
 
-// 初始化阶段的打印信息，可以所有信息一次打印出来
-void printf2buffatinit(char const *str)
+    LOG_Copy(u32LogSend, au8Rec, 2U);
+    if (au8Rec[1] > BLOG_ARGS_MAX) {
+        au8Rec[1] = BLOG_ARGS_MAX;
+    }
+    u32Len = BLOG_REC_LEN(au8Rec[1]);
+    LOG_Copy(u32LogSend, au8Rec, u32Len);
+    *pu32Text = BLOG_u32Expand(au8Rec, pBuff, BLOG_TEXT_SIZE);
+    return u32Len;
+}
+#endif
+
+void debug_printf(const char *str)
 {
-    // 对字符串进行长度合法检查
-    if ((strlen(PrintBuff) + strlen(str) + 1) > PRINT_BSIZE) {
+    int len = 0;
+    if ((str == NULL) || ((len = strlen(str)) == 0)) {
         return;
     }
+ 
+    HAL_UART_Transmit(&huart1, (const uint8_t *)str, len, COM_SEND_TIMEOUT);
+}
+
+// UART1发送队列里的一段日志发送完成, 在发送完成中断里调用
+void LOG_TxDoneFromISR(void *pArg)
+{
+    (void)pArg;
+    u32LogTxDone++;
+    LOG_Kick(LOG_EVT_TXDONE);
+}
 
-    strcat(PrintBuff, str);
-    if (isPrintTaskReady == false) {
+// 专门用于调试信息打印的任务
+// 没有日志时一直阻塞, 由写日志和发送完成唤醒; 日志直接从缓存放入UART发送队列,
+// 队列里总有下一段在等待, 发送完成中断里马上启动, 有积压时串口一直是满的
+// 文本模式下二进制记录在这里展开, 展开后的文本从acLogText发送
+void RTOS_DebugPrintTask(void)
+{
+    uint8_t *apu8Span[LOG_SPAN_QUEUED] = {NULL};
+    uint32_t au32Len[LOG_SPAN_QUEUED] = {0U};    // 发送的长度
+    uint32_t au32Used[LOG_SPAN_QUEUED] = {0U};   // 占用的缓存长度
+    uint32_t u32Queued = 0U;     // 放入发送队列的段数
+    uint32_t u32Freed = 0U;      // 已释放缓存空间的段数
+    uint8_t *pu8Span = NULL;
+    uint32_t u32Len = 0U;
+    uint32_t u32Used = 0U;
+    uint32_t u32Evt = 0U;
+    uint32_t i;
+    TickType_t xWait = 0;        // 第一次进入时先发送初始化阶段的日志
+
+    isPrintTaskReady = true;
+
+    while(1) {
+        (void)xTaskNotifyWait(0, ULONG_MAX, &u32Evt, xWait);
+
+        // 发送完成的日志写入日志文件, 然后释放缓存空间
+        while (u32Freed != u32LogTxDone) {
+            i = u32Freed % LOG_SPAN_QUEUED;
+            u32LogTail = (u32LogTail + au32Used[i]) & LOG_POS_MASK;
+            LOGJ_Feed(apu8Span[i], au32Len[i], LOG_bUrgentDone(u32LogTail));
+            u32Freed++;
+        }
+
+        // 直接从日志缓存里取下一段放入发送队列
+        while (!bLogHold && ((u32Queued - u32Freed) < LOG_SPAN_QUEUED) && ((u32Used = LOG_u32NextSpan(&pu8Span)) != 0U)) {
+            i = u32Queued % LOG_SPAN_QUEUED;
+            u32Len = u32Used;
+#if (BLOG_BINARY_EN == 0)
+            if (*pu8Span == BLOG_SYNC) {
+                u32Used = LOG_u32Expand(acLogText[i], &u32Len);
+                pu8Span = (uint8_t *)acLogText[i];
+                if (u32Len == 0U) {                  // 展开后没有文本, 和前一段一起释放
+                    if (u32Queued != u32Freed) {
+                        au32Used[(u32Queued - 1U) % LOG_SPAN_QUEUED] += u32Used;
+                    } else {
+                        u32LogTail = (u32LogTail + u32Used) & LOG_POS_MASK;
+                    }
+                    u32LogSend = (u32LogSend + u32Used) & LOG_POS_MASK;
+                    continue;
+                }
+            }
+#endif
+            if (!UartDrv_bSend(&stUart1Drv, pu8Span, u32Len, LOG_TxDoneFromISR, NULL)) {
+                break;
+            }
+            apu8Span[i] = pu8Span;
+            au32Len[i] = u32Len;
+            au32Used[i] = u32Used;
+            u32LogSend = (u32LogSend + u32Used) & LOG_POS_MASK;
+            u32Queued++;
+        }
+
+        // UART被占用(debug_printf阻塞发送)时发送队列启动不了, 稍后重试
+        xWait = UartDrv_bTxKick(&stUart1Drv) ? portMAX_DELAY : LOG_RETRY_TICKS;
+    }
+}
+
+// 暂停/恢复日志发送; 暂停期间的日志留在缓存里, 缓存满时丢弃
+void LOG_Hold(bool bHold)
+{
+    bLogHold = bHold;
+    if (!bHold) {
+        LOG_Kick(LOG_EVT_DATA);
+    }
+}
+
+// 把需要打印的字符串写入日志缓存
+void printf2buff(char const *str)
+{
+    if (str == NULL) {
         return;
     }
+    (void)LOG_bWrite(str, strlen(str));
+}
+
+// 把需要打印的字符串(最多len字节)写入日志缓存
+void nprintf2buff(char const *str, uint16_t len)
+{
+    uint16_t n = 0;
 
-    xSemaphoreGive(xSemphr_Printf); // 强制发送信号量
+    if (str == NULL) {
+        return;
+    }
+    while ((n < len) && (str[n] != '\0')) {
+        n++;
+    }
+    (void)LOG_bWrite(str, n);
+}
+
+// 中断里调用, 和printf2buff相同(日志缓存不需要加锁)
+void printf2bufffromISR(char const *str)
+{
+    printf2buff(str);
+}
+
+
+// 初始化阶段的打印信息, 打印任务运行后一起发送
+void printf2buffatinit(char const *str)
+{
+    printf2buff(str);
 }
 
 /*
@@ -0,0 +1,305 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "message_buffer.h"
+#include "ipc_stream.h"
+#include "sharemem.h"
+
+
+//----------------- used in Core M4 ---------------------
+#if defined (CORE_CM4)
+//-------------------------------------------------------
+
+// CM4: 把bench7to4收到的消息原样从bench4to7送回
+void AMP_BenchEchoTask(void *pvParameters)
+{
+    static uint8_t au8Buff[IPC_BENCH_MSG_MAX];
+    MessageBufferHandle_t xRx = IPC_xStreamFind(IPC_STREAM_BENCH_TX);
+    MessageBufferHandle_t xTx = IPC_xStreamFind(IPC_STREAM_BENCH_RX);
+    size_t xLen;
+
+    (void)pvParameters;
+    if ((xRx == NULL) || (xTx == NULL)) {
+        vTaskDelete(NULL);
+    }
+
+    while (1)
+    {
+        xLen = xMessageBufferReceive(xRx, au8Buff, sizeof(au8Buff), portMAX_DELAY);
+        if (xLen > 0) {
+            (void)xMessageBufferSend(xTx, au8Buff, xLen, portMAX_DELAY);
+        }
+    }
+}
+
+// CM4: IPC_CH_LEND和IPC_CH_MAILBOX的消费者(shmbench)
+// 把CM7提交的借用块原样借一块送回, CM7每次只提交一块并等回送, 不会借不到; 借不到时丢弃
+// 环形缓存里的SHM_TYPE_ECHO记录原样送回, 其他类型的记录CM4上没有用户, 丢弃
+void AMP_ShmEchoTask(void *pvParameters)
+{
+    static uint8_t au8Rec[SHM_LEND_SLOT_SIZE];
+    SHM_Lend_t stRx, stTx;
+    int32_t s32Len;
+    uint16_t u16Type;
+
+    (void)pvParameters;
+    (void)IPC_bNotifyAttachTask(IPC_CH_LEND, xTaskGetCurrentTaskHandle());
+    (void)IPC_bNotifyAttachTask(IPC_CH_MAILBOX, xTaskGetCurrentTaskHandle());
+
+    while (1)
+    {
+        // 先取完再等: 注册之前到达的通知已经被应答掉了
+        while ((s32Len = ShareMem_s32Receive(&u16Type, au8Rec, sizeof(au8Rec))) >= 0) {
+            if ((u16Type == SHM_TYPE_ECHO) && (s32Len <= (int32_t)sizeof(au8Rec))) {
+                (void)ShareMem_bSend(SHM_TYPE_ECHO, au8Rec, (uint16_t)s32Len);
+            }
+        }
+        while (SHM_bAcquire(&stRx)) {
+            if (SHM_bBorrow(&stTx)) {
+                memcpy(stTx.pu8Data, stRx.pu8Data, stRx.u16Size);
+                (void)SHM_bCommit(&stTx, stRx.u16Size);
+            }
+            (void)SHM_bRelease(&stRx);
+        }
+        (void)IPC_u32NotifyWait(portMAX_DELAY);
+    }
+}
+
+//----------------- used in Core M7 ---------------------
+#else
+//-------------------------------------------------------
+#include "shell.h"
+#include "shell_port.h"
+
+#define BENCH_TIMEOUT       pdMS_TO_TICKS(100)
+#define BENCH_COUNT_DEF     (100)
+
+static TaskHandle_t AmpBenchTaskHandle = NULL;
+static TaskHandle_t ShmBenchTaskHandle = NULL;
+static const uint16_t au16BenchSize[] = {1, 16, 64, 256, 1024, IPC_BENCH_MSG_MAX};
+static const uint16_t au16ShmSize[] = {1, 16, 64, 256, SHM_LEND_SLOT_SIZE};
+
+typedef bool (*AMP_Trip_t)(const uint8_t *pu8Tx, uint16_t u16Len);
+
+// CM7: 每种长度往返u32Count次, 统计往返时间和吞吐量
+static void AMP_BenchTask(void *pvParameters)
+{
+    static uint8_t au8Tx[IPC_BENCH_MSG_MAX];
+    static uint8_t au8Rx[IPC_BENCH_MSG_MAX];
+    uint32_t u32Count = (uint32_t)pvParameters;
+    MessageBufferHandle_t xTx = IPC_xStreamFind(IPC_STREAM_BENCH_TX);
+    MessageBufferHandle_t xRx = IPC_xStreamFind(IPC_STREAM_BENCH_RX);
+    uint32_t u32CycPerUs = SystemCoreClock / 1000000U;
+    uint32_t i, n, u32Start, u32Cyc, u32Min, u32Max, u32Sum, u32Err;
+    uint16_t u16Len;
+
+    if ((xTx == NULL) || (xRx == NULL)) {
+        shellPrint(&shell, "ampbench: channel not found\r\n");
+        AmpBenchTaskHandle = NULL;
+        vTaskDelete(NULL);
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;      // DWT周期计数器
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    for (i = 0; i < sizeof(au8Tx); i++) {
+        au8Tx[i] = (uint8_t)i;
+    }
+
+    shellPrint(&shell, "size(B)  min(us)  avg(us)  max(us)  KB/s  err\r\n");
+    for (i = 0; i < sizeof(au16BenchSize) / sizeof(au16BenchSize[0]); i++) {
+        u16Len = au16BenchSize[i];
+        u32Min = 0xFFFFFFFFU;
+        u32Max = 0U;
+        u32Sum = 0U;
+        u32Err = 0U;
+
+        for (n = 0; n < u32Count; n++) {
+            u32Start = DWT->CYCCNT;
+            if ((xMessageBufferSend(xTx, au8Tx, u16Len, BENCH_TIMEOUT) != u16Len)
+                || (xMessageBufferReceive(xRx, au8Rx, sizeof(au8Rx), BENCH_TIMEOUT) != u16Len)) {
+                u32Err++;
+                continue;
+            }
+            u32Cyc = DWT->CYCCNT - u32Start;
+            u32Sum += u32Cyc / u32CycPerUs;
+            u32Min = (u32Cyc < u32Min) ? u32Cyc : u32Min;
+            u32Max = (u32Cyc > u32Max) ? u32Cyc : u32Max;
+            if (memcmp(au8Tx, au8Rx, u16Len) != 0) {
+                u32Err++;
+            }
+        }
+
+        n = u32Count - u32Err;
+        if (n == 0U || u32Sum == 0U) {
+            shellPrint(&shell, "%7u  -        -        -        -     %lu\r\n", u16Len, u32Err);
+            continue;
+        }
+        // 往返一次传输2*u16Len字节
+        shellPrint(&shell, "%7u  %7lu  %7lu  %7lu  %5lu  %lu\r\n", u16Len,
+                   u32Min / u32CycPerUs, u32Sum / n, u32Max / u32CycPerUs,
+                   (uint32_t)((2ULL * u16Len * n * 1000000ULL) / ((uint64_t)u32Sum * 1024ULL)), u32Err);
+    }
+
+    AmpBenchTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+// shell: ampbench [count], 测试CM7<->CM4消息通道
+void AMP_Bench(int count)
+{
+    if (AmpBenchTaskHandle != NULL) {
+        shellPrint(&shell, "ampbench is running\r\n");
+        return;
+    }
+    if (count <= 0) {
+        count = BENCH_COUNT_DEF;
+    }
+    // 测试时间较长, 放在单独的任务里, 不占用shell
+    if (xTaskCreate((TaskFunction_t)AMP_BenchTask, "AmpBench", 256, (void *)count, 3, &AmpBenchTaskHandle) != pdPASS) {
+        shellPrint(&shell, "ampbench: create task failed\r\n");
+    }
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_FUNC),
+                 ampbench, AMP_Bench, CM7-CM4 message buffer benchmark [count]);
+
+// 借用块往返一次: 借出, 写入, 提交, 等CM4送回的块, 比较后归还
+static bool AMP_bLendTrip(const uint8_t *pu8Tx, uint16_t u16Len)
+{
+    SHM_Lend_t stLend;
+    bool bOk;
+
+    while (SHM_bAcquire(&stLend)) {                     // 上一次超时之后才送回的块
+        (void)SHM_bRelease(&stLend);
+    }
+    if (!SHM_bBorrow(&stLend)) {
+        return false;
+    }
+    memcpy(stLend.pu8Data, pu8Tx, u16Len);
+    if (!SHM_bCommit(&stLend, u16Len)) {
+        (void)SHM_bCancel(&stLend);
+        return false;
+    }
+    while (!SHM_bAcquire(&stLend)) {
+        if (IPC_u32NotifyWait(BENCH_TIMEOUT) == 0U) {
+            return false;
+        }
+    }
+    bOk = (stLend.u16Size == u16Len) && (memcmp(stLend.pu8Data, pu8Tx, u16Len) == 0);
+    (void)SHM_bRelease(&stLend);
+    return bOk;
+}
+
+// 环形缓存往返一次: 发送一条SHM_TYPE_ECHO记录, 等CM4送回后比较
+static bool AMP_bMailTrip(const uint8_t *pu8Tx, uint16_t u16Len)
+{
+    static uint8_t au8Rx[SHM_LEND_SLOT_SIZE];
+    int32_t s32Len;
+    uint16_t u16Type;
+
+    while (ShareMem_s32Receive(&u16Type, au8Rx, sizeof(au8Rx)) >= 0) {     // 上一次超时之后才送回的记录
+    }
+    if (!ShareMem_bSend(SHM_TYPE_ECHO, pu8Tx, u16Len)) {
+        return false;
+    }
+    while ((s32Len = ShareMem_s32Receive(&u16Type, au8Rx, sizeof(au8Rx))) < 0) {
+        if (IPC_u32NotifyWait(BENCH_TIMEOUT) == 0U) {
+            return false;
+        }
+    }
+    return (u16Type == SHM_TYPE_ECHO) && (s32Len == (int32_t)u16Len) && (memcmp(au8Rx, pu8Tx, u16Len) == 0);
+}
+
+// 每种长度往返u32Count次, 和ampbench一样打印一张表
+static void AMP_ShmRun(const char *pcName, AMP_Trip_t pfTrip, const uint8_t *pu8Tx, uint32_t u32Count)
+{
+    uint32_t u32CycPerUs = SystemCoreClock / 1000000U;
+    uint32_t i, n, u32Start, u32Cyc, u32Min, u32Max, u32Sum, u32Err;
+    uint16_t u16Len;
+
+    shellPrint(&shell, "%s\r\nsize(B)  min(us)  avg(us)  max(us)  KB/s  err\r\n", pcName);
+    for (i = 0; i < sizeof(au16ShmSize) / sizeof(au16ShmSize[0]); i++) {
+        u16Len = au16ShmSize[i];
+        u32Min = 0xFFFFFFFFU;
+        u32Max = 0U;
+        u32Sum = 0U;
+        u32Err = 0U;
+
+        for (n = 0; n < u32Count; n++) {
+            u32Start = DWT->CYCCNT;
+            if (!pfTrip(pu8Tx, u16Len)) {
+                u32Err++;
+                continue;
+            }
+            u32Cyc = DWT->CYCCNT - u32Start;
+            u32Sum += u32Cyc / u32CycPerUs;
+            u32Min = (u32Cyc < u32Min) ? u32Cyc : u32Min;
+            u32Max = (u32Cyc > u32Max) ? u32Cyc : u32Max;
+        }
+
+        n = u32Count - u32Err;
+        if (n == 0U || u32Sum == 0U) {
+            shellPrint(&shell, "%7u  -        -        -        -     %lu\r\n", u16Len, u32Err);
+            continue;
+        }
+        shellPrint(&shell, "%7u  %7lu  %7lu  %7lu  %5lu  %lu\r\n", u16Len,
+                   u32Min / u32CycPerUs, u32Sum / n, u32Max / u32CycPerUs,
+                   (uint32_t)((2ULL * u16Len * n * 1000000ULL) / ((uint64_t)u32Sum * 1024ULL)), u32Err);
+    }
+}
+
+// CM7: 测试运行期间是CM4->CM7借用块(IPC_CH_LEND)和环形缓存(IPC_CH_MAILBOX)的消费者, 结束时注销
+static void AMP_ShmBenchTask(void *pvParameters)
+{
+    static uint8_t au8Tx[SHM_LEND_SLOT_SIZE];
+    uint32_t u32Count = (uint32_t)pvParameters;
+    uint32_t i;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;      // DWT周期计数器
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    for (i = 0; i < sizeof(au8Tx); i++) {
+        au8Tx[i] = (uint8_t)(i * 7U);
+    }
+
+    (void)IPC_bNotifyAttachTask(IPC_CH_LEND, xTaskGetCurrentTaskHandle());
+    (void)IPC_bNotifyAttachTask(IPC_CH_MAILBOX, xTaskGetCurrentTaskHandle());
+    AMP_ShmRun("lend", AMP_bLendTrip, au8Tx, u32Count);
+    AMP_ShmRun("mailbox", AMP_bMailTrip, au8Tx, u32Count);
+    (void)IPC_bNotifyRegister(IPC_CH_MAILBOX, NULL, NULL);
+    (void)IPC_bNotifyRegister(IPC_CH_LEND, NULL, NULL);
+
+    ShmBenchTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+// shell: shmbench [count], 测试共享内存借用块和环形缓存的往返时间
+void AMP_ShmBench(int count)
+{
+    if (ShmBenchTaskHandle != NULL) {
+        shellPrint(&shell, "shmbench is running\r\n");
+        return;
+    }
+    if (!ShareMem_bIsReady()) {
+        shellPrint(&shell, "shmbench: share memory not ready\r\n");
+        return;
+    }
+    if (count <= 0) {
+        count = BENCH_COUNT_DEF;
+    }
+    if (xTaskCreate((TaskFunction_t)AMP_ShmBenchTask, "ShmBench", 256, (void *)count, 3, &ShmBenchTaskHandle) != pdPASS) {
+        shellPrint(&shell, "shmbench: create task failed\r\n");
+    }
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_FUNC),
+                 shmbench, AMP_ShmBench, CM7-CM4 share memory lend/mailbox benchmark [count]);
+
+//-------------------------------------------------------
+#endif
+//-------------------------------------------------------
@@ -0,0 +1,196 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "ipc_frame.h"
+
+
+#define FRM_PAYLOAD_MAX      (SHM_LEND_SLOT_SIZE - IPC_FRM_HDR_SIZE - IPC_FRM_REC_HDR_SIZE)
+
+
+void IPC_FrameWriterInit(IPC_FrameWriter_t *pW)
+{
+    memset(pW, 0, sizeof(IPC_FrameWriter_t));
+}
+
+// 借一个新块作为当前帧
+static bool FrameOpen(IPC_FrameWriter_t *pW)
+{
+    if (!SHM_bBorrow(&pW->stLend)) {
+        return false;
+    }
+    pW->u16Used = IPC_FRM_HDR_SIZE;
+    pW->u16Count = 0U;
+    pW->bOpen = true;
+    return true;
+}
+
+// 提交当前帧, 一帧只通知对方一次
+bool IPC_bFrameFlush(IPC_FrameWriter_t *pW)
+{
+    uint16_t *pu16Hdr;
+
+    if (!pW->bOpen || (pW->u16Count == 0U)) {
+        return true;
+    }
+
+    pu16Hdr = (uint16_t *)pW->stLend.pu8Data;
+    pu16Hdr[0] = pW->u16Count;
+    pu16Hdr[1] = pW->u16Seq;
+    pW->bOpen = false;
+    if (!SHM_bCommit(&pW->stLend, pW->u16Used)) {
+        (void)SHM_bCancel(&pW->stLend);                 // 提交失败时块还是借出状态, 归还, 否则永远少一块
+        pW->u32Drops += pW->u16Count;
+        return false;
+    }
+    pW->u16Seq++;
+    pW->u32Frames++;
+    return true;
+}
+
+// 在当前帧里追加一片
+static void FrameAppend(IPC_FrameWriter_t *pW, uint16_t u16Type, const uint8_t *pData, uint16_t u16Len)
+{
+    uint16_t *pu16Rec = (uint16_t *)&pW->stLend.pu8Data[pW->u16Used];
+
+    pu16Rec[0] = u16Type;
+    pu16Rec[1] = u16Len;
+    memcpy(&pW->stLend.pu8Data[pW->u16Used + IPC_FRM_REC_HDR_SIZE], pData, u16Len);
+    pW->u16Used += (uint16_t)(IPC_FRM_REC_HDR_SIZE + IPC_REC_ALIGN(u16Len));
+    pW->u16Count++;
+}
+
+// 追加一条记录, 当前帧满了自动提交, 记录比一帧大时分片
+// 返回值: false 没有空闲块, 没写完的部分被丢弃
+bool IPC_bFramePut(IPC_FrameWriter_t *pW, uint16_t u16Type, const void *pData, uint32_t u32Len)
+{
+    const uint8_t *pu8Src = (const uint8_t *)pData;
+    uint16_t u16Flag = 0U;
+    uint32_t u32Room, u32Piece;
+
+    u16Type &= IPC_FRM_TYPE_MASK;
+    while (1) {
+        if (!pW->bOpen && !FrameOpen(pW)) {
+            pW->u32Drops++;
+            return false;
+        }
+
+        u32Room = SHM_LEND_SLOT_SIZE - pW->u16Used;
+        if (u32Room <= IPC_FRM_REC_HDR_SIZE) {
+            (void)IPC_bFrameFlush(pW);
+            continue;
+        }
+        u32Room -= IPC_FRM_REC_HDR_SIZE;
+        u32Room &= ~3UL;
+
+        // 放得下就整条放进当前帧; 放不下时, 如果新帧能放下就先提交当前帧, 否则从当前帧开始分片
+        if ((u32Len > u32Room) && (u32Len <= FRM_PAYLOAD_MAX) && (pW->u16Count != 0U)) {
+            (void)IPC_bFrameFlush(pW);
+            continue;
+        }
+
+        u32Piece = (u32Len > u32Room) ? u32Room : u32Len;
+        FrameAppend(pW, u16Type | u16Flag | ((u32Piece < u32Len) ? IPC_FRM_MORE : 0U), pu8Src, (uint16_t)u32Piece);
+        pu8Src += u32Piece;
+        u32Len -= u32Piece;
+        u16Flag = IPC_FRM_CONT;
+
+        if ((SHM_LEND_SLOT_SIZE - pW->u16Used) <= IPC_FRM_REC_HDR_SIZE) {
+            (void)IPC_bFrameFlush(pW);
+        }
+        if (u32Len == 0U) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+void IPC_FrameReaderInit(IPC_FrameReader_t *pR, uint8_t *pu8Reasm, uint32_t u32ReasmSize)
+{
+    memset(pR, 0, sizeof(IPC_FrameReader_t));
+    pR->pu8Reasm = pu8Reasm;
+    pR->u32ReasmSize = u32ReasmSize;
+}
+
+// 处理一片, 完整的记录交给处理函数
+static uint32_t FrameRecord(IPC_FrameReader_t *pR, uint16_t u16Type, const uint8_t *pData, uint16_t u16Len,
+                            IPC_FrameHandler_t pfHandler, void *pArg)
+{
+    uint16_t u16Id = u16Type & IPC_FRM_TYPE_MASK;
+
+    if (!(u16Type & IPC_FRM_CONT)) {
+        if (pR->bReasm) {                               // 上一条记录没有收完
+            pR->bReasm = false;
+            pR->u32Drops++;
+        }
+        if (!(u16Type & IPC_FRM_MORE)) {                // 没有分片, 直接在共享内存里处理
+            pfHandler(u16Id, pData, u16Len, pArg);
+            return 1U;
+        }
+        pR->bReasm = true;
+        pR->u16ReasmType = u16Id;
+        pR->u32ReasmLen = 0U;
+    } else if (!pR->bReasm || (pR->u16ReasmType != u16Id)) {
+        pR->u32Drops++;
+        return 0U;
+    }
+
+    if ((pR->pu8Reasm == NULL) || ((pR->u32ReasmLen + u16Len) > pR->u32ReasmSize)) {
+        pR->bReasm = false;
+        pR->u32Drops++;
+        return 0U;
+    }
+    memcpy(&pR->pu8Reasm[pR->u32ReasmLen], pData, u16Len);
+    pR->u32ReasmLen += u16Len;
+
+    if (u16Type & IPC_FRM_MORE) {
+        return 0U;
+    }
+    pR->bReasm = false;
+    pfHandler(u16Id, pR->pu8Reasm, pR->u32ReasmLen, pArg);
+    return 1U;
+}
+
+// 处理所有已提交的帧, 返回交给处理函数的记录数
+uint32_t IPC_u32FrameProcess(IPC_FrameReader_t *pR, IPC_FrameHandler_t pfHandler, void *pArg)
+{
+    SHM_Lend_t stLend;
+    uint32_t u32Recs = 0U;
+    uint16_t u16Off, u16Count, u16Type, u16Len;
+    const uint16_t *pu16;
+
+    while (SHM_bAcquire(&stLend)) {
+        pu16 = (const uint16_t *)stLend.pu8Data;
+        u16Count = pu16[0];
+        if (pu16[1] != pR->u16Seq) {
+            pR->u32SeqErr++;
+            if (pR->bReasm) {                           // 丢帧或乱序, 正在重组的记录不完整
+                pR->bReasm = false;
+                pR->u32Drops++;
+            }
+        }
+        pR->u16Seq = pu16[1] + 1U;
+        pR->u32Frames++;
+
+        u16Off = IPC_FRM_HDR_SIZE;
+        while ((u16Count > 0U) && ((u16Off + IPC_FRM_REC_HDR_SIZE) <= stLend.u16Size)) {
+            pu16 = (const uint16_t *)&stLend.pu8Data[u16Off];
+            u16Type = pu16[0];
+            u16Len = pu16[1];
+            if ((u16Off + IPC_FRM_REC_HDR_SIZE + u16Len) > stLend.u16Size) {
+                pR->u32Drops++;                         // 帧内容错误
+                break;
+            }
+            u32Recs += FrameRecord(pR, u16Type, &stLend.pu8Data[u16Off + IPC_FRM_REC_HDR_SIZE], u16Len, pfHandler, pArg);
+            u16Off += (uint16_t)(IPC_FRM_REC_HDR_SIZE + IPC_REC_ALIGN(u16Len));
+            u16Count--;
+        }
+        (void)SHM_bRelease(&stLend);
+    }
+    return u32Recs;
+}
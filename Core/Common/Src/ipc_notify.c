@@ -0,0 +1,104 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <stddef.h>
+#include "ipc_notify.h"
+
+
+#if defined ( __ICCARM__ ) || defined ( __CC_ARM ) || defined ( __ARMCC_VERSION ) || defined ( __arm__ )
+#define NOTIFY_LOCK()      uint32_t u32Primask = __get_PRIMASK(); __disable_irq()
+#define NOTIFY_UNLOCK()    __set_PRIMASK(u32Primask)
+#else
+#define NOTIFY_LOCK()
+#define NOTIFY_UNLOCK()
+#endif
+
+typedef struct _IPC_NotifyHook_ {
+    IPC_NotifyHandler_t pfHandler;
+    void *pArg;
+} IPC_NotifyHook_t;
+
+static IPC_NotifyBits_t *pNotifyTx = NULL;
+static IPC_NotifyBits_t *pNotifyRx = NULL;
+static IPC_Doorbell_t pfNotifyDoorbell = NULL;
+static IPC_NotifyHook_t astNotifyHook[IPC_CH_MAX];
+
+
+// pTx: 本核发送方向的挂起位, pRx: 本核接收方向的挂起位(都在共享内存中)
+void IPC_NotifyInit(IPC_NotifyBits_t *pTx, IPC_NotifyBits_t *pRx, IPC_Doorbell_t pfDoorbell)
+{
+    pNotifyTx = pTx;
+    pNotifyRx = pRx;
+    pfNotifyDoorbell = pfDoorbell;
+}
+
+void IPC_NotifySetDoorbell(IPC_Doorbell_t pfDoorbell)
+{
+    pfNotifyDoorbell = pfDoorbell;
+}
+
+// 注册接收通道的处理函数, 处理函数在门铃中断里执行
+bool IPC_bNotifyRegister(uint8_t u8Ch, IPC_NotifyHandler_t pfHandler, void *pArg)
+{
+    if (u8Ch >= IPC_CH_MAX) {
+        return false;
+    }
+    astNotifyHook[u8Ch].pfHandler = NULL;
+    astNotifyHook[u8Ch].pArg = pArg;
+    astNotifyHook[u8Ch].pfHandler = pfHandler;
+    return true;
+}
+
+// 发送方: 置通道挂起位并敲门铃, 通道已经挂起时不重复敲门铃
+// 返回值: true 敲了门铃; false 已挂起或者没有初始化
+bool IPC_bNotifySignal(uint8_t u8Ch)
+{
+    uint32_t u32Bit = (1UL << u8Ch);
+    bool bRing = false;
+
+    if ((pNotifyTx == NULL) || (u8Ch >= IPC_CH_MAX)) {
+        return false;
+    }
+
+    {
+        NOTIFY_LOCK();                                 // 同一个核可能有多个发送者
+        // 之前写的数据先于读挂起状态: 否则对方可能已经应答并读过数据, 这里却还看到挂起而不发通知
+        IPC_DMB();
+        if (((pNotifyTx->u32Req ^ pNotifyTx->u32Ack) & u32Bit) == 0U) {
+            pNotifyTx->u32Req ^= u32Bit;
+            bRing = true;
+        }
+        NOTIFY_UNLOCK();
+    }
+
+    if (bRing && (pfNotifyDoorbell != NULL)) {
+        pfNotifyDoorbell();
+    }
+    return bRing;
+}
+
+// 接收方: 应答所有挂起的通道并调用处理函数, 返回处理的通道位图
+uint32_t IPC_u32NotifyDispatch(void)
+{
+    uint32_t u32Req, u32Pend;
+    uint8_t u8Ch;
+
+    if (pNotifyRx == NULL) {
+        return 0U;
+    }
+
+    u32Req = pNotifyRx->u32Req;
+    u32Pend = u32Req ^ pNotifyRx->u32Ack;
+    pNotifyRx->u32Ack = u32Req;
+    IPC_DMB();                                         // 先应答, 再读数据, 新的请求不会丢
+
+    for (u8Ch = 0; u8Ch < IPC_CH_MAX; u8Ch++) {
+        if (((u32Pend >> u8Ch) & 1U) && (astNotifyHook[u8Ch].pfHandler != NULL)) {
+            astNotifyHook[u8Ch].pfHandler(u8Ch, astNotifyHook[u8Ch].pArg);
+        }
+    }
+    return u32Pend;
+}
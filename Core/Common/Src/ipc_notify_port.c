@@ -0,0 +1,96 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "HdwITPriorities.h"
+#include "sharemem.h"
+#include "ipc_notify.h"
+
+
+#if defined (CORE_CM4)
+#define NOTIFY_HSEM_TX      IPC_HSEM_ID_4TO7
+#define NOTIFY_HSEM_RX      IPC_HSEM_ID_7TO4
+#define NOTIFY_HSEM_IRQn    HSEM2_IRQn
+#define pNotifyBitsTx       (&pShareData->stNotify4to7)
+#define pNotifyBitsRx       (&pShareData->stNotify7to4)
+#else
+#define NOTIFY_HSEM_TX      IPC_HSEM_ID_7TO4
+#define NOTIFY_HSEM_RX      IPC_HSEM_ID_4TO7
+#define NOTIFY_HSEM_IRQn    HSEM1_IRQn
+#define pNotifyBitsTx       (&pShareData->stNotify7to4)
+#define pNotifyBitsRx       (&pShareData->stNotify4to7)
+#endif
+
+static BaseType_t xNotifyWoken = pdFALSE;
+
+
+// 释放一次硬件信号量, 对方核产生HSEM中断
+static void HsemDoorbell(void)
+{
+    if (HAL_HSEM_FastTake(NOTIFY_HSEM_TX) == HAL_OK) {
+        HAL_HSEM_Release(NOTIFY_HSEM_TX, 0);
+    }
+}
+
+static void NotifyTaskHandler(uint8_t u8Ch, void *pArg)
+{
+    (void)u8Ch;
+    vTaskNotifyGiveFromISR((TaskHandle_t)pArg, &xNotifyWoken);
+}
+
+// CM7在ShareMemInit()之后, 两个核都在启动RTOS之前调用
+void IPC_NotifyPortInit(void)
+{
+    __HAL_RCC_HSEM_CLK_ENABLE();
+    IPC_NotifyInit(pNotifyBitsTx, pNotifyBitsRx, HsemDoorbell);
+
+    HAL_NVIC_SetPriority(NOTIFY_HSEM_IRQn,
+                         HDW_IT_GETPRIORITY(HDW_IT_PRIORITY_IPC_HSEM),
+                         HDW_IT_GETSUBPRIORITY(HDW_IT_PRIORITY_IPC_HSEM));
+    HAL_NVIC_EnableIRQ(NOTIFY_HSEM_IRQn);
+    HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(NOTIFY_HSEM_RX));
+}
+
+// 通道有通知时唤醒xTask, 任务里用IPC_u32NotifyWait()等待
+bool IPC_bNotifyAttachTask(uint8_t u8Ch, TaskHandle_t xTask)
+{
+    return IPC_bNotifyRegister(u8Ch, NotifyTaskHandler, (void *)xTask);
+}
+
+uint32_t IPC_u32NotifyWait(TickType_t xTicksToWait)
+{
+    return ulTaskNotifyTake(pdTRUE, xTicksToWait);
+}
+
+// HAL_HSEM_IRQHandler()关闭了信号量中断, 这里要重新打开
+void HAL_HSEM_FreeCallback(uint32_t SemMask)
+{
+    if (SemMask & __HAL_HSEM_SEMID_TO_MASK(NOTIFY_HSEM_RX)) {
+        HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(NOTIFY_HSEM_RX));
+        xNotifyWoken = pdFALSE;
+        IPC_u32NotifyDispatch();
+        portYIELD_FROM_ISR(xNotifyWoken);
+    }
+}
+
+
+#if defined (CORE_CM4)
+// sbSEND_COMPLETED: stream/message buffer写完之后通知CM7
+void vGenerateM4ToM7Interrupt(void *xUpdatedMessageBuffer)
+{
+    (void)xUpdatedMessageBuffer;
+    IPC_bNotifySignal(IPC_CH_STREAM);
+}
+#else
+// sbSEND_COMPLETED: stream/message buffer写完之后通知CM4
+void vGenerateM7ToM4Interrupt(void *xUpdatedMessageBuffer)
+{
+    (void)xUpdatedMessageBuffer;
+    IPC_bNotifySignal(IPC_CH_STREAM);
+}
+#endif
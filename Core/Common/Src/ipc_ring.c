@@ -0,0 +1,108 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "ipc_ring.h"
+
+
+#define REC_HDR(type, len)   (((uint32_t)(type) << 16) | (uint32_t)(len))
+#define REC_TYPE(hdr)        ((uint16_t)((hdr) >> 16))
+#define REC_LEN(hdr)         ((uint16_t)((hdr) & 0xFFFFU))
+
+
+// 初始化环形缓存, 只能由一个核在另一个核使用之前调用
+// u32Size必须是2的整数次幂且不小于8
+void IPC_RingInit(IPC_Ring_t *pRing, uint8_t *pu8Buff, uint32_t u32Size)
+{
+    memset(pRing, 0, sizeof(IPC_Ring_t));
+    pRing->u32Size = u32Size;
+    pRing->pu8Data = pu8Buff;
+    IPC_DMB();
+}
+
+// 剩余可写字节数(包含记录头)
+uint32_t IPC_u32RingFree(const IPC_Ring_t *pRing)
+{
+    return (pRing->u32Size - (pRing->u32Head - pRing->u32Tail));
+}
+
+bool IPC_bRingEmpty(const IPC_Ring_t *pRing)
+{
+    return (pRing->u32Head == pRing->u32Tail);
+}
+
+// 生产者: 写一条记录
+// 返回值: true 写入成功; false 缓存空间不足, 记录被丢弃(累计到u32Drops)
+bool IPC_bRingWrite(IPC_Ring_t *pRing, uint16_t u16Type, const void *pData, uint16_t u16Len)
+{
+    uint32_t u32Head = pRing->u32Head;
+    uint32_t u32Tail = pRing->u32Tail;
+    uint32_t u32Need = IPC_REC_HDR_SIZE + IPC_REC_ALIGN(u16Len);
+    uint32_t u32Off  = u32Head & (pRing->u32Size - 1U);
+    uint32_t u32ToEnd = pRing->u32Size - u32Off;
+    uint32_t u32Pad  = (u32ToEnd < u32Need) ? u32ToEnd : 0U;
+
+    if ((u16Type == IPC_REC_TYPE_PAD) || (pData == NULL && u16Len != 0U)) {
+        return false;
+    }
+
+    // 消费者读完u32Tail之前的数据, u32Tail只会变大, 这里的判断是保守的
+    if ((u32Need + u32Pad) > (pRing->u32Size - (u32Head - u32Tail))) {
+        pRing->u32Drops++;
+        return false;
+    }
+
+    if (u32Pad != 0U) {  // 缓存尾部放不下, 写填充记录后回到头部
+        *(uint32_t *)&pRing->pu8Data[u32Off] = REC_HDR(IPC_REC_TYPE_PAD, u32Pad - IPC_REC_HDR_SIZE);
+        u32Head += u32Pad;
+        u32Off = 0U;
+    }
+
+    *(uint32_t *)&pRing->pu8Data[u32Off] = REC_HDR(u16Type, u16Len);
+    if (u16Len != 0U) {
+        memcpy(&pRing->pu8Data[u32Off + IPC_REC_HDR_SIZE], pData, u16Len);
+    }
+
+    IPC_DMB();                            // 数据写完之后才能更新写索引
+    pRing->u32Head = u32Head + u32Need;
+    return true;
+}
+
+// 消费者: 读一条记录
+// 返回值: 记录的数据长度, 超过u16MaxLen时只拷贝u16MaxLen字节; -1 没有数据
+int32_t IPC_s32RingRead(IPC_Ring_t *pRing, uint16_t *pu16Type, void *pData, uint16_t u16MaxLen)
+{
+    uint32_t u32Tail = pRing->u32Tail;
+    uint32_t u32Off, u32Hdr;
+    uint16_t u16Len;
+
+    while (1) {
+        if (u32Tail == pRing->u32Head) {
+            return -1;
+        }
+        IPC_DMB();                        // 先看到写索引, 再读数据
+
+        u32Off = u32Tail & (pRing->u32Size - 1U);
+        u32Hdr = *(uint32_t *)&pRing->pu8Data[u32Off];
+        if (REC_TYPE(u32Hdr) != IPC_REC_TYPE_PAD) {
+            break;
+        }
+        u32Tail += pRing->u32Size - u32Off; // 跳过填充记录
+        pRing->u32Tail = u32Tail;
+    }
+
+    u16Len = REC_LEN(u32Hdr);
+    if (pu16Type != NULL) {
+        *pu16Type = REC_TYPE(u32Hdr);
+    }
+    if (pData != NULL) {
+        memcpy(pData, &pRing->pu8Data[u32Off + IPC_REC_HDR_SIZE], (u16Len < u16MaxLen) ? u16Len : u16MaxLen);
+    }
+
+    IPC_DMB();                            // 数据读完之后才能释放空间
+    pRing->u32Tail = u32Tail + IPC_REC_HDR_SIZE + IPC_REC_ALIGN(u16Len);
+    return (int32_t)u16Len;
+}
@@ -0,0 +1,326 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "sharemem.h"
+#include "ipc_notify.h"
+#include "ipc_rpc.h"
+
+
+#define RPC_REC_TYPE         (0x0010U)                 // 环形缓存记录类型
+#define RPC_MSG_MAX          (sizeof(IPC_RpcHdr_t) + IPC_RPC_ARG_MAX)
+
+typedef struct _IPC_RpcMsg_ {
+    IPC_RpcHdr_t stHdr;
+    uint8_t  au8Data[IPC_RPC_ARG_MAX];
+} IPC_RpcMsg_t;
+
+
+// 4点滑动平均, 服务端计算, 客户端测试时用来核对结果
+static void RPC_Fir4(const int16_t *ps16In, int16_t *ps16Out, uint16_t u16Num)
+{
+    uint16_t i;
+    int32_t s32Acc = 0;
+
+    for (i = 0; i < u16Num; i++) {
+        s32Acc += ps16In[i];
+        if (i >= 4U) {
+            s32Acc -= ps16In[i - 4U];
+        }
+        // 除数必须是有符号数, 否则负的和被转换成无符号数
+        ps16Out[i] = (int16_t)(s32Acc / (int32_t)((i < 4U) ? (i + 1U) : 4U));
+    }
+}
+
+
+//----------------- used in Core M4 ---------------------
+#if defined (CORE_CM4)
+//-------------------------------------------------------
+
+static IPC_RpcFunc_t apfRpcFunc[IPC_RPC_FUNC_MAX];
+
+// 注册服务函数, 在IPC_RpcServerTask运行之前调用
+bool IPC_bRpcRegister(uint16_t u16Func, IPC_RpcFunc_t pfFunc)
+{
+    if (u16Func >= IPC_RPC_FUNC_MAX) {
+        return false;
+    }
+    apfRpcFunc[u16Func] = pfFunc;
+    return true;
+}
+
+static int16_t RPC_Echo(const void *pArgs, uint16_t u16Len, void *pRes, uint16_t *pu16ResLen)
+{
+    memcpy(pRes, pArgs, u16Len);
+    *pu16ResLen = u16Len;
+    return IPC_RPC_OK;
+}
+
+// 4点滑动平均, 参数和结果都是int16采样
+static int16_t RPC_Fir(const void *pArgs, uint16_t u16Len, void *pRes, uint16_t *pu16ResLen)
+{
+    if ((u16Len % sizeof(int16_t)) != 0U) {
+        return IPC_RPC_EARG;
+    }
+    RPC_Fir4((const int16_t *)pArgs, (int16_t *)pRes, u16Len / sizeof(int16_t));
+    *pu16ResLen = u16Len;
+    return IPC_RPC_OK;
+}
+
+// CM4: 处理所有请求, 每个请求写一个应答
+void IPC_RpcServerTask(void *pvParameters)
+{
+    static IPC_RpcMsg_t stReq, stRsp;
+    int32_t s32Len;
+    uint16_t u16Type, u16ResLen;
+    bool bSent;
+
+    (void)pvParameters;
+    (void)IPC_bRpcRegister(IPC_RPC_FN_ECHO, RPC_Echo);
+    (void)IPC_bRpcRegister(IPC_RPC_FN_FIR, RPC_Fir);
+    (void)IPC_bNotifyAttachTask(IPC_CH_RPC, xTaskGetCurrentTaskHandle());
+
+    while (1)
+    {
+        bSent = false;
+        while ((s32Len = IPC_s32RingRead(&pShareData->stRpcReq, &u16Type, &stReq, sizeof(stReq))) >= 0) {
+            if ((u16Type != RPC_REC_TYPE) || (s32Len < (int32_t)sizeof(IPC_RpcHdr_t)) || (s32Len > (int32_t)RPC_MSG_MAX)) {
+                continue;
+            }
+
+            stRsp.stHdr = stReq.stHdr;
+            u16ResLen = 0U;
+            if ((stReq.stHdr.u16Func < IPC_RPC_FUNC_MAX) && (apfRpcFunc[stReq.stHdr.u16Func] != NULL)) {
+                stRsp.stHdr.s16Status = apfRpcFunc[stReq.stHdr.u16Func](stReq.au8Data, (uint16_t)(s32Len - sizeof(IPC_RpcHdr_t)),
+                                                                         stRsp.au8Data, &u16ResLen);
+            } else {
+                stRsp.stHdr.s16Status = IPC_RPC_ENOFUNC;
+            }
+            if (u16ResLen > IPC_RPC_ARG_MAX) {
+                u16ResLen = 0U;
+                stRsp.stHdr.s16Status = IPC_RPC_EARG;
+            }
+
+            // 应答缓存满时等客户端取走, 应答不能丢; 客户端取走应答后敲门铃唤醒这里
+            while (!IPC_bRingWrite(&pShareData->stRpcRsp, RPC_REC_TYPE, &stRsp, (uint16_t)(sizeof(IPC_RpcHdr_t) + u16ResLen))) {
+                (void)IPC_bNotifySignal(IPC_CH_RPC);
+                (void)IPC_u32NotifyWait(portMAX_DELAY);
+            }
+            bSent = true;
+        }
+        if (bSent) {
+            (void)IPC_bNotifySignal(IPC_CH_RPC);
+        }
+        (void)IPC_u32NotifyWait(portMAX_DELAY);
+    }
+}
+
+//----------------- used in Core M7 ---------------------
+#else
+//-------------------------------------------------------
+
+typedef struct _IPC_RpcPending_ {
+    uint32_t u32CallId;                                // 0: 空闲
+    IPC_RpcDone_t pfDone;
+    void *pArg;
+    TickType_t xDeadline;
+} IPC_RpcPending_t;
+
+static IPC_RpcPending_t astRpcPending[IPC_RPC_PENDING_MAX];
+static uint32_t u32RpcNextId = 1U;
+static TaskHandle_t xRpcClientTask = NULL;
+static SemaphoreHandle_t xRpcSlotSem = NULL;          // 有调用完成(调用记录空出来)时释放
+
+// CM7: 发起一次调用, 不等待结果, 调用号写到pu32CallId(可以为NULL)
+// 返回值: IPC_RPC_OK; IPC_RPC_EBUSY 没有空闲的调用记录或者请求缓存满, 用IPC_bRpcWaitSlot等待后重试;
+//         IPC_RPC_EARG 参数太长或者客户端任务还没有运行
+int16_t IPC_s16RpcCall(uint16_t u16Func, const void *pArgs, uint16_t u16Len,
+                       IPC_RpcDone_t pfDone, void *pArg, uint32_t u32TimeoutMs, uint32_t *pu32CallId)
+{
+    static IPC_RpcMsg_t stReq;
+    IPC_RpcPending_t *pPend = NULL;
+    uint32_t i, u32Id = 0U;
+
+    if ((u16Len > IPC_RPC_ARG_MAX) || !ShareMem_bIsReady() || (xRpcClientTask == NULL)) {
+        return IPC_RPC_EARG;
+    }
+
+    taskENTER_CRITICAL();                              // 多个任务共用请求缓存和调用记录
+    for (i = 0; i < IPC_RPC_PENDING_MAX; i++) {
+        if (astRpcPending[i].u32CallId == 0U) {
+            pPend = &astRpcPending[i];
+            break;
+        }
+    }
+    if (pPend != NULL) {
+        u32Id = u32RpcNextId++;
+        if (u32RpcNextId == 0U) {
+            u32RpcNextId = 1U;
+        }
+        stReq.stHdr.u32CallId = u32Id;
+        stReq.stHdr.u16Func = u16Func;
+        stReq.stHdr.s16Status = IPC_RPC_OK;
+        memcpy(stReq.au8Data, pArgs, u16Len);
+        if (IPC_bRingWrite(&pShareData->stRpcReq, RPC_REC_TYPE, &stReq, (uint16_t)(sizeof(IPC_RpcHdr_t) + u16Len))) {
+            pPend->pfDone = pfDone;
+            pPend->pArg = pArg;
+            pPend->xDeadline = xTaskGetTickCount() + pdMS_TO_TICKS(u32TimeoutMs);
+            pPend->u32CallId = u32Id;
+        } else {
+            u32Id = 0U;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (u32Id == 0U) {
+        return IPC_RPC_EBUSY;
+    }
+    (void)IPC_bNotifySignal(IPC_CH_RPC);
+    if (pu32CallId != NULL) {
+        *pu32CallId = u32Id;
+    }
+    return IPC_RPC_OK;
+}
+
+// CM7: IPC_s16RpcCall返回IPC_RPC_EBUSY之后, 等一个调用完成再重试; 超时返回false
+// 完成可能发生在返回EBUSY和调用这里之间, 信号量会保留, 不会错过
+bool IPC_bRpcWaitSlot(TickType_t xTicksToWait)
+{
+    if (xRpcSlotSem == NULL) {
+        return false;
+    }
+    return (xSemaphoreTake(xRpcSlotSem, xTicksToWait) == pdTRUE);
+}
+
+// 取出调用记录, 没有找到(已经超时)返回false
+static bool RPC_bTakePending(uint32_t u32CallId, IPC_RpcPending_t *pPend)
+{
+    bool bFound = false;
+    uint32_t i;
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < IPC_RPC_PENDING_MAX; i++) {
+        if (astRpcPending[i].u32CallId == u32CallId) {
+            *pPend = astRpcPending[i];
+            astRpcPending[i].u32CallId = 0U;
+            bFound = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    if (bFound && (xRpcSlotSem != NULL)) {
+        (void)xSemaphoreGive(xRpcSlotSem);
+    }
+    return bFound;
+}
+
+// CM7: 处理应答和超时, 执行完成回调
+void IPC_RpcClientTask(void *pvParameters)
+{
+    static IPC_RpcMsg_t stRsp;
+    IPC_RpcPending_t stPend;
+    int32_t s32Len;
+    uint16_t u16Type;
+    uint32_t i;
+    TickType_t xNow;
+    bool bGot;
+
+    (void)pvParameters;
+    xRpcSlotSem = xSemaphoreCreateBinary();
+    xRpcClientTask = xTaskGetCurrentTaskHandle();
+    (void)IPC_bNotifyAttachTask(IPC_CH_RPC, xRpcClientTask);
+
+    while (1)
+    {
+        (void)IPC_u32NotifyWait(pdMS_TO_TICKS(IPC_RPC_POLL_MS));
+
+        bGot = false;
+        while ((s32Len = IPC_s32RingRead(&pShareData->stRpcRsp, &u16Type, &stRsp, sizeof(stRsp))) >= 0) {
+            bGot = true;
+            if ((u16Type != RPC_REC_TYPE) || (s32Len < (int32_t)sizeof(IPC_RpcHdr_t)) || (s32Len > (int32_t)RPC_MSG_MAX)) {
+                continue;
+            }
+            if (RPC_bTakePending(stRsp.stHdr.u32CallId, &stPend) && (stPend.pfDone != NULL)) {
+                stPend.pfDone(stPend.u32CallId, stRsp.stHdr.s16Status, stRsp.au8Data,
+                              (uint16_t)(s32Len - sizeof(IPC_RpcHdr_t)), stPend.pArg);
+            }
+        }
+        if (bGot) {
+            (void)IPC_bNotifySignal(IPC_CH_RPC);      // 应答缓存有空间了, 服务端可能在等
+        }
+
+        xNow = xTaskGetTickCount();
+        for (i = 0; i < IPC_RPC_PENDING_MAX; i++) {
+            if ((astRpcPending[i].u32CallId != 0U) && ((int32_t)(xNow - astRpcPending[i].xDeadline) >= 0)
+                && RPC_bTakePending(astRpcPending[i].u32CallId, &stPend) && (stPend.pfDone != NULL)) {
+                stPend.pfDone(stPend.u32CallId, IPC_RPC_ETIMEOUT, NULL, 0U, stPend.pArg);
+            }
+        }
+    }
+}
+
+
+#include "shell.h"
+#include "shell_port.h"
+
+#define RPC_TEST_NUM         (64U)
+#define RPC_TEST_WAIT        pdMS_TO_TICKS(200)       // 调用记录用完时等一个调用完成的时间
+
+static volatile uint32_t u32RpcTestDone = 0U, u32RpcTestErr = 0U;
+static int16_t as16RpcTestExp[RPC_TEST_NUM];           // 期望的FIR结果, 发起调用前在本地算好
+
+static void RPC_TestDone(uint32_t u32CallId, int16_t s16Status, const void *pRes, uint16_t u16Len, void *pArg)
+{
+    (void)u32CallId;
+    (void)pArg;
+    if ((s16Status != IPC_RPC_OK) || (u16Len != sizeof(as16RpcTestExp))
+        || (memcmp(pRes, as16RpcTestExp, sizeof(as16RpcTestExp)) != 0)) {
+        u32RpcTestErr++;
+    }
+    u32RpcTestDone++;
+}
+
+// shell: rpctest [count], 连续发起count个FIR调用(不等待结果), 再查看完成数
+// 超过IPC_RPC_PENDING_MAX个调用时, 返回忙就等一个调用完成后重试
+void RPC_Test(int count)
+{
+    static int16_t as16Sample[RPC_TEST_NUM];
+    uint32_t i, u32Sent = 0U, u32Busy = 0U;
+    int16_t s16Ret;
+
+    if (count <= 0) {
+        shellPrint(&shell, "rpc done %lu, err %lu\r\n", u32RpcTestDone, u32RpcTestErr);
+        return;
+    }
+    for (i = 0; i < sizeof(as16Sample) / sizeof(as16Sample[0]); i++) {
+        as16Sample[i] = (int16_t)((i & 8U) ? 1000 : -1000);
+    }
+    RPC_Fir4(as16Sample, as16RpcTestExp, RPC_TEST_NUM);
+    u32RpcTestDone = 0U;
+    u32RpcTestErr = 0U;
+    for (i = 0; i < (uint32_t)count; i++) {
+        while ((s16Ret = IPC_s16RpcCall(IPC_RPC_FN_FIR, as16Sample, sizeof(as16Sample), RPC_TestDone,
+                                        NULL, 100U, NULL)) == IPC_RPC_EBUSY) {
+            u32Busy++;
+            if (!IPC_bRpcWaitSlot(RPC_TEST_WAIT)) {
+                break;
+            }
+        }
+        if (s16Ret == IPC_RPC_OK) {
+            u32Sent++;
+        }
+    }
+    shellPrint(&shell, "rpc sent %lu/%d, busy %lu, run 'rpctest' to see result\r\n", u32Sent, count, u32Busy);
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_FUNC),
+                 rpctest, RPC_Test, CM7->CM4 RPC pipeline test [count]);
+
+//-------------------------------------------------------
+#endif
+//-------------------------------------------------------
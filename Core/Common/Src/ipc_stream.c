@@ -0,0 +1,139 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "message_buffer.h"
+#include "sharemem.h"
+#include "ipc_notify.h"
+#include "ipc_stream.h"
+
+
+typedef struct _IPC_StreamRegistry_ {
+    volatile uint32_t u32Magic;                        // IPC_STREAM_MAGIC: 通道表创建完成
+    uint32_t u32Count;
+    IPC_StreamEntry_t astEntry[IPC_STREAM_MAX];
+} IPC_StreamRegistry_t;
+
+#define pStreamReg   ((IPC_StreamRegistry_t *)pShareData->au8Stream)
+
+#if defined (CORE_CM4)
+#define STREAM_THIS_CORE     IPC_STREAM_TO_CM4
+#else
+#define STREAM_THIS_CORE     IPC_STREAM_TO_CM7
+#endif
+
+#if !defined (CORE_CM4)
+typedef struct _IPC_StreamCfg_ {
+    const char *pcName;
+    uint8_t  u8RxCore;
+    uint32_t u32Size;                                  // 数据区长度, 要能放下最大消息+4字节长度
+} IPC_StreamCfg_t;
+
+// 通道配置表, 所有通道占用的内存不能超过SHM_STREAM_SIZE
+static const IPC_StreamCfg_t astStreamCfg[] = {
+    {IPC_STREAM_CMD,      IPC_STREAM_TO_CM4, 1024U},
+    {IPC_STREAM_DATA,     IPC_STREAM_TO_CM7, 4096U},
+    {IPC_STREAM_BENCH_TX, IPC_STREAM_TO_CM4, 2U * (IPC_BENCH_MSG_MAX + 32U)},
+    {IPC_STREAM_BENCH_RX, IPC_STREAM_TO_CM7, 2U * (IPC_BENCH_MSG_MAX + 32U)},
+};
+
+#define STREAM_ALIGN(x)      (((uint32_t)(x) + (IPC_CACHE_LINE - 1U)) & ~(IPC_CACHE_LINE - 1U))
+
+// CM7: 在共享内存中创建所有通道, 在释放CM4之前调用
+static bool StreamCreate(void)
+{
+    uint32_t u32Off = STREAM_ALIGN(sizeof(IPC_StreamRegistry_t));
+    uint32_t i;
+    StaticMessageBuffer_t *pCtrl;
+    IPC_StreamEntry_t *pEntry;
+
+    pStreamReg->u32Magic = 0U;
+    pStreamReg->u32Count = 0U;
+
+    for (i = 0; i < sizeof(astStreamCfg) / sizeof(astStreamCfg[0]) && i < IPC_STREAM_MAX; i++) {
+        if ((u32Off + STREAM_ALIGN(sizeof(StaticMessageBuffer_t)) + astStreamCfg[i].u32Size) > SHM_STREAM_SIZE) {
+            return false;
+        }
+        pCtrl = (StaticMessageBuffer_t *)&pShareData->au8Stream[u32Off];
+        u32Off += STREAM_ALIGN(sizeof(StaticMessageBuffer_t));
+
+        pEntry = &pStreamReg->astEntry[i];
+        memset(pEntry, 0, sizeof(IPC_StreamEntry_t));
+        strncpy(pEntry->acName, astStreamCfg[i].pcName, IPC_STREAM_NAME_LEN - 1U);
+        pEntry->u32Size  = astStreamCfg[i].u32Size;
+        pEntry->u8RxCore = astStreamCfg[i].u8RxCore;
+        pEntry->xBuff = xMessageBufferCreateStatic(astStreamCfg[i].u32Size, &pShareData->au8Stream[u32Off], pCtrl);
+        u32Off += STREAM_ALIGN(astStreamCfg[i].u32Size);
+        pStreamReg->u32Count++;
+    }
+
+    IPC_DMB();
+    pStreamReg->u32Magic = IPC_STREAM_MAGIC;
+    return true;
+}
+#endif
+
+// 门铃中断: 对方核写入(或读出)了数据, 唤醒本核等待的任务
+// 门铃不区分通道, 接收通道为空时不唤醒: xMessageBufferReceive被唤醒后不会再等, 会返回0;
+// 发送等待被多唤醒一次没有关系, xMessageBufferSend会重新检查空间并继续等到超时.
+static void StreamNotifyHandler(uint8_t u8Ch, void *pArg)
+{
+    BaseType_t xWoken = pdFALSE;
+    uint32_t i;
+
+    (void)u8Ch;
+    (void)pArg;
+    for (i = 0; i < pStreamReg->u32Count; i++) {
+        if (pStreamReg->astEntry[i].u8RxCore == STREAM_THIS_CORE) {
+            if (xMessageBufferIsEmpty(pStreamReg->astEntry[i].xBuff) == pdFALSE) {
+                xMessageBufferSendCompletedFromISR(pStreamReg->astEntry[i].xBuff, &xWoken);
+            }
+        } else {
+            xMessageBufferReceiveCompletedFromISR(pStreamReg->astEntry[i].xBuff, &xWoken);
+        }
+    }
+    portYIELD_FROM_ISR(xWoken);
+}
+
+// CM7: 创建通道表并挂接门铃; CM4: 检查通道表并挂接门铃
+bool IPC_bStreamInit(void)
+{
+#if !defined (CORE_CM4)
+    if (!StreamCreate()) {
+        return false;
+    }
+#endif
+    if (!ShareMem_bIsReady() || (pStreamReg->u32Magic != IPC_STREAM_MAGIC)) {
+        return false;
+    }
+    return IPC_bNotifyRegister(IPC_CH_STREAM, StreamNotifyHandler, NULL);
+}
+
+// 按名字查找通道, 没有找到返回NULL
+MessageBufferHandle_t IPC_xStreamFind(const char *pcName)
+{
+    uint32_t i;
+
+    if (!ShareMem_bIsReady() || (pStreamReg->u32Magic != IPC_STREAM_MAGIC)) {
+        return NULL;
+    }
+    for (i = 0; i < pStreamReg->u32Count; i++) {
+        if (strncmp(pStreamReg->astEntry[i].acName, pcName, IPC_STREAM_NAME_LEN) == 0) {
+            return pStreamReg->astEntry[i].xBuff;
+        }
+    }
+    return NULL;
+}
+
+const IPC_StreamEntry_t *IPC_pStreamEntry(uint8_t u8Index)
+{
+    if ((pStreamReg->u32Magic != IPC_STREAM_MAGIC) || (u8Index >= pStreamReg->u32Count)) {
+        return NULL;
+    }
+    return &pStreamReg->astEntry[u8Index];
+}
@@ -0,0 +1,392 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include <limits.h>
+#include "modbus.h"
+
+
+#define MB_READ_QTY_MAX         (125U)          // 一次最多读的寄存器个数
+#define MB_WRITE_QTY_MAX        (123U)          // 一次最多写的寄存器个数
+
+// CRC16(多项式0xA001, 初值0xFFFF), 按字节查表
+static const uint16_t au16MbCrcTable[256] = {
+    0x0000U, 0xC0C1U, 0xC181U, 0x0140U, 0xC301U, 0x03C0U, 0x0280U, 0xC241U,
+    0xC601U, 0x06C0U, 0x0780U, 0xC741U, 0x0500U, 0xC5C1U, 0xC481U, 0x0440U,
+    0xCC01U, 0x0CC0U, 0x0D80U, 0xCD41U, 0x0F00U, 0xCFC1U, 0xCE81U, 0x0E40U,
+    0x0A00U, 0xCAC1U, 0xCB81U, 0x0B40U, 0xC901U, 0x09C0U, 0x0880U, 0xC841U,
+    0xD801U, 0x18C0U, 0x1980U, 0xD941U, 0x1B00U, 0xDBC1U, 0xDA81U, 0x1A40U,
+    0x1E00U, 0xDEC1U, 0xDF81U, 0x1F40U, 0xDD01U, 0x1DC0U, 0x1C80U, 0xDC41U,
+    0x1400U, 0xD4C1U, 0xD581U, 0x1540U, 0xD701U, 0x17C0U, 0x1680U, 0xD641U,
+    0xD201U, 0x12C0U, 0x1380U, 0xD341U, 0x1100U, 0xD1C1U, 0xD081U, 0x1040U,
+    0xF001U, 0x30C0U, 0x3180U, 0xF141U, 0x3300U, 0xF3C1U, 0xF281U, 0x3240U,
+    0x3600U, 0xF6C1U, 0xF781U, 0x3740U, 0xF501U, 0x35C0U, 0x3480U, 0xF441U,
+    0x3C00U, 0xFCC1U, 0xFD81U, 0x3D40U, 0xFF01U, 0x3FC0U, 0x3E80U, 0xFE41U,
+    0xFA01U, 0x3AC0U, 0x3B80U, 0xFB41U, 0x3900U, 0xF9C1U, 0xF881U, 0x3840U,
+    0x2800U, 0xE8C1U, 0xE981U, 0x2940U, 0xEB01U, 0x2BC0U, 0x2A80U, 0xEA41U,
+    0xEE01U, 0x2EC0U, 0x2F80U, 0xEF41U, 0x2D00U, 0xEDC1U, 0xEC81U, 0x2C40U,
+    0xE401U, 0x24C0U, 0x2580U, 0xE541U, 0x2700U, 0xE7C1U, 0xE681U, 0x2640U,
+    0x2200U, 0xE2C1U, 0xE381U, 0x2340U, 0xE101U, 0x21C0U, 0x2080U, 0xE041U,
+    0xA001U, 0x60C0U, 0x6180U, 0xA141U, 0x6300U, 0xA3C1U, 0xA281U, 0x6240U,
+    0x6600U, 0xA6C1U, 0xA781U, 0x6740U, 0xA501U, 0x65C0U, 0x6480U, 0xA441U,
+    0x6C00U, 0xACC1U, 0xAD81U, 0x6D40U, 0xAF01U, 0x6FC0U, 0x6E80U, 0xAE41U,
+    0xAA01U, 0x6AC0U, 0x6B80U, 0xAB41U, 0x6900U, 0xA9C1U, 0xA881U, 0x6840U,
+    0x7800U, 0xB8C1U, 0xB981U, 0x7940U, 0xBB01U, 0x7BC0U, 0x7A80U, 0xBA41U,
+    0xBE01U, 0x7EC0U, 0x7F80U, 0xBF41U, 0x7D00U, 0xBDC1U, 0xBC81U, 0x7C40U,
+    0xB401U, 0x74C0U, 0x7580U, 0xB541U, 0x7700U, 0xB7C1U, 0xB681U, 0x7640U,
+    0x7200U, 0xB2C1U, 0xB381U, 0x7340U, 0xB101U, 0x71C0U, 0x7080U, 0xB041U,
+    0x5000U, 0x90C1U, 0x9181U, 0x5140U, 0x9301U, 0x53C0U, 0x5280U, 0x9241U,
+    0x9601U, 0x56C0U, 0x5780U, 0x9741U, 0x5500U, 0x95C1U, 0x9481U, 0x5440U,
+    0x9C01U, 0x5CC0U, 0x5D80U, 0x9D41U, 0x5F00U, 0x9FC1U, 0x9E81U, 0x5E40U,
+    0x5A00U, 0x9AC1U, 0x9B81U, 0x5B40U, 0x9901U, 0x59C0U, 0x5880U, 0x9841U,
+    0x8801U, 0x48C0U, 0x4980U, 0x8941U, 0x4B00U, 0x8BC1U, 0x8A81U, 0x4A40U,
+    0x4E00U, 0x8EC1U, 0x8F81U, 0x4F40U, 0x8D01U, 0x4DC0U, 0x4C80U, 0x8C41U,
+    0x4400U, 0x84C1U, 0x8581U, 0x4540U, 0x8701U, 0x47C0U, 0x4680U, 0x8641U,
+    0x8201U, 0x42C0U, 0x4380U, 0x8341U, 0x4100U, 0x81C1U, 0x8081U, 0x4040U
+};
+
+#define MB_GET_U16(p)           ((uint16_t)(((uint16_t)(p)[0] << 8) | (p)[1]))     // 寄存器和地址都是高字节在前
+#define MB_PUT_U16(p, v)        do { (p)[0] = (uint8_t)((v) >> 8); (p)[1] = (uint8_t)(v); } while (0)
+
+
+// 对包含CRC的整帧计算, 结果为0表示CRC正确
+uint16_t MB_u16Crc(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint16_t u16Crc = 0xFFFFU;
+
+    while (u32Len-- > 0U) {
+        u16Crc = (uint16_t)((u16Crc >> 8) ^ au16MbCrcTable[(u16Crc ^ *pu8Data++) & 0xFFU]);
+    }
+    return u16Crc;
+}
+
+// 二分查找包含u16Addr的寄存器段, 没有时返回NULL
+static const MB_Reg_t *MB_pFindReg(const MB_Reg_t *pstTable, uint16_t u16Num, uint16_t u16Addr)
+{
+    uint32_t u32Lo = 0U;
+    uint32_t u32Hi = u16Num;
+    uint32_t u32Mid;
+
+    while (u32Lo < u32Hi) {
+        u32Mid = (u32Lo + u32Hi) / 2U;
+        if (u16Addr < pstTable[u32Mid].u16Addr) {
+            u32Hi = u32Mid;
+        } else if ((uint32_t)u16Addr >= ((uint32_t)pstTable[u32Mid].u16Addr + pstTable[u32Mid].u16Num)) {
+            u32Lo = u32Mid + 1U;
+        } else {
+            return &pstTable[u32Mid];
+        }
+    }
+    return NULL;
+}
+
+// 读u16Qty个寄存器, 直接写成应答的数据部分(高字节在前)
+static uint8_t MB_u8ReadRegs(const MB_Reg_t *pstTable, uint16_t u16Num, uint16_t u16Start, uint16_t u16Qty, uint8_t *pu8Out)
+{
+    const MB_Reg_t *pReg = NULL;
+    uint16_t u16Addr, u16Val;
+    uint8_t u8Ex;
+    uint32_t i;
+
+    if (((uint32_t)u16Start + u16Qty) > 0x10000U) {  // 地址不能绕回0
+        return MB_EX_ILLEGAL_ADDRESS;
+    }
+    for (i = 0U; i < u16Qty; i++) {
+        u16Addr = (uint16_t)(u16Start + i);
+        if ((pReg == NULL) || ((uint32_t)u16Addr >= ((uint32_t)pReg->u16Addr + pReg->u16Num))) {
+            pReg = MB_pFindReg(pstTable, u16Num, u16Addr);    // 跨到下一个寄存器段时才重新查找
+            if (pReg == NULL) {
+                return MB_EX_ILLEGAL_ADDRESS;
+            }
+        }
+        if (pReg->pfRead != NULL) {
+            u8Ex = pReg->pfRead(u16Addr, &u16Val);
+            if (u8Ex != MB_EX_NONE) {
+                return u8Ex;
+            }
+        } else if (pReg->pu16Data != NULL) {
+            u16Val = pReg->pu16Data[u16Addr - pReg->u16Addr];
+        } else {
+            return MB_EX_ILLEGAL_ADDRESS;
+        }
+        MB_PUT_U16(&pu8Out[2U * i], u16Val);
+    }
+    return MB_EX_NONE;
+}
+
+// 写寄存器: 先检查所有地址都可写, 再逐个写入, 避免只写了一部分
+static uint8_t MB_u8WriteRegs(const MB_Reg_t *pstTable, uint16_t u16Num, uint16_t u16Start, uint16_t u16Qty, const uint8_t *pu8Val)
+{
+    const MB_Reg_t *pReg = NULL;
+    uint16_t u16Addr, u16Val;
+    uint8_t u8Ex;
+    uint32_t i;
+
+    if (((uint32_t)u16Start + u16Qty) > 0x10000U) {
+        return MB_EX_ILLEGAL_ADDRESS;
+    }
+    for (i = 0U; i < u16Qty; i++) {
+        u16Addr = (uint16_t)(u16Start + i);
+        if ((pReg == NULL) || ((uint32_t)u16Addr >= ((uint32_t)pReg->u16Addr + pReg->u16Num))) {
+            pReg = MB_pFindReg(pstTable, u16Num, u16Addr);
+            if ((pReg == NULL) || ((pReg->pfWrite == NULL) && (pReg->pu16Data == NULL))) {
+                return MB_EX_ILLEGAL_ADDRESS;
+            }
+        }
+    }
+
+    pReg = NULL;
+    for (i = 0U; i < u16Qty; i++) {
+        u16Addr = (uint16_t)(u16Start + i);
+        if ((pReg == NULL) || ((uint32_t)u16Addr >= ((uint32_t)pReg->u16Addr + pReg->u16Num))) {
+            pReg = MB_pFindReg(pstTable, u16Num, u16Addr);
+        }
+        u16Val = MB_GET_U16(&pu8Val[2U * i]);
+        if (pReg->pfWrite != NULL) {
+            u8Ex = pReg->pfWrite(u16Addr, u16Val);
+            if (u8Ex != MB_EX_NONE) {
+                return u8Ex;
+            }
+        } else {
+            pReg->pu16Data[u16Addr - pReg->u16Addr] = u16Val;
+        }
+    }
+    return MB_EX_NONE;
+}
+
+// 处理一个完整的RTU帧(包含CRC), 应答直接写入pu8Rsp(至少MB_ADU_MAX字节, 可以是DMA发送缓存)
+// 返回值: 应答长度(包含CRC), 0 不需要应答(CRC错误、不是发给本站、广播)
+uint32_t MB_u32Process(MB_Slave_t *pSlave, const uint8_t *pu8Req, uint32_t u32ReqLen, uint8_t *pu8Rsp)
+{
+    const MB_Map_t *pMap = pSlave->pMap;
+    const uint8_t *pu8Pdu = &pu8Req[2];
+    uint32_t u32PduLen;
+    uint32_t u32RspLen = 2U;
+    uint16_t u16Start, u16Qty, u16Crc;
+    uint8_t u8Fc, u8Ex = MB_EX_NONE;
+
+    if ((u32ReqLen < MB_ADU_MIN) || (u32ReqLen > MB_ADU_MAX) || (MB_u16Crc(pu8Req, u32ReqLen) != 0U)) {
+        pSlave->stStat.u32CrcErrors++;
+        return 0U;
+    }
+    pSlave->stStat.u32Frames++;
+    if ((pu8Req[0] != pSlave->u8Addr) && (pu8Req[0] != MB_ADDR_BROADCAST)) {
+        pSlave->stStat.u32Ignored++;
+        return 0U;
+    }
+
+    u8Fc = pu8Req[1];
+    u32PduLen = u32ReqLen - MB_ADU_MIN;                 // 功能码之后, CRC之前的长度
+    switch (u8Fc) {
+    case MB_FC_READ_HOLDING:
+    case MB_FC_READ_INPUT:
+        if (u32PduLen != 4U) {
+            u8Ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        u16Start = MB_GET_U16(&pu8Pdu[0]);
+        u16Qty = MB_GET_U16(&pu8Pdu[2]);
+        if ((u16Qty == 0U) || (u16Qty > MB_READ_QTY_MAX)) {
+            u8Ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        if (u8Fc == MB_FC_READ_HOLDING) {
+            u8Ex = MB_u8ReadRegs(pMap->pstHolding, pMap->u16HoldingNum, u16Start, u16Qty, &pu8Rsp[3]);
+        } else {
+            u8Ex = MB_u8ReadRegs(pMap->pstInput, pMap->u16InputNum, u16Start, u16Qty, &pu8Rsp[3]);
+        }
+        pu8Rsp[2] = (uint8_t)(2U * u16Qty);
+        u32RspLen = 3U + 2U * u16Qty;
+        break;
+
+    case MB_FC_WRITE_SINGLE:
+        if (u32PduLen != 4U) {
+            u8Ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        u16Start = MB_GET_U16(&pu8Pdu[0]);
+        u8Ex = MB_u8WriteRegs(pMap->pstHolding, pMap->u16HoldingNum, u16Start, 1U, &pu8Pdu[2]);
+        memcpy(&pu8Rsp[2], pu8Pdu, 4U);                 // 应答和请求相同
+        u32RspLen = 6U;
+        break;
+
+    case MB_FC_WRITE_MULTIPLE:
+        if (u32PduLen < 5U) {
+            u8Ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        u16Start = MB_GET_U16(&pu8Pdu[0]);
+        u16Qty = MB_GET_U16(&pu8Pdu[2]);
+        if ((u16Qty == 0U) || (u16Qty > MB_WRITE_QTY_MAX) || (pu8Pdu[4] != (2U * u16Qty)) || (u32PduLen != (5U + pu8Pdu[4]))) {
+            u8Ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        u8Ex = MB_u8WriteRegs(pMap->pstHolding, pMap->u16HoldingNum, u16Start, u16Qty, &pu8Pdu[5]);
+        memcpy(&pu8Rsp[2], pu8Pdu, 4U);                 // 起始地址 + 个数
+        u32RspLen = 6U;
+        break;
+
+    default:
+        u8Ex = MB_EX_ILLEGAL_FUNCTION;
+        break;
+    }
+
+    if (pu8Req[0] == MB_ADDR_BROADCAST) {               // 广播只执行写操作, 不应答
+        return 0U;
+    }
+
+    pu8Rsp[0] = pSlave->u8Addr;
+    pu8Rsp[1] = u8Fc;
+    if (u8Ex != MB_EX_NONE) {
+        pu8Rsp[1] = (uint8_t)(u8Fc | 0x80U);
+        pu8Rsp[2] = u8Ex;
+        u32RspLen = 3U;
+        pSlave->stStat.u32Exceptions++;
+    }
+    u16Crc = MB_u16Crc(pu8Rsp, u32RspLen);
+    pu8Rsp[u32RspLen++] = (uint8_t)u16Crc;              // CRC低字节在前
+    pu8Rsp[u32RspLen++] = (uint8_t)(u16Crc >> 8);
+    pSlave->stStat.u32Responses++;
+
+    return u32RspLen;
+}
+
+
+//----------------- RTOS, used in Core M4 ---------------------
+#if !defined (MB_HOST)
+//-------------------------------------------------------------
+#include "FreeRTOS.h"
+#include "task.h"
+#include "usart.h"
+
+#define MB_SLAVE_ADDR           (1U)
+#define MB_HOLDING_NUM          (16U)
+#define MB_EVT_FRAME            (1UL << 0)                      // 接收超时, 有新的请求帧
+#define MB_EVT_TXDONE           (1UL << 1)                      // 应答发送完成
+
+static uint16_t au16MbHolding[MB_HOLDING_NUM];                  // 保持寄存器 0~15: 通用读写
+static uint8_t MB_u8ReadStatus(uint16_t u16Addr, uint16_t *pu16Val);
+
+static const MB_Reg_t astMbHolding[] = {
+    { 0U, MB_HOLDING_NUM, au16MbHolding, NULL, NULL },
+};
+
+static const MB_Reg_t astMbInput[] = {
+    { 0U, 8U, NULL, MB_u8ReadStatus, NULL },                    // 输入寄存器 0~7: 运行状态
+};
+
+static const MB_Map_t stMbMap = {
+    astMbHolding, (uint16_t)(sizeof(astMbHolding) / sizeof(astMbHolding[0])),
+    astMbInput, (uint16_t)(sizeof(astMbInput) / sizeof(astMbInput[0])),
+};
+
+static MB_Slave_t stMbSlave = { MB_SLAVE_ADDR, &stMbMap, { 0U } };
+static MB_Latency_t stMbLatency;
+static TaskHandle_t xMbTaskHandle = NULL;
+static uint8_t au8MbRx[MB_ADU_MAX];
+ALIGN_32BYTES(static uint8_t au8MbTx[MB_ADU_MAX]);             // 应答直接组装在DMA发送缓存里
+
+
+// 输入寄存器: 0/1 运行时间(秒, 低/高16位), 2 收到的帧数, 3 CRC错误, 4 异常应答, 5 UART错误, 6 接收丢失(含帧队列满丢弃的帧)
+static uint8_t MB_u8ReadStatus(uint16_t u16Addr, uint16_t *pu16Val)
+{
+    uint32_t u32Sec = xTaskGetTickCount() / configTICK_RATE_HZ;
+
+    switch (u16Addr) {
+    case 0U: *pu16Val = (uint16_t)u32Sec; break;
+    case 1U: *pu16Val = (uint16_t)(u32Sec >> 16); break;
+    case 2U: *pu16Val = (uint16_t)stMbSlave.stStat.u32Frames; break;
+    case 3U: *pu16Val = (uint16_t)stMbSlave.stStat.u32CrcErrors; break;
+    case 4U: *pu16Val = (uint16_t)stMbSlave.stStat.u32Exceptions; break;
+    case 5U: *pu16Val = (uint16_t)stUart8Drv.stStat.u32Errors; break;
+    case 6U: *pu16Val = (uint16_t)(stUart8Drv.stStat.u32RxLost + stUart8Drv.stStat.u32FrameDrops); break;
+    default: *pu16Val = 0U; break;
+    }
+    return MB_EX_NONE;
+}
+
+static void MB_EventFromISR(uint32_t u32Evt)
+{
+    BaseType_t xWoken = pdFALSE;
+
+    if (xMbTaskHandle != NULL) {
+        (void)xTaskNotifyFromISR(xMbTaskHandle, u32Evt, eSetBits, &xWoken);
+        portYIELD_FROM_ISR(xWoken);
+    }
+}
+
+// 接收超时(帧间隔)中断里调用
+static void MB_FrameFromISR(UartDrv_t *pDrv)
+{
+    (void)pDrv;
+    MB_EventFromISR(MB_EVT_FRAME);
+}
+
+// 应答发送完成中断里调用
+static void MB_TxDoneFromISR(void *pArg)
+{
+    (void)pArg;
+    MB_EventFromISR(MB_EVT_TXDONE);
+}
+
+// 记录一次应答延时: 请求的最后一个字节到应答开始发送
+// 时间戳是接收超时中断的时刻, 最后一个字节在这之前一个帧间隔, 把帧间隔加上, 不让它藏在统计之外
+static void MB_LatencyAdd(uint32_t u32Stamp)
+{
+    uint32_t u32Us = (DWT->CYCCNT - u32Stamp) / (SystemCoreClock / 1000000U) + stMbLatency.u32GapUs;
+
+    stMbLatency.u32LastUs = u32Us;
+    if (u32Us > stMbLatency.u32MaxUs) {
+        stMbLatency.u32MaxUs = u32Us;
+    }
+    if (stMbLatency.u32Count == 0U) {
+        stMbLatency.u32AvgUs = u32Us;
+    } else {
+        stMbLatency.u32AvgUs = (stMbLatency.u32AvgUs * 7U + u32Us) / 8U;   // 指数平均
+    }
+    stMbLatency.u32Count++;
+}
+
+const MB_Latency_t *MB_pLatency(void)
+{
+    return &stMbLatency;
+}
+
+// Modbus从站任务: 只在事件(帧结束/发送完成)时运行, 没有轮询
+// 状态由通道决定: 发送队列空且有分好的帧时处理下一帧; 应答发送期间DMA继续接收下一帧,
+// 帧结束位置在通道的帧队列里排队, 发送完成事件到来后马上处理
+void MB_Task(void *pvParameters)
+{
+    uint32_t u32Evt, u32Len, u32RspLen, u32Stamp = 0U;
+
+    (void)pvParameters;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;             // DWT周期计数器用于延时统计
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    xMbTaskHandle = xTaskGetCurrentTaskHandle();
+    if (!UartDrv_bSetRxTimeout(&stUart8Drv, MB_T35_CHAR10, MB_T35_MIN_US, MB_FrameFromISR)) {
+        vTaskDelete(NULL);
+    }
+    stMbLatency.u32GapUs = (uint32_t)(((uint64_t)stUart8Drv.u32RtoBits * 1000000U) / stUart8Drv.pPort->Init.BaudRate);
+    PutUart8ToLisen();
+
+    while (1) {
+        (void)xTaskNotifyWait(0U, ULONG_MAX, &u32Evt, portMAX_DELAY);
+
+        while ((UartDrv_u32TxPending(&stUart8Drv) == 0U) && UartDrv_bFrameReady(&stUart8Drv)) {
+            u32Len = UartDrv_u32ReadFrame(&stUart8Drv, au8MbRx, sizeof(au8MbRx), &u32Stamp);
+            if (u32Len == 0U) {
+                continue;
+            }
+            u32RspLen = MB_u32Process(&stMbSlave, au8MbRx, u32Len, au8MbTx);
+            if ((u32RspLen != 0U) && UartDrv_bSend(&stUart8Drv, au8MbTx, u32RspLen, MB_TxDoneFromISR, NULL)) {
+                MB_LatencyAdd(u32Stamp);
+            }
+        }
+    }
+}
+
+#endif
@@ -5,126 +5,281 @@
  *
  */
 #include <stdint.h>
-
-// SRAM4:   0x38000000 <----> 0x3800FFFF 64kByte
-// SRAM3:   0x30040000 <----> 0x30047FFF 32kByte
-// SRAM2:   0x30020000 <----> 0x3003FFFF 128kByte
-// SRAM1:   0x30000000 <----> 0x3001FFFF 128kByte
-// AXI RAM: 0x24000000 <----> 0x2407FFFF 512kByte
-#define SHARE_MEM_START     (0x38000000)
-#define M4_U32DATA_NUM      (64)
-#define M7_U32DATA_NUM      (64)
-#define SDATA_STATUS_EMPTY   (0) // status: 0 = empty
-#define SDATA_STATUS_HASDATA (1) // status: 1 = has data
-#define SDATA_STATUS_LOCK    (2) // status: 2 = locked
-
-
-
-typedef struct _MEM_Shared_Data_ {
-    uint8_t  u8Sts4to7;                         // status: 0 = empty, 1 = has data, 2 = locked (CM4-CM7)
-    uint8_t  u8Sts7to4;                         // status: 0 = empty, 1 = has data, 2 = locked (CM7-CM4)
-    uint32_t au32M4toM7[M4_U32DATA_NUM];        // 256 bytes from CM4 to CM7
-    uint32_t au32M7toM4[M7_U32DATA_NUM];        // 256 bytes from CM7 to CM4
-} MEM_Shared_Data_t;
- 
+#include <stddef.h>
+#include <string.h>
+#include "sharemem.h"
 
 
 #if defined ( __ICCARM__ ) /*!< IAR Compiler */
 
 #pragma location=SHARE_MEM_START
-__root volatile MEM_Shared_Data_t M7M4ShareDate;
-// volatile MEM_Shared_Data_t M7M4_ShareDate @ SHARE_MEM_START; // 这种方法也可以写
+__root MEM_Shared_Data_t M7M4ShareDate;
+// MEM_Shared_Data_t M7M4_ShareDate @ SHARE_MEM_START; // 这种方法也可以写
 
 #elif defined ( __CC_ARM )  /* MDK ARM Compiler */
 
-__attribute__((at(SHARE_MEM_START))) volatile MEM_Shared_Data_t M7M4ShareDate;
+__attribute__((at(SHARE_MEM_START))) MEM_Shared_Data_t M7M4ShareDate;
 
 #elif defined ( __GNUC__ ) /* GNU Compiler */
 
-volatile MEM_Shared_Data_t M7M4ShareDate __attribute__((section(".sharemem")));
+MEM_Shared_Data_t M7M4ShareDate __attribute__((section(".sharemem"), aligned(IPC_CACHE_LINE)));
+
+#endif
+
+MEM_Shared_Data_t *const pShareData = &M7M4ShareDate;
+
+// 共享数据不能超过SRAM4
+typedef char ShareMemSizeCheck_t[(sizeof(MEM_Shared_Data_t) <= SHARE_MEM_SIZE) ? 1 : -1];
+
+
+bool ShareMem_bIsReady(void)
+{
+    return (pShareData->u32Magic == SHARE_MEM_MAGIC);
+}
+
+
+#if defined (SHM_HOST)
+// 主机测试只有一个"核", 借出和取得用同一个块池(回环)
+#define pLendTx      (&pShareData->stLend7to4)
+#define pLendRx      (&pShareData->stLend7to4)
+#elif defined (CORE_CM4)
+#define pLendTx      (&pShareData->stLend4to7)
+#define pLendRx      (&pShareData->stLend7to4)
+#else
+#define pLendTx      (&pShareData->stLend7to4)
+#define pLendRx      (&pShareData->stLend4to7)
+#endif
+
+#if !defined (CORE_CM4)
+static void LendPoolInit(SHM_LendPool_t *pPool)
+{
+    uint32_t i;
 
+    IPC_RingInit(&pPool->stQueue, pPool->au8Queue, SHM_LEND_QSIZE);
+    for (i = 0; i < SHM_LEND_SLOTS; i++) {
+        pPool->au8State[i] = SHM_SLOT_FREE;
+        pPool->au32Gen[i] = 0U;
+    }
+    pPool->u32GenErr = 0U;
+}
+#endif
+
+// 检查借用指针是否还有效: 块号, 代号和状态都要对得上
+static bool LendCheck(SHM_LendPool_t *pPool, const SHM_Lend_t *pLend, uint8_t u8State)
+{
+    if (pLend->u16Slot >= SHM_LEND_SLOTS) {
+        return false;
+    }
+#if (SHM_LEND_CHECK == 1)
+    if ((pPool->au32Gen[pLend->u16Slot] != pLend->u32Gen) || (pPool->au8State[pLend->u16Slot] != u8State)
+        || (pLend->pu8Data != pPool->au8Slot[pLend->u16Slot])) {
+        pPool->u32GenErr++;
+        return false;
+    }
 #endif
+    return true;
+}
+
+// 生产者: 借出一个空闲块, 没有空闲块返回false
+bool SHM_bBorrow(SHM_Lend_t *pLend)
+{
+    static uint16_t u16Next = 0U;                     // 从上次借出的下一块开始找
+    SHM_LendPool_t *pPool = pLendTx;
+    uint16_t i, u16Slot;
+
+    if (!ShareMem_bIsReady()) {
+        return false;
+    }
 
-volatile MEM_Shared_Data_t *const pShareData = &M7M4ShareDate;
+    for (i = 0; i < SHM_LEND_SLOTS; i++) {
+        u16Slot = (u16Next + i) % SHM_LEND_SLOTS;
+        if (pPool->au8State[u16Slot] == SHM_SLOT_FREE) {
+            IPC_DMB();                                // 看到FREE之后再读代号
+            pPool->au8State[u16Slot] = SHM_SLOT_BORROWED;
+            pLend->pu8Data = pPool->au8Slot[u16Slot];
+            pLend->u16Size = SHM_LEND_SLOT_SIZE;
+            pLend->u16Slot = u16Slot;
+            pLend->u32Gen  = pPool->au32Gen[u16Slot];
+            u16Next = (u16Slot + 1U) % SHM_LEND_SLOTS;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 生产者: 提交已写好的块, 提交之后pLend不能再使用
+bool SHM_bCommit(SHM_Lend_t *pLend, uint16_t u16Len)
+{
+    SHM_LendPool_t *pPool = pLendTx;
+    uint16_t au16Rec[2];
+
+    if ((u16Len > SHM_LEND_SLOT_SIZE) || !LendCheck(pPool, pLend, SHM_SLOT_BORROWED)) {
+        return false;
+    }
+
+    au16Rec[0] = pLend->u16Slot;
+    au16Rec[1] = u16Len;
+    pPool->au8State[pLend->u16Slot] = SHM_SLOT_READY;
+    // 队列长度大于块数, 不会写满
+    (void)IPC_bRingWrite(&pPool->stQueue, SHM_TYPE_LEND, au16Rec, sizeof(au16Rec));
+    pLend->pu8Data = NULL;
+    IPC_bNotifySignal(IPC_CH_LEND);
+    return true;
+}
+
+// 生产者: 不提交, 直接归还借出的块(提交失败或不需要发送时), 代号加1
+bool SHM_bCancel(SHM_Lend_t *pLend)
+{
+    SHM_LendPool_t *pPool = pLendTx;
+
+    if (!LendCheck(pPool, pLend, SHM_SLOT_BORROWED)) {
+        return false;
+    }
+
+    pPool->au32Gen[pLend->u16Slot]++;
+    IPC_DMB();
+    pPool->au8State[pLend->u16Slot] = SHM_SLOT_FREE;
+    pLend->pu8Data = NULL;
+    return true;
+}
+
+// 消费者: 按提交顺序取得一块, 没有数据返回false
+bool SHM_bAcquire(SHM_Lend_t *pLend)
+{
+    SHM_LendPool_t *pPool = pLendRx;
+    uint16_t au16Rec[2];
+    uint16_t u16Type;
+
+    if (!ShareMem_bIsReady()) {
+        return false;
+    }
+    if (IPC_s32RingRead(&pPool->stQueue, &u16Type, au16Rec, sizeof(au16Rec)) != (int32_t)sizeof(au16Rec)
+        || u16Type != SHM_TYPE_LEND || au16Rec[0] >= SHM_LEND_SLOTS) {
+        return false;
+    }
+
+    pPool->au8State[au16Rec[0]] = SHM_SLOT_ACQUIRED;
+    pLend->pu8Data = pPool->au8Slot[au16Rec[0]];
+    pLend->u16Size = au16Rec[1];
+    pLend->u16Slot = au16Rec[0];
+    pLend->u32Gen  = pPool->au32Gen[au16Rec[0]];
+    return true;
+}
+
+// 消费者: 归还块, 代号加1, 之前的指针全部失效
+bool SHM_bRelease(SHM_Lend_t *pLend)
+{
+    SHM_LendPool_t *pPool = pLendRx;
+
+    if (!LendCheck(pPool, pLend, SHM_SLOT_ACQUIRED)) {
+        return false;
+    }
+
+    pPool->au32Gen[pLend->u16Slot]++;
+    IPC_DMB();                                        // 代号先更新, 再交还给生产者
+    pPool->au8State[pLend->u16Slot] = SHM_SLOT_FREE;
+    pLend->pu8Data = NULL;
+    return true;
+}
 
 
 //----------------- used in Core M4 ---------------------
 #if defined (CORE_CM4)
 //-------------------------------------------------------
 
+// send one record from M4 to M7
+bool ShareMem_bSend(uint16_t u16Type, const void *pData, uint16_t u16Len)
+{
+    if (!ShareMem_bIsReady()) {
+        return false;
+    }
+    if (!IPC_bRingWrite(&pShareData->stRing4to7, u16Type, pData, u16Len)) {
+        return false;
+    }
+    IPC_bNotifySignal(IPC_CH_MAILBOX);
+    return true;
+}
 
-uint32_t *ReadM7Data(void);           // get data from M7 to M4
-void WriteM4Data(uint32_t *dataBuff); // put data from M4 to M7
+// get one record from M7 to M4
+int32_t ShareMem_s32Receive(uint16_t *pu16Type, void *pData, uint16_t u16MaxLen)
+{
+    if (!ShareMem_bIsReady()) {
+        return -1;
+    }
+    return IPC_s32RingRead(&pShareData->stRing7to4, pu16Type, pData, u16MaxLen);
+}
 
-// get data from M7 to M4 buffer
+// send data from M4 to M7, 缓存满返回false, 数据不会被覆盖
+bool WriteM4Data(uint32_t *dataBuff)
+{
+    return ShareMem_bSend(SHM_TYPE_RAW, dataBuff, M4_U32DATA_NUM * sizeof(uint32_t));
+}
+
+// get data from M7 to M4 buffer, 没有数据返回NULL
 uint32_t *ReadM7Data(void)
 {
-	static uint32_t buffer[M7_U32DATA_NUM];                     // buffer to receive data
-	if (pShareData->u8Sts7to4 == SDATA_STATUS_HASDATA)                 // if M7 to M4 buffer has data
-	{
-		pShareData->u8Sts7to4 = SDATA_STATUS_LOCK;                  // lock the M4 to M4 buffer
-		for(int n = 0; n < M7_U32DATA_NUM; n++)
-		{
-			buffer[n] = pShareData->au32M7toM4[n];  // transfer data
-			pShareData->au32M7toM4[n] = 0;          // clear M7 to M4 buffer
-		}
-		pShareData->u8Sts7to4 = SDATA_STATUS_EMPTY;                  // M4 to M4 buffer is empty
-	}
-	return buffer;                                  // return the buffer (pointer)
-}
-
-// send data from M4 to M7
-void WriteM4Data(uint32_t *dataBuff)
-{
-	if (pShareData->u8Sts4to7 == SDATA_STATUS_EMPTY)                   // if M4 to M4 buffer is empty
-	{
-		pShareData->u8Sts4to7 = SDATA_STATUS_LOCK;                    // lock the M4 to M7 buffer
-		for(int n = 0; n < M4_U32DATA_NUM; n++)
-		{
-			pShareData->au32M4toM7[n] = dataBuff[n];  // transfer data
-			dataBuff[n] = 0;                          // clear M4 to M7 buffer
-		}
-		pShareData->u8Sts4to7 = SDATA_STATUS_HASDATA;                    // M4 to M7 buffer has data
-	}
+    static uint32_t buffer[M7_U32DATA_NUM];          // buffer to receive data
+    uint16_t u16Type;
+
+    if (ShareMem_s32Receive(&u16Type, buffer, sizeof(buffer)) < 0 || u16Type != SHM_TYPE_RAW) {
+        return NULL;
+    }
+    return buffer;
 }
 
 //----------------- used in Core M7 ---------------------
 #else
 //-------------------------------------------------------
 
-uint32_t *ReadM4Data(void);           // get data from M4 to M7
-void WriteM7Data(uint32_t *dataBuff); // put data from M7 to M4
+// 在释放CM4之前调用
+void ShareMemInit(void)
+{
+    pShareData->u32Magic = 0U;
+    IPC_RingInit(&pShareData->stRing4to7, pShareData->au8Data4to7, SHM_RING_SIZE);
+    IPC_RingInit(&pShareData->stRing7to4, pShareData->au8Data7to4, SHM_RING_SIZE);
+    IPC_RingInit(&pShareData->stRpcReq, pShareData->au8RpcReq, SHM_RPC_RING_SIZE);
+    IPC_RingInit(&pShareData->stRpcRsp, pShareData->au8RpcRsp, SHM_RPC_RING_SIZE);
+    LendPoolInit(&pShareData->stLend4to7);
+    LendPoolInit(&pShareData->stLend7to4);
+    memset(&pShareData->stNotify4to7, 0, sizeof(IPC_NotifyBits_t));
+    memset(&pShareData->stNotify7to4, 0, sizeof(IPC_NotifyBits_t));
+    memset(pShareData->astTlm, 0, sizeof(pShareData->astTlm));
+    IPC_DMB();
+    pShareData->u32Magic = SHARE_MEM_MAGIC;
+}
+
+// send one record from M7 to M4
+bool ShareMem_bSend(uint16_t u16Type, const void *pData, uint16_t u16Len)
+{
+    if (!IPC_bRingWrite(&pShareData->stRing7to4, u16Type, pData, u16Len)) {
+        return false;
+    }
+    IPC_bNotifySignal(IPC_CH_MAILBOX);
+    return true;
+}
+
+// get one record from M4 to M7
+int32_t ShareMem_s32Receive(uint16_t *pu16Type, void *pData, uint16_t u16MaxLen)
+{
+    return IPC_s32RingRead(&pShareData->stRing4to7, pu16Type, pData, u16MaxLen);
+}
+
+// send data from M7 to M4, 缓存满返回false, 数据不会被覆盖
+bool WriteM7Data(uint32_t *dataBuff)
+{
+    return ShareMem_bSend(SHM_TYPE_RAW, dataBuff, M7_U32DATA_NUM * sizeof(uint32_t));
+}
 
-// get data from M4 to M7 buffer
+// get data from M4 to M7 buffer, 没有数据返回NULL
 uint32_t *getM4Data(void)
 {
-	static uint32_t buffer[M4_U32DATA_NUM];            // buffer to receive data
-	if (pShareData->u8Sts4to7 == SDATA_STATUS_HASDATA) // if M4 to M7 buffer has data
-	{
-		pShareData->u8Sts4to7 = SDATA_STATUS_LOCK;     // lock the M4 to M7 buffer
-		for(int n = 0; n < M4_U32DATA_NUM; n++)
-		{
-			buffer[n] = pShareData->au32M4toM7[n];     // transfer data
-			pShareData->au32M4toM7[n] = 0;             // clear M4 to M7 buffer
-		}
-		pShareData->u8Sts4to7 = SDATA_STATUS_EMPTY;    // M4 to M7 buffer is empty
-	}
-	return buffer;                                     // return the buffer (pointer)
-}
-
-// send data from M7 to M4
-void WriteM7Data(uint32_t *dataBuff)
-{
-	if (pShareData->u8Sts7to4 == SDATA_STATUS_EMPTY)  // if M7 to M4 buffer is empty
-	{
-		pShareData->u8Sts7to4 = SDATA_STATUS_LOCK;    // lock the M7 to M4 buffer
-		for(int n = 0; n < M7_U32DATA_NUM; n++)
-		{
-			pShareData->au32M7toM4[n] = dataBuff[n];  // transfer data
-			dataBuff[n] = 0;                          // clear M7 to M4 buffer
-		}
-		pShareData->u8Sts7to4 = SDATA_STATUS_HASDATA; // M7 to M4 buffer has data
-	}
+    static uint32_t buffer[M4_U32DATA_NUM];          // buffer to receive data
+    uint16_t u16Type;
+
+    if (ShareMem_s32Receive(&u16Type, buffer, sizeof(buffer)) < 0 || u16Type != SHM_TYPE_RAW) {
+        return NULL;
+    }
+    return buffer;
 }
 
 //-------------------------------------------------------
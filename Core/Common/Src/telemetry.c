@@ -0,0 +1,276 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#if defined (TLM_HOST)
+#include "ipc_ring.h"
+#include "telemetry.h"
+#else
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "usart.h"
+#include "sharemem.h"
+#include "telemetry.h"
+#if defined (CORE_CM4)
+#include "modbus.h"
+#endif
+#endif
+
+
+#if !defined (TLM_HOST)
+#if defined (CORE_CM4)
+#define TLM_THIS_CORE        TLM_CORE_CM4
+#define TLM_UART_DRV         stUart8Drv
+#else
+#define TLM_THIS_CORE        TLM_CORE_CM7
+#define TLM_UART_DRV         stUart1Drv
+#endif
+
+#define TLM_STATUS_MAX       (24U)                     // uxTaskGetSystemState()的数组长度, 小于任务数时什么都取不到
+
+// 统计深度的队列, 或者用回调取占用量的缓存(例如日志环形缓存)
+static QueueHandle_t axTlmQueue[TLM_QUEUE_MAX];
+static TLM_Level_t apfTlmLevel[TLM_QUEUE_MAX];
+static char acTlmQueue[TLM_QUEUE_MAX][TLM_NAME_LEN];
+static uint8_t u8TlmQueueNum = 0U;
+#endif
+
+
+// 写一次快照, 只允许一个写者
+void TLM_Write(TLM_Block_t *pBlock, const TLM_Data_t *pData)
+{
+    uint32_t u32Seq = pBlock->u32Seq;
+
+    pBlock->u32Seq = u32Seq + 1U;                      // 奇数: 读者要重试
+    IPC_DMB();
+    memcpy(&pBlock->stData, pData, sizeof(TLM_Data_t));
+    IPC_DMB();
+    pBlock->u32Seq = u32Seq + 2U;
+}
+
+// 读一次快照, 写者正在写时重试, 返回false表示一直没读到完整的数据
+bool TLM_bRead(const TLM_Block_t *pBlock, TLM_Data_t *pData)
+{
+    uint32_t u32Seq, i;
+
+    for (i = 0; i < TLM_READ_RETRY; i++) {
+        u32Seq = pBlock->u32Seq;
+        if (u32Seq & 1U) {
+            continue;
+        }
+        IPC_DMB();
+        memcpy(pData, (const void *)&pBlock->stData, sizeof(TLM_Data_t));
+        IPC_DMB();
+        if (pBlock->u32Seq == u32Seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//----------------- RTOS, not used in host test ---------------------
+#if !defined (TLM_HOST)
+//-------------------------------------------------------------------
+
+bool TLM_bSnapshot(uint8_t u8Core, TLM_Data_t *pData)
+{
+    if ((u8Core >= TLM_CORE_NUM) || !ShareMem_bIsReady()) {
+        return false;
+    }
+    return TLM_bRead(&pShareData->astTlm[u8Core], pData);
+}
+
+// 登记需要统计深度的队列, 在TLM_Task运行之前调用
+bool TLM_bAddQueue(const char *pcName, QueueHandle_t xQueue)
+{
+    if ((xQueue == NULL) || (u8TlmQueueNum >= TLM_QUEUE_MAX)) {
+        return false;
+    }
+    strncpy(acTlmQueue[u8TlmQueueNum], pcName, TLM_NAME_LEN);
+    axTlmQueue[u8TlmQueueNum] = xQueue;
+    u8TlmQueueNum++;
+    return true;
+}
+
+// 登记不是队列的缓存(环形缓存等), 由回调返回当前占用量, 在TLM_Task运行之前调用
+bool TLM_bAddLevel(const char *pcName, TLM_Level_t pfLevel)
+{
+    if ((pfLevel == NULL) || (u8TlmQueueNum >= TLM_QUEUE_MAX)) {
+        return false;
+    }
+    strncpy(acTlmQueue[u8TlmQueueNum], pcName, TLM_NAME_LEN);
+    apfTlmLevel[u8TlmQueueNum] = pfLevel;
+    u8TlmQueueNum++;
+    return true;
+}
+
+// 串口统计, 16位的计数饱和在0xFFFF
+static uint16_t TLM_u16Sat(uint32_t u32Val)
+{
+    return (u32Val > 0xFFFFU) ? 0xFFFFU : (uint16_t)u32Val;
+}
+
+static void TLM_CollectUart(TLM_Data_t *pData, const UartDrv_Stat_t *pStat)
+{
+    pData->u32UartErr = pStat->u32Errors;
+    pData->u32UartRxBytes = pStat->u32RxBytes;
+    pData->u32UartTxBytes = pStat->u32TxBytes;
+    pData->u32UartRxFrames = pStat->u32RxFrames;
+    pData->u32UartTxFrames = pStat->u32TxFrames;
+    pData->u32UartLost = pStat->u32RxLost + pStat->u32FrameDrops;
+    pData->au16UartErr[0] = TLM_u16Sat(pStat->u32ErrParity);
+    pData->au16UartErr[1] = TLM_u16Sat(pStat->u32ErrNoise);
+    pData->au16UartErr[2] = TLM_u16Sat(pStat->u32ErrFraming);
+    pData->au16UartErr[3] = TLM_u16Sat(pStat->u32ErrOverrun);
+    pData->au16UartErr[4] = TLM_u16Sat(pStat->u32ErrDma);
+    pData->u16UartRestarts = TLM_u16Sat(pStat->u32RxRestarts);
+    pData->u16UartIsrMaxUs = TLM_u16Sat(pStat->u32IsrMaxCycles / (SystemCoreClock / 1000000U));
+    pData->u16UartTxqHigh = TLM_u16Sat(pStat->u32TxqHigh);
+}
+
+// 收集本核的统计数据
+static void TLM_Collect(TLM_Data_t *pData)
+{
+    static TaskStatus_t astStatus[TLM_STATUS_MAX];
+#if (configGENERATE_RUN_TIME_STATS == 1)
+    static configRUN_TIME_COUNTER_TYPE u32LastTotal = 0U, u32LastIdle = 0U;
+#endif
+    configRUN_TIME_COUNTER_TYPE u32Total = 0U, u32Idle = 0U;
+    UBaseType_t uxNum, i;
+
+    uxNum = uxTaskGetSystemState(astStatus, TLM_STATUS_MAX, &u32Total);
+    pData->u32TaskTotal = (uint32_t)uxTaskGetNumberOfTasks();
+    pData->u8TaskNum = 0U;
+    for (i = 0; i < uxNum; i++) {
+        if (strcmp(astStatus[i].pcTaskName, "IDLE") == 0) {
+            u32Idle = astStatus[i].ulRunTimeCounter;
+        }
+        if (pData->u8TaskNum < TLM_TASK_MAX) {
+            strncpy(pData->acTask[pData->u8TaskNum], astStatus[i].pcTaskName, TLM_NAME_LEN);
+            pData->au16StackFree[pData->u8TaskNum] = (uint16_t)astStatus[i].usStackHighWaterMark;
+            pData->u8TaskNum++;
+        }
+    }
+
+#if (configGENERATE_RUN_TIME_STATS == 1)
+    if (u32Total != u32LastTotal) {
+        pData->u16CpuLoad = (uint16_t)(10000U - (uint32_t)(((uint64_t)(u32Idle - u32LastIdle) * 10000U) / (u32Total - u32LastTotal)));
+    }
+    u32LastTotal = u32Total;
+    u32LastIdle = u32Idle;
+#else
+    (void)u32Idle;
+    pData->u16CpuLoad = TLM_LOAD_UNKNOWN;
+#endif
+
+    pData->u8QueueNum = u8TlmQueueNum;
+    for (i = 0; i < u8TlmQueueNum; i++) {
+        memcpy(pData->acQueue[i], acTlmQueue[i], TLM_NAME_LEN);
+        if (apfTlmLevel[i] != NULL) {
+            pData->au16QueueUsed[i] = TLM_u16Sat(apfTlmLevel[i]());
+        } else {
+            pData->au16QueueUsed[i] = TLM_u16Sat(uxQueueMessagesWaiting(axTlmQueue[i]));
+        }
+    }
+
+    pData->u32UpTime = xTaskGetTickCount();
+    TLM_CollectUart(pData, &TLM_UART_DRV.stStat);
+#if defined (CORE_CM4)
+    pData->u32IpcDrops = pShareData->stRing4to7.u32Drops;
+#else
+    pData->u32IpcDrops = pShareData->stRing7to4.u32Drops;
+#endif
+    pData->u32HeapFree = xPortGetFreeHeapSize();
+#if defined (CORE_CM4)
+    pData->u32RspCount = MB_pLatency()->u32Count;
+    pData->u32RspLatAvgUs = MB_pLatency()->u32AvgUs;
+    pData->u32RspLatMaxUs = MB_pLatency()->u32MaxUs;
+#endif
+    pData->u32Publish++;
+}
+
+// 固定周期发布本核的遥测数据
+void TLM_Task(void *pvParameters)
+{
+    static TLM_Data_t stData;
+    TickType_t xLastWake = xTaskGetTickCount();
+
+    (void)pvParameters;
+    memset(&stData, 0, sizeof(stData));
+    while (1)
+    {
+        if (ShareMem_bIsReady()) {
+            TLM_Collect(&stData);
+            TLM_Write(&pShareData->astTlm[TLM_THIS_CORE], &stData);
+        }
+        vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(TLM_PERIOD_MS));
+    }
+}
+
+
+//----------------- used in Core M7 ---------------------
+#if !defined (CORE_CM4)
+//-------------------------------------------------------
+#include "shell.h"
+#include "shell_port.h"
+
+static void TLM_Print(const char *pcCore, const TLM_Data_t *pData)
+{
+    uint32_t i;
+
+    shellPrint(&shell, "[%s] publish %lu, tick %lu, heap %lu, uart err %lu, ipc drops %lu\r\n",
+               pcCore, pData->u32Publish, pData->u32UpTime, pData->u32HeapFree, pData->u32UartErr, pData->u32IpcDrops);
+    if (pData->u16CpuLoad == TLM_LOAD_UNKNOWN) {
+        shellPrint(&shell, "  cpu load: -\r\n");
+    } else {
+        shellPrint(&shell, "  cpu load: %u.%02u%%\r\n", pData->u16CpuLoad / 100U, pData->u16CpuLoad % 100U);
+    }
+    if (pData->u32RspCount != 0U) {
+        shellPrint(&shell, "  uart rsp: %lu, latency from last byte avg %lu us, max %lu us\r\n",
+                   pData->u32RspCount, pData->u32RspLatAvgUs, pData->u32RspLatMaxUs);
+    }
+    shellPrint(&shell, "  uart: rx %lu B/%lu frm, tx %lu B/%lu frm, lost %lu, isr exec max %u us, txq high %u\r\n",
+               pData->u32UartRxBytes, pData->u32UartRxFrames, pData->u32UartTxBytes, pData->u32UartTxFrames,
+               pData->u32UartLost, pData->u16UartIsrMaxUs, pData->u16UartTxqHigh);
+    for (i = 0; i < pData->u8TaskNum && i < TLM_TASK_MAX; i++) {
+        shellPrint(&shell, "  task  %-8.8s stack free %u\r\n", pData->acTask[i], pData->au16StackFree[i]);
+    }
+    if (pData->u32TaskTotal > pData->u8TaskNum) {
+        shellPrint(&shell, "  task  ... %lu of %lu not shown\r\n", pData->u32TaskTotal - pData->u8TaskNum, pData->u32TaskTotal);
+    }
+    for (i = 0; i < pData->u8QueueNum && i < TLM_QUEUE_MAX; i++) {
+        shellPrint(&shell, "  queue %-8.8s used %u\r\n", pData->acQueue[i], pData->au16QueueUsed[i]);
+    }
+}
+
+// shell: telem, 打印两个核的遥测快照
+void TLM_Shell(void)
+{
+    TLM_Data_t stData;
+
+    if (TLM_bSnapshot(TLM_CORE_CM7, &stData)) {
+        TLM_Print("CM7", &stData);
+    } else {
+        shellPrint(&shell, "[CM7] no data\r\n");
+    }
+    if (TLM_bSnapshot(TLM_CORE_CM4, &stData)) {
+        TLM_Print("CM4", &stData);
+    } else {
+        shellPrint(&shell, "[CM4] no data\r\n");
+    }
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_FUNC),
+                 telem, TLM_Shell, Print CM7/CM4 telemetry snapshot);
+
+//-------------------------------------------------------
+#endif
+//-------------------------------------------------------
+
+//-------------------------------------------------------------------
+#endif
+//-------------------------------------------------------------------
@@ -0,0 +1,884 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "uart_drv.h"
+
+#if defined (UART_DRV_HOST)
+#include <unistd.h>
+#include <errno.h>
+#define UART_DRV_LOCK(state)      do { (void)(state); } while (0)
+#define UART_DRV_UNLOCK(state)    do { (void)(state); } while (0)
+#define UART_DRV_STAMP()          (0U)
+#else
+#include "stm32h7xx_ll_usart.h"
+#if (HAL_UART_ERROR_PE != UART_DRV_ERR_PARITY) || (HAL_UART_ERROR_NE != UART_DRV_ERR_NOISE) || \
+    (HAL_UART_ERROR_FE != UART_DRV_ERR_FRAMING) || (HAL_UART_ERROR_ORE != UART_DRV_ERR_OVERRUN) || \
+    (HAL_UART_ERROR_DMA != UART_DRV_ERR_DMA)
+#error "UART_DRV_ERR_xx must match HAL_UART_ERROR_xx"
+#endif
+// 任务和中断都会访问队列, 关中断保护(时间很短)
+#define UART_DRV_LOCK(state)      do { (state) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define UART_DRV_UNLOCK(state)    __set_PRIMASK(state)
+#define UART_DRV_STAMP()          (DWT->CYCCNT)         // 需要先使能DWT周期计数器
+#endif
+
+#define UART_DRV_CACHE_LINE       (32U)
+#define UART_DRV_BULK_ENTER_DIV   (4U)          // 平均突发长度达到缓存的1/4时进入批量模式
+#define UART_DRV_BULK_LEAVE_DIV   (16U)         // 低于缓存的1/16时回到空闲线模式
+
+static UartDrv_t *apUartDrv[UART_DRV_NUM];     // HAL句柄到通道的分发表
+static uint32_t u32UartDrvNum = 0U;
+
+// 中断处理函数本身的执行时间: 进入时记录DWT周期计数, 退出时更新最大值(不包括中断响应的等待时间)
+#define UART_DRV_ISR_ENTER()          uint32_t u32IsrStamp = UART_DRV_STAMP()
+#define UART_DRV_ISR_EXIT(pDrv)       UartDrv_IsrTime((pDrv), u32IsrStamp)
+
+static inline void UartDrv_IsrTime(UartDrv_t *pDrv, uint32_t u32Start)
+{
+    uint32_t u32Cycles = UART_DRV_STAMP() - u32Start;
+
+    if (u32Cycles > pDrv->stStat.u32IsrMaxCycles) {
+        pDrv->stStat.u32IsrMaxCycles = u32Cycles;
+    }
+}
+
+
+/*--------------------------------------------------------------------------------------*/
+// 底层: 目标板上是HAL+DMA, 主机测试时是伪终端
+#if defined (UART_DRV_HOST)
+
+static bool UartDrv_bPortRxStart(UartDrv_t *pDrv)
+{
+    return (pDrv->pPort->s32Fd >= 0);
+}
+
+static bool UartDrv_bPortRxTimeout(UartDrv_t *pDrv, uint32_t u32Bits)
+{
+    (void)pDrv;
+    (void)u32Bits;
+    return true;
+}
+
+static bool UartDrv_bPortRxMode(UartDrv_t *pDrv, bool bBulk)
+{
+    (void)pDrv;
+    (void)bBulk;
+    return true;
+}
+
+static uint32_t UartDrv_u32PortBaud(const UartDrv_t *pDrv)
+{
+    return (pDrv->pPort->u32Baud != 0U) ? pDrv->pPort->u32Baud : 115200U;
+}
+
+static uint32_t UartDrv_u32PortCharBits(const UartDrv_t *pDrv)
+{
+    (void)pDrv;
+    return 10U;
+}
+
+static bool UartDrv_bPortTxStart(UartDrv_t *pDrv, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    ssize_t n;
+
+    while (u32Len > 0U) {
+        n = write(pDrv->pPort->s32Fd, pu8Data, u32Len);
+        if (n < 0) {
+            if ((errno == EAGAIN) || (errno == EINTR)) {
+                continue;
+            }
+            return false;
+        }
+        pu8Data += n;
+        u32Len -= (uint32_t)n;
+    }
+    return true;                                // 发送完成事件由UartDrv_HostPoll()产生
+}
+
+static void UartDrv_PortInit(void)
+{
+}
+
+static void UartDrv_PortRxInvalidate(UartDrv_t *pDrv, uint32_t u32Off, uint32_t u32Len)
+{
+    (void)pDrv;
+    (void)u32Off;
+    (void)u32Len;
+}
+
+// 模拟DMA: 把pty里的数据读到环形缓存的当前位置, 然后产生接收事件和发送完成事件
+// 和DMA的半满/全满中断一样, 一次最多读到下一个半缓存的边界
+void UartDrv_HostPoll(UartDrv_t *pDrv)
+{
+    uint32_t u32Half = pDrv->u32RxSize / 2U;
+    ssize_t n;
+    uint16_t u16Pos;
+
+    uint32_t u32Head = pDrv->u32RxHead;
+
+    if (pDrv->u8Listen != 0U) {
+        do {
+            u16Pos = pDrv->u16RxLastPos;
+            n = read(pDrv->pPort->s32Fd, &pDrv->pu8RxBuff[u16Pos], u32Half - (u16Pos & (u32Half - 1U)));
+            if (n > 0) {
+                UartDrv_RxEventFromISR(pDrv, (uint16_t)(u16Pos + n));
+            }
+        } while (n > 0);
+        // pty里已经没有数据, 看作帧间隔超时(或空闲线事件)
+        if (u32Head != pDrv->u32RxHead) {
+            if (pDrv->pfRxFrame != NULL) {
+                UartDrv_RxTimeoutFromISR(pDrv, pDrv->u16RxLastPos);
+            } else {
+                UartDrv_RxIdleFromISR(pDrv, pDrv->u16RxLastPos);
+            }
+        }
+    }
+
+    while (pDrv->u8TxBusy != 0U) {
+        UartDrv_TxDoneFromISR(pDrv);
+    }
+}
+
+#else
+
+// 打开DWT周期计数器: 帧结束时间戳和中断处理时间都用它
+static void UartDrv_PortInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static bool UartDrv_bPortRxStart(UartDrv_t *pDrv)
+{
+    UART_HandleTypeDef *hUARTx = pDrv->pPort;
+
+    // 关闭溢出检测: 溢出错误会让HAL停止DMA接收, 关闭后只是覆盖旧数据
+    if (LL_USART_IsEnabledOverrunDetect(hUARTx->Instance)) {
+        __HAL_UART_DISABLE(hUARTx);
+        LL_USART_DisableOverrunDetect(hUARTx->Instance);
+        __HAL_UART_ENABLE(hUARTx);
+    }
+
+    return (HAL_UARTEx_ReceiveToIdle_DMA(hUARTx, pDrv->pu8RxBuff, (uint16_t)pDrv->u32RxSize) == HAL_OK);
+}
+
+// 使能接收超时: 最后一个停止位之后u32Bits个位时间没有新数据时产生RTO中断
+static bool UartDrv_bPortRxTimeout(UartDrv_t *pDrv, uint32_t u32Bits)
+{
+    UART_HandleTypeDef *hUARTx = pDrv->pPort;
+
+    if (!IS_UART_INSTANCE(hUARTx->Instance) || !IS_UART_RECEIVER_TIMEOUT_VALUE(u32Bits)) {
+        return false;
+    }
+    LL_USART_SetRxTimeout(hUARTx->Instance, u32Bits);
+    LL_USART_ClearFlag_RTO(hUARTx->Instance);
+    LL_USART_EnableRxTimeout(hUARTx->Instance);
+    LL_USART_EnableIT_RTO(hUARTx->Instance);
+    return true;
+}
+
+// 自适应接收事件的切换(中断里): 批量模式用接收超时代替空闲线中断
+static bool UartDrv_bPortRxMode(UartDrv_t *pDrv, bool bBulk)
+{
+    USART_TypeDef *pUSARTx = pDrv->pPort->Instance;
+
+    if (bBulk) {
+        if (!UartDrv_bPortRxTimeout(pDrv, pDrv->u32RtoBits)) {
+            return false;
+        }
+        LL_USART_DisableIT_IDLE(pUSARTx);
+    } else {
+        LL_USART_DisableIT_RTO(pUSARTx);
+        LL_USART_DisableRxTimeout(pUSARTx);
+        LL_USART_ClearFlag_IDLE(pUSARTx);
+        LL_USART_EnableIT_IDLE(pUSARTx);
+    }
+    return true;
+}
+
+static uint32_t UartDrv_u32PortBaud(const UartDrv_t *pDrv)
+{
+    return pDrv->pPort->Init.BaudRate;
+}
+
+// 每个字符的位数: 起始位 + 字长(STM32的字长包括校验位) + 停止位(0.5/1.5位按整位算)
+static uint32_t UartDrv_u32PortCharBits(const UartDrv_t *pDrv)
+{
+    const UART_InitTypeDef *pInit = &pDrv->pPort->Init;
+    uint32_t u32Bits;
+
+    if (pInit->WordLength == UART_WORDLENGTH_9B) {
+        u32Bits = 1U + 9U;
+    } else if (pInit->WordLength == UART_WORDLENGTH_7B) {
+        u32Bits = 1U + 7U;
+    } else {
+        u32Bits = 1U + 8U;
+    }
+    if ((pInit->StopBits == UART_STOPBITS_1_5) || (pInit->StopBits == UART_STOPBITS_2)) {
+        u32Bits += 2U;
+    } else {
+        u32Bits += 1U;
+    }
+    return u32Bits;
+}
+
+static bool UartDrv_bPortTxStart(UartDrv_t *pDrv, const uint8_t *pu8Data, uint32_t u32Len)
+{
+#if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    // 按32字节的D-Cache行清缓存, 只覆盖实际要发送的范围
+    uint32_t u32Start = (uint32_t)pu8Data & ~(UART_DRV_CACHE_LINE - 1U);
+    uint32_t u32End = ((uint32_t)pu8Data + u32Len + UART_DRV_CACHE_LINE - 1U) & ~(UART_DRV_CACHE_LINE - 1U);
+
+    SCB_CleanDCache_by_Addr((uint32_t *)u32Start, (int32_t)(u32End - u32Start));
+#endif
+    return (HAL_UART_Transmit_DMA(pDrv->pPort, (uint8_t *)pu8Data, (uint16_t)u32Len) == HAL_OK);
+}
+
+// DMA写入的数据可能还在D-Cache的旧行里, 读之前按32字节行作废
+static void UartDrv_PortRxInvalidate(UartDrv_t *pDrv, uint32_t u32Off, uint32_t u32Len)
+{
+#if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    uint32_t u32Start = u32Off & ~(UART_DRV_CACHE_LINE - 1U);
+    uint32_t u32End = (u32Off + u32Len + UART_DRV_CACHE_LINE - 1U) & ~(UART_DRV_CACHE_LINE - 1U);
+
+    SCB_InvalidateDCache_by_Addr((uint32_t *)&pDrv->pu8RxBuff[u32Start], (int32_t)(u32End - u32Start));
+#else
+    (void)pDrv;
+    (void)u32Off;
+    (void)u32Len;
+#endif
+}
+
+
+// 接收超时和校验/帧/噪声错误在HAL之前处理: HAL把它们当作阻塞错误并停止DMA接收, 这里清除标志后HAL就看不到了
+// 分帧的通道是帧结束, 自适应接收的批量模式下是突发结束
+// DMA在缓存里的位置 = 缓存长度 - DMA剩余的字节数
+void UartDrv_IRQHandler(UartDrv_t *pDrv)
+{
+    UART_DRV_ISR_ENTER();
+    USART_TypeDef *pUSARTx = pDrv->pPort->Instance;
+    uint32_t u32Isr = LL_USART_ReadReg(pUSARTx, ISR);
+    uint32_t u32Err = 0U;
+    uint32_t u32Left;
+    bool bDone = false;
+
+    // 出错的字节仍由DMA写入缓存(CR3.DDRE=0), 只计数; ICR的清除位和ISR的标志位位置相同
+    if ((u32Isr & (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE)) != 0U) {
+        LL_USART_WriteReg(pUSARTx, ICR, u32Isr & (USART_ICR_PECF | USART_ICR_FECF | USART_ICR_NECF));
+        if ((u32Isr & USART_ISR_PE) != 0U) {
+            u32Err |= UART_DRV_ERR_PARITY;
+        }
+        if ((u32Isr & USART_ISR_FE) != 0U) {
+            u32Err |= UART_DRV_ERR_FRAMING;
+        }
+        if ((u32Isr & USART_ISR_NE) != 0U) {
+            u32Err |= UART_DRV_ERR_NOISE;
+        }
+        UartDrv_ErrorFromISR(pDrv, u32Err);
+        bDone = true;
+    }
+
+    if (((u32Isr & USART_ISR_RTOF) != 0U) && LL_USART_IsEnabledIT_RTO(pUSARTx)) {
+        LL_USART_ClearFlag_RTO(pUSARTx);
+        u32Left = __HAL_DMA_GET_COUNTER(pDrv->pPort->hdmarx);
+        if (pDrv->pfRxFrame != NULL) {
+            UartDrv_RxTimeoutFromISR(pDrv, (uint16_t)(pDrv->u32RxSize - u32Left));
+        } else {
+            UartDrv_RxIdleFromISR(pDrv, (uint16_t)(pDrv->u32RxSize - u32Left));
+        }
+        bDone = true;
+    }
+
+    if (bDone) {
+        UART_DRV_ISR_EXIT(pDrv);
+    }
+}
+
+// USART接收事件中断(DMA半满/全满/空闲),回调函数,中断标志清除在上一层完成
+// u16Size是DMA在缓存里的当前位置, 全满时等于缓存长度
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t u16Size)
+{
+    UART_DRV_ISR_ENTER();
+    UartDrv_t *pDrv = UartDrv_pFind(huart);
+
+    if (pDrv != NULL) {
+        if (huart->RxEventType == HAL_UART_RXEVENT_IDLE) {
+            UartDrv_RxIdleFromISR(pDrv, u16Size);
+        } else {
+            UartDrv_RxEventFromISR(pDrv, u16Size);
+        }
+        UART_DRV_ISR_EXIT(pDrv);
+    }
+}
+
+// USART发送完成中断,回调函数,中断标志清除在上一层完成
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    UART_DRV_ISR_ENTER();
+    UartDrv_t *pDrv = UartDrv_pFind(huart);
+
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_TCF); // 清除发送完成标志
+    if (pDrv != NULL) {
+        UartDrv_TxDoneFromISR(pDrv);
+        UART_DRV_ISR_EXIT(pDrv);
+    }
+}
+
+// USART错误中断,回调函数,中断标志清除在上一层完成
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    UART_DRV_ISR_ENTER();
+    UartDrv_t *pDrv = UartDrv_pFind(huart);
+
+    // Clear the Error flags in the ICR register
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_OREF | UART_CLEAR_NEF | UART_CLEAR_PEF | UART_CLEAR_FEF);
+
+    if (pDrv != NULL) {
+        UartDrv_ErrorFromISR(pDrv, huart->ErrorCode);
+        // 噪声/帧/校验错误已在UartDrv_IRQHandler()里清除, 溢出检测已关闭, 这里只有DMA错误, 接收已停止, 马上重新启动
+        if (huart->RxState == HAL_UART_STATE_READY) {
+            pDrv->u8Listen = 0U;
+            pDrv->stStat.u32RxRestarts++;
+            (void)UartDrv_bListen(pDrv);
+        }
+        UART_DRV_ISR_EXIT(pDrv);
+    }
+}
+
+// Class Method : Send N bytes in non-blocking mode (DMA)
+// DMA1/DMA2不能访问DTCM RAM, 所以用于发送的buff需要定位到其他区域，比如D1
+bool Uart_bSend_NonBlocking(UART_HandleTypeDef *hUARTx, uint8_t *pSrcAddr, uint32_t u32DataLen)
+{
+    return UartDrv_bSend(UartDrv_pFind(hUARTx), pSrcAddr, u32DataLen, NULL, NULL);
+}
+
+#endif
+
+
+/*--------------------------------------------------------------------------------------*/
+// 初始化通道并登记到分发表
+// u32RxSize: 2的整数次幂, 32字节的整数倍, 不超过32768(DMA位置是16位)
+bool UartDrv_bInit(UartDrv_t *pDrv, const char *pName, UartDrv_Port_t *pPort, uint8_t *pu8RxBuff, uint32_t u32RxSize)
+{
+    uint32_t i;
+
+    if ((pDrv == NULL) || (pPort == NULL) || (pu8RxBuff == NULL) ||
+        (u32RxSize < UART_DRV_CACHE_LINE) || (u32RxSize > 0x8000U) || ((u32RxSize & (u32RxSize - 1U)) != 0U)) {
+        return false;
+    }
+    for (i = 0U; i < u32UartDrvNum; i++) {     // 同一个句柄重复登记时替换原来的通道
+        if (apUartDrv[i]->pPort == pPort) {
+            break;
+        }
+    }
+    if (i >= UART_DRV_NUM) {
+        return false;
+    }
+
+    UartDrv_PortInit();
+    memset(pDrv, 0, sizeof(UartDrv_t));
+    pDrv->pName = pName;
+    pDrv->pPort = pPort;
+    pDrv->pu8RxBuff = pu8RxBuff;
+    pDrv->u32RxSize = u32RxSize;
+
+    apUartDrv[i] = pDrv;
+    if (i == u32UartDrvNum) {
+        u32UartDrvNum++;
+    }
+    return true;
+}
+
+// 按HAL句柄查找通道, 没有登记时返回NULL
+UartDrv_t *UartDrv_pFind(const UartDrv_Port_t *pPort)
+{
+    uint32_t i;
+
+    for (i = 0U; i < u32UartDrvNum; i++) {
+        if (apUartDrv[i]->pPort == pPort) {
+            return apUartDrv[i];
+        }
+    }
+    return NULL;
+}
+
+// 登记的通道个数, 和按登记顺序取通道(统计/调试用)
+uint32_t UartDrv_u32Num(void)
+{
+    return u32UartDrvNum;
+}
+
+UartDrv_t *UartDrv_pGet(uint32_t u32Index)
+{
+    return (u32Index < u32UartDrvNum) ? apUartDrv[u32Index] : NULL;
+}
+
+// 清除统计, 关中断, 不会和中断里的累加冲突
+void UartDrv_ClearStat(UartDrv_t *pDrv)
+{
+    uint32_t u32State;
+
+    UART_DRV_LOCK(u32State);
+    memset(&pDrv->stStat, 0, sizeof(UartDrv_Stat_t));
+    UART_DRV_UNLOCK(u32State);
+}
+
+// 设置接收通知回调(中断里调用), 读的一方可以在这里唤醒自己
+void UartDrv_SetRxNotify(UartDrv_t *pDrv, UartDrv_RxNotify_t pfNotify, void *pArg)
+{
+    pDrv->pRxArg = pArg;
+    pDrv->pfRxNotify = pfNotify;
+}
+
+
+/*--------------------------------------------------------------------------------------*/
+// 启动循环接收, 已经启动时不做任何事
+// 在中断里重新启动时, 写索引跳到下一圈的开始, 读的一方丢弃未读的数据
+bool UartDrv_bListen(UartDrv_t *pDrv)
+{
+    if (pDrv->u8Listen == 0U) {
+        pDrv->u32RxHead = (pDrv->u32RxHead + pDrv->u32RxSize - 1U) & ~(pDrv->u32RxSize - 1U);
+        pDrv->u32RxStart = pDrv->u32RxHead;
+        pDrv->u32RxBurstHead = pDrv->u32RxHead;
+        pDrv->u16RxLastPos = 0U;
+        pDrv->u8RxResync = 0xFU;
+        if (UartDrv_bPortRxStart(pDrv)) {
+            pDrv->u8Listen = 0xFU;
+            if (pDrv->u8RxBulk != 0U) {         // HAL重新打开了空闲线中断, 从空闲线模式开始
+                pDrv->u8RxBulk = 0U;
+                (void)UartDrv_bPortRxMode(pDrv, false);
+            }
+        }
+    }
+    return (pDrv->u8Listen != 0U);
+}
+
+// 接收事件(中断里): u16Pos是DMA在缓存里的当前位置, 全满事件是缓存长度(就是下一圈的0)
+// 接收超时/空闲线读DMA计数器时DMA可能已经回绕, 全满中断还没有处理: 位置小于上次的位置, 按回绕计算长度.
+// 之后到来的全满事件报告的位置已经计入, 看起来往回走了将近一圈; 两次事件之间DMA最多前进半个缓存
+// (半满/全满中断), 所以超过3/4个缓存的长度当作过期事件丢弃
+void UartDrv_RxEventFromISR(UartDrv_t *pDrv, uint16_t u16Pos)
+{
+    uint32_t u32Size = pDrv->u32RxSize;
+    uint32_t u32Pos = (u16Pos >= u32Size) ? 0U : u16Pos;
+    uint32_t u32Len = (u32Pos - pDrv->u16RxLastPos) & (u32Size - 1U);   // 回绕时是size - last + pos
+
+    pDrv->stStat.u32RxEvents++;
+    if (u32Len > (u32Size - (u32Size >> 2))) {
+        pDrv->stStat.u32RxStale++;
+        return;
+    }
+    if (u32Len != 0U) {
+        pDrv->u32RxHead += u32Len;
+        pDrv->stStat.u32RxBytes += u32Len;
+        pDrv->u16RxLastPos = (uint16_t)u32Pos;
+        if (pDrv->pfRxNotify != NULL) {
+            pDrv->pfRxNotify(pDrv);
+        }
+    }
+}
+
+// 突发结束(空闲线事件, 或批量模式下的接收超时, 中断里): 更新平均突发长度, 选择接收事件的方式
+// 超过缓存长度的突发按缓存长度计, 批量传输结束后几次短突发就回到空闲线模式
+void UartDrv_RxIdleFromISR(UartDrv_t *pDrv, uint16_t u16Pos)
+{
+    uint32_t u32Len;
+
+    UartDrv_RxEventFromISR(pDrv, u16Pos);
+    if (pDrv->u8RxAdapt == 0U) {
+        return;
+    }
+    u32Len = pDrv->u32RxHead - pDrv->u32RxBurstHead;
+    pDrv->u32RxBurstHead = pDrv->u32RxHead;
+    if (u32Len == 0U) {
+        return;
+    }
+    if (u32Len > pDrv->u32RxSize) {
+        u32Len = pDrv->u32RxSize;
+    }
+    pDrv->u32RxBurstAvg = pDrv->u32RxBurstAvg - (pDrv->u32RxBurstAvg >> 2) + (u32Len >> 2);    // 新值占1/4
+
+    if ((pDrv->u8RxBulk == 0U) && (pDrv->u32RxBurstAvg >= (pDrv->u32RxSize / UART_DRV_BULK_ENTER_DIV))) {
+        if (UartDrv_bPortRxMode(pDrv, true)) {
+            pDrv->u8RxBulk = 0xFU;
+            pDrv->stStat.u32RxModeSwitch++;
+        }
+    } else if ((pDrv->u8RxBulk != 0U) && (pDrv->u32RxBurstAvg < (pDrv->u32RxSize / UART_DRV_BULK_LEAVE_DIV))) {
+        (void)UartDrv_bPortRxMode(pDrv, false);
+        pDrv->u8RxBulk = 0U;
+        pDrv->stStat.u32RxModeSwitch++;
+    }
+}
+
+// 取接收缓存里连续可读的数据, 不拷贝; 返回长度, *ppData指向数据
+// 读完后调用UartDrv_RxConsume()释放
+uint32_t UartDrv_u32RxPeek(UartDrv_t *pDrv, const uint8_t **ppData)
+{
+    uint32_t u32Head = pDrv->u32RxHead;
+    uint32_t u32Avail, u32Off, u32Len;
+
+    if (pDrv->u8RxResync != 0U) {
+        pDrv->u8RxResync = 0U;
+        if (pDrv->u32RxTail != pDrv->u32RxStart) {
+            pDrv->stStat.u32RxLost++;
+        }
+        pDrv->u32RxTail = pDrv->u32RxStart;     // 重新启动之后收到的数据仍然有效
+    }
+
+    u32Avail = u32Head - pDrv->u32RxTail;
+    if (u32Avail > pDrv->u32RxSize) {          // 读得太慢, 旧数据已被DMA覆盖
+        // 硬件溢出检测已关闭(UartDrv_bPortRxStart), DMA追上读索引就是这个通道的溢出
+        pDrv->stStat.u32RxLost++;
+        pDrv->stStat.u32ErrOverrun++;
+        pDrv->stStat.u32Errors++;
+        pDrv->u32RxTail = u32Head;
+        u32Avail = 0U;
+    }
+    if (u32Avail == 0U) {
+        return 0U;
+    }
+
+    u32Off = pDrv->u32RxTail & (pDrv->u32RxSize - 1U);
+    u32Len = pDrv->u32RxSize - u32Off;
+    if (u32Len > u32Avail) {
+        u32Len = u32Avail;
+    }
+
+    UartDrv_PortRxInvalidate(pDrv, u32Off, u32Len);
+    *ppData = &pDrv->pu8RxBuff[u32Off];
+    return u32Len;
+}
+
+void UartDrv_RxConsume(UartDrv_t *pDrv, uint32_t u32Len)
+{
+    pDrv->u32RxTail += u32Len;
+}
+
+// 拷贝方式读取, 返回读到的字节数
+uint32_t UartDrv_u32Read(UartDrv_t *pDrv, uint8_t *pu8Dst, uint32_t u32Max)
+{
+    const uint8_t *pu8Data = NULL;
+    uint32_t u32Total = 0U;
+    uint32_t u32Len;
+
+    while (u32Total < u32Max) {
+        u32Len = UartDrv_u32RxPeek(pDrv, &pu8Data);
+        if (u32Len == 0U) {
+            break;
+        }
+        if (u32Len > (u32Max - u32Total)) {
+            u32Len = u32Max - u32Total;
+        }
+        memcpy(&pu8Dst[u32Total], pu8Data, u32Len);
+        UartDrv_RxConsume(pDrv, u32Len);
+        u32Total += u32Len;
+    }
+    return u32Total;
+}
+
+// 读取最早的一帧(到该帧的接收超时为止), 超过u32Max的部分丢弃; pu32Stamp可以为NULL
+// 返回值: 帧长度(可能大于u32Max, 这时只拷贝了u32Max字节); 0 没有帧, 或帧已被覆盖
+uint32_t UartDrv_u32ReadFrame(UartDrv_t *pDrv, uint8_t *pu8Dst, uint32_t u32Max, uint32_t *pu32Stamp)
+{
+    const uint8_t *pu8Data = NULL;
+    const UartDrv_Frame_t *pFrame;
+    uint32_t u32End;
+    uint32_t u32Total = 0U;
+    uint32_t u32Len, u32Copy;
+
+    if (pDrv->u32RxFrameOut == pDrv->u32RxFrameIn) {
+        return 0U;
+    }
+    pFrame = &pDrv->astRxFrame[pDrv->u32RxFrameOut & (UART_DRV_FRAMEQ_DEPTH - 1U)];
+    u32End = pFrame->u32End;
+    if (pu32Stamp != NULL) {
+        *pu32Stamp = pFrame->u32Stamp;
+    }
+    pDrv->u32RxFrameOut++;
+
+    while ((int32_t)(u32End - pDrv->u32RxTail) > 0) {
+        u32Len = UartDrv_u32RxPeek(pDrv, &pu8Data);         // 可能因为重新启动/溢出移动读索引
+        if ((u32Len == 0U) || ((int32_t)(u32End - pDrv->u32RxTail) <= 0)) {
+            break;
+        }
+        if (u32Len > (u32End - pDrv->u32RxTail)) {
+            u32Len = u32End - pDrv->u32RxTail;
+        }
+        u32Copy = (u32Total < u32Max) ? (u32Max - u32Total) : 0U;
+        if (u32Copy > u32Len) {
+            u32Copy = u32Len;
+        }
+        if (u32Copy != 0U) {
+            memcpy(&pu8Dst[u32Total], pu8Data, u32Copy);
+        }
+        UartDrv_RxConsume(pDrv, u32Len);
+        u32Total += u32Len;
+    }
+    return u32Total;
+}
+
+// 返回值: true 有接收超时分好的帧可读
+bool UartDrv_bFrameReady(const UartDrv_t *pDrv)
+{
+    return (pDrv->u32RxFrameOut != pDrv->u32RxFrameIn);
+}
+
+// 返回值: true 有数据可读
+bool UartDrv_bRxReady(const UartDrv_t *pDrv)
+{
+    return (pDrv->u32RxHead != pDrv->u32RxTail);
+}
+
+
+/*--------------------------------------------------------------------------------------*/
+// 发送队列里没有正在发送的描述符时, 启动队首的描述符; 调用者需要关中断
+static void UartDrv_TxStart(UartDrv_t *pDrv)
+{
+    UartDrv_TxDesc_t *pDesc;
+
+    if ((pDrv->u8TxBusy != 0U) || (pDrv->u32TxTail == pDrv->u32TxHead)) {
+        return;
+    }
+
+    pDesc = &pDrv->astTxQ[pDrv->u32TxTail % UART_DRV_TXQ_DEPTH];
+    if (UartDrv_bPortTxStart(pDrv, pDesc->pu8Data, pDesc->u32Len)) {
+        pDrv->u8TxBusy = 0x0AU;
+    }
+    // 启动失败(UART被阻塞发送占用)时描述符留在队列里, 下一次放入或UartDrv_bTxKick()时重试
+}
+
+// 放入一个发送描述符
+// 返回值: false 队列已满(或参数错误)
+bool UartDrv_bSend(UartDrv_t *pDrv, const uint8_t *pu8Data, uint32_t u32Len, Uart_TxDone_t pfDone, void *pArg)
+{
+    UartDrv_TxDesc_t *pDesc;
+    uint32_t u32State;
+
+    if ((pDrv == NULL) || (pu8Data == NULL) || (u32Len == 0U) || (u32Len > 0xFFFFU)) {
+        return false;
+    }
+
+    UART_DRV_LOCK(u32State);
+    if ((pDrv->u32TxHead - pDrv->u32TxTail) >= UART_DRV_TXQ_DEPTH) {
+        pDrv->stStat.u32TxFull++;
+        UART_DRV_UNLOCK(u32State);
+        return false;
+    }
+    pDesc = &pDrv->astTxQ[pDrv->u32TxHead % UART_DRV_TXQ_DEPTH];
+    pDesc->pu8Data = pu8Data;
+    pDesc->u32Len = u32Len;
+    pDesc->pfDone = pfDone;
+    pDesc->pArg = pArg;
+    pDrv->u32TxHead++;
+    if ((pDrv->u32TxHead - pDrv->u32TxTail) > pDrv->stStat.u32TxqHigh) {
+        pDrv->stStat.u32TxqHigh = pDrv->u32TxHead - pDrv->u32TxTail;
+    }
+    UartDrv_TxStart(pDrv);
+    UART_DRV_UNLOCK(u32State);
+
+    return true;
+}
+
+// 发送完成事件(中断里): 退出队首描述符, 马上启动下一个(帧之间没有空闲), 再调用完成回调
+void UartDrv_TxDoneFromISR(UartDrv_t *pDrv)
+{
+    UartDrv_TxDesc_t stDone;
+
+    if (pDrv->u8TxBusy == 0U) {
+        return;
+    }
+
+    stDone = pDrv->astTxQ[pDrv->u32TxTail % UART_DRV_TXQ_DEPTH];
+    pDrv->u32TxTail++;
+    pDrv->stStat.u32TxBytes += stDone.u32Len;
+    pDrv->stStat.u32TxFrames++;
+    pDrv->u8TxBusy = 0U;
+    UartDrv_TxStart(pDrv);
+
+    if (stDone.pfDone != NULL) {
+        stDone.pfDone(stDone.pArg);
+    }
+}
+
+// 队列里有还没有启动的描述符时(UART曾被占用), 重新尝试启动
+// 返回值: true 队列空或正在发送; false 仍然启动不了
+bool UartDrv_bTxKick(UartDrv_t *pDrv)
+{
+    uint32_t u32State;
+    bool bOk;
+
+    UART_DRV_LOCK(u32State);
+    UartDrv_TxStart(pDrv);
+    bOk = ((pDrv->u8TxBusy != 0U) || (pDrv->u32TxTail == pDrv->u32TxHead));
+    UART_DRV_UNLOCK(u32State);
+    return bOk;
+}
+
+// 发送队列中的描述符个数(包括正在发送的)
+uint32_t UartDrv_u32TxPending(const UartDrv_t *pDrv)
+{
+    return (pDrv->u32TxHead - pDrv->u32TxTail);
+}
+
+// 按通道配置的波特率和字符格式把超时换算成位数: u32Char10个1/10字符时间, 且不少于u32MinUs微秒
+// 例如Modbus RTU的T3.5是(35, 1750): 波特率高于19200时固定为1.75ms
+uint32_t UartDrv_u32TimeoutBits(const UartDrv_t *pDrv, uint32_t u32Char10, uint32_t u32MinUs)
+{
+    uint32_t u32Bits = (u32Char10 * UartDrv_u32PortCharBits(pDrv) + 9U) / 10U;
+    uint32_t u32Min = (uint32_t)(((uint64_t)u32MinUs * UartDrv_u32PortBaud(pDrv) + 999999U) / 1000000U);
+
+    return (u32Bits > u32Min) ? u32Bits : u32Min;
+}
+
+// 使能接收超时(帧间隔), 超时时在中断里调用pfFrame; 超时的给法同UartDrv_u32TimeoutBits()
+// 接收超时只有一个, 通道的自适应接收事件会被关闭
+bool UartDrv_bSetRxTimeout(UartDrv_t *pDrv, uint32_t u32Char10, uint32_t u32MinUs, UartDrv_RxNotify_t pfFrame)
+{
+    uint32_t u32Bits = UartDrv_u32TimeoutBits(pDrv, u32Char10, u32MinUs);
+
+    (void)UartDrv_bSetRxAdaptive(pDrv, false);
+    pDrv->pfRxFrame = pfFrame;
+    if (!UartDrv_bPortRxTimeout(pDrv, u32Bits)) {
+        return false;
+    }
+    pDrv->u32RtoBits = u32Bits;
+    return true;
+}
+
+// 使能/关闭自适应接收事件, 从空闲线模式开始; 使能了接收超时分帧的通道不能使用
+bool UartDrv_bSetRxAdaptive(UartDrv_t *pDrv, bool bEnable)
+{
+    uint32_t u32State;
+
+    if (bEnable && (pDrv->pfRxFrame != NULL)) {
+        return false;
+    }
+
+    UART_DRV_LOCK(u32State);
+    if (pDrv->u8RxBulk != 0U) {
+        pDrv->u8RxBulk = 0U;
+        (void)UartDrv_bPortRxMode(pDrv, false);
+    }
+    pDrv->u8RxAdapt = bEnable ? 0xFU : 0U;
+    pDrv->u32RxBurstHead = pDrv->u32RxHead;
+    pDrv->u32RxBurstAvg = 0U;
+    if (pDrv->pfRxFrame == NULL) {
+        pDrv->u32RtoBits = bEnable ? UartDrv_u32TimeoutBits(pDrv, UART_DRV_BULK_CHAR10, UART_DRV_BULK_MIN_US) : 0U;
+    }
+    UART_DRV_UNLOCK(u32State);
+    return true;
+}
+
+// 接收超时事件(中断里): 先把DMA已经写入的数据计入写索引, 再记录帧结束位置
+// 帧队列满时(读的一方太慢)合并到最后一帧, 合并的帧由协议层(CRC)丢弃
+void UartDrv_RxTimeoutFromISR(UartDrv_t *pDrv, uint16_t u16Pos)
+{
+    uint32_t u32In = pDrv->u32RxFrameIn;
+    UartDrv_Frame_t *pFrame;
+
+    UartDrv_RxEventFromISR(pDrv, u16Pos);
+    pDrv->stStat.u32RxFrames++;
+    if ((u32In - pDrv->u32RxFrameOut) >= UART_DRV_FRAMEQ_DEPTH) {
+        pFrame = &pDrv->astRxFrame[(u32In - 1U) & (UART_DRV_FRAMEQ_DEPTH - 1U)];
+        pDrv->stStat.u32FrameDrops++;
+    } else {
+        pFrame = &pDrv->astRxFrame[u32In & (UART_DRV_FRAMEQ_DEPTH - 1U)];
+        u32In++;
+    }
+    pFrame->u32End = pDrv->u32RxHead;
+    pFrame->u32Stamp = UART_DRV_STAMP();
+    pDrv->u32RxFrameIn = u32In;
+    if (pDrv->pfRxFrame != NULL) {
+        pDrv->pfRxFrame(pDrv);
+    }
+}
+
+// 接收错误事件(中断里), 按类别累计次数; u32ErrCode: UART_DRV_ERR_xx的组合
+void UartDrv_ErrorFromISR(UartDrv_t *pDrv, uint32_t u32ErrCode)
+{
+    pDrv->stStat.u32Errors++;
+    if (u32ErrCode & UART_DRV_ERR_PARITY) {
+        pDrv->stStat.u32ErrParity++;
+    }
+    if (u32ErrCode & UART_DRV_ERR_NOISE) {
+        pDrv->stStat.u32ErrNoise++;
+    }
+    if (u32ErrCode & UART_DRV_ERR_FRAMING) {
+        pDrv->stStat.u32ErrFraming++;
+    }
+    if (u32ErrCode & UART_DRV_ERR_OVERRUN) {
+        pDrv->stStat.u32ErrOverrun++;
+    }
+    if (u32ErrCode & UART_DRV_ERR_DMA) {
+        pDrv->stStat.u32ErrDma++;
+    }
+}
+
+
+//----------------- used in Core M7 ---------------------
+#if !defined (CORE_CM4) && !defined (UART_DRV_HOST)
+//-------------------------------------------------------
+#include "shell.h"
+#include "shell_port.h"
+#include "telemetry.h"
+
+static void UartDrv_PrintStat(const UartDrv_t *pDrv)
+{
+    const UartDrv_Stat_t *pStat = &pDrv->stStat;
+
+    shellPrint(&shell, "[%s] rx %lu B/%lu frm, tx %lu B/%lu frm, lost %lu, frame drops %lu\r\n",
+               pDrv->pName, pStat->u32RxBytes, pStat->u32RxFrames, pStat->u32TxBytes, pStat->u32TxFrames,
+               pStat->u32RxLost, pStat->u32FrameDrops);
+    shellPrint(&shell, "  err %lu: parity %lu, noise %lu, framing %lu, overrun %lu, dma %lu, restarts %lu\r\n",
+               pStat->u32Errors, pStat->u32ErrParity, pStat->u32ErrNoise, pStat->u32ErrFraming,
+               pStat->u32ErrOverrun, pStat->u32ErrDma, pStat->u32RxRestarts);
+    shellPrint(&shell, "  txq high %lu/%u, full %lu, isr exec max %lu us\r\n",
+               pStat->u32TxqHigh, UART_DRV_TXQ_DEPTH, pStat->u32TxFull,
+               pStat->u32IsrMaxCycles / (SystemCoreClock / 1000000U));
+    shellPrint(&shell, "  rx events %lu (%lu B/evt, stale %lu), %s, rto %lu bits, burst avg %lu B, switches %lu\r\n",
+               pStat->u32RxEvents, (pStat->u32RxEvents != 0U) ? (pStat->u32RxBytes / pStat->u32RxEvents) : 0U,
+               pStat->u32RxStale,
+               (pDrv->pfRxFrame != NULL) ? "frame" : ((pDrv->u8RxBulk != 0U) ? "bulk" : "idle"),
+               pDrv->u32RtoBits, pDrv->u32RxBurstAvg, pStat->u32RxModeSwitch);
+}
+
+// shell: uartstat [clear], 本核所有通道的统计, 以及CM4协议串口的遥测
+int UartDrv_Shell(int argc, char *argv[])
+{
+    TLM_Data_t stData;
+    uint32_t i;
+
+    if ((argc == 2) && (strcmp(argv[1], "clear") == 0)) {
+        for (i = 0U; i < u32UartDrvNum; i++) {
+            UartDrv_ClearStat(apUartDrv[i]);
+        }
+    } else if (argc != 1) {
+        shellPrint(&shell, "usage: uartstat [clear]\r\n");
+        return -1;
+    }
+
+    for (i = 0U; i < u32UartDrvNum; i++) {
+        UartDrv_PrintStat(apUartDrv[i]);
+    }
+    if (TLM_bSnapshot(TLM_CORE_CM4, &stData)) {
+        shellPrint(&shell, "[CM4] rx %lu B/%lu frm, tx %lu B/%lu frm, lost %lu\r\n",
+                   stData.u32UartRxBytes, stData.u32UartRxFrames, stData.u32UartTxBytes, stData.u32UartTxFrames,
+                   stData.u32UartLost);
+        shellPrint(&shell, "  err %lu: parity %u, noise %u, framing %u, overrun %u, dma %u, restarts %u\r\n",
+                   stData.u32UartErr, stData.au16UartErr[0], stData.au16UartErr[1], stData.au16UartErr[2],
+                   stData.au16UartErr[3], stData.au16UartErr[4], stData.u16UartRestarts);
+        shellPrint(&shell, "  txq high %u/%u, isr exec max %u us\r\n",
+                   stData.u16UartTxqHigh, UART_DRV_TXQ_DEPTH, stData.u16UartIsrMaxUs);
+    }
+    return 0;
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                 uartstat, UartDrv_Shell, Show UART counters [clear]);
+
+//-------------------------------------------------------
+#endif
+//-------------------------------------------------------
@@ -0,0 +1,752 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "filexfer.h"
+
+
+#if defined (FXP_HOST)
+#include <poll.h>
+#include <time.h>
+#define FXP_LOCK(state)           do { (void)(state); } while (0)
+#define FXP_UNLOCK(state)         do { (void)(state); } while (0)
+#define FXP_POLL(pDrv)            FXP_HostPoll(pDrv)
+#define FXP_WAKE()                do { } while (0)
+#define ALIGN_32BYTES(buf)        buf __attribute__ ((aligned (32)))
+static uint32_t FXP_u32NowMs(void)
+{
+    struct timespec stTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &stTs);
+    return (uint32_t)(stTs.tv_sec * 1000U + stTs.tv_nsec / 1000000U);
+}
+
+// 等pty里的数据最多1ms, 然后模拟接收事件和发送完成中断
+static void FXP_HostPoll(UartDrv_t *pDrv)
+{
+    struct pollfd stPoll = { pDrv->pPort->s32Fd, POLLIN, 0 };
+
+    (void)poll(&stPoll, 1, 1);
+    UartDrv_HostPoll(pDrv);
+}
+#else
+#include "FreeRTOS.h"
+#include "task.h"
+#define FXP_LOCK(state)           do { (state) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define FXP_UNLOCK(state)         __set_PRIMASK(state)
+#define FXP_POLL(pDrv)            (void)ulTaskNotifyTake(pdTRUE, 1U)   // 等接收/发送完成事件, 最多一个tick
+#define FXP_WAKE()                FXP_WakeFromISR()
+#define FXP_u32NowMs()            ((uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS))
+static TaskHandle_t xFxpTask = NULL;           // 传输所在的任务(shell)
+
+// 接收事件和发送完成中断里唤醒传输任务
+static void FXP_WakeFromISR(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if ((xFxpTask != NULL) && (__get_IPSR() != 0U)) {
+        vTaskNotifyGiveFromISR(xFxpTask, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+}
+#endif
+
+#define FXP_HALF            (FXP_SLOTS / 2U)    // 双缓存的一半, 一次写文件的块数
+#define FXP_SLOT_SIZE       (((FXP_HDR_LEN + FXP_BLOCK + FXP_CRC_LEN) + 31U) & ~31U)   // 发送槽, 一整帧
+#define FXP_CTRL_SIZE       (32U)               // 控制帧缓存, 一个D-Cache行
+
+// 帧解析状态
+#define FXP_PS_SOF0         (0U)
+#define FXP_PS_SOF1         (1U)
+#define FXP_PS_HDR          (2U)
+#define FXP_PS_DATA         (3U)
+#define FXP_PS_CRC          (4U)
+
+#define FXP_MODE_RECV       (0U)
+#define FXP_MODE_SEND       (1U)
+
+typedef struct _FXP_Parser_ {
+    uint8_t  u8State;
+    uint8_t  au8Hdr[FXP_HDR_LEN - 2U];          // 类型 + 序号 + 长度
+    uint8_t  au8Crc[FXP_CRC_LEN];
+    uint8_t  u8Type;
+    uint16_t u16Len;
+    uint32_t u32Seq;
+    uint32_t u32Got;
+    uint32_t u32Crc;
+    uint8_t  *pu8Dst;                           // 数据拷贝的位置, NULL: 丢弃
+    uint8_t  au8Ctrl[FXP_CTRL_MAX];
+} FXP_Parser_t;
+
+// 传输状态, 帧在传输任务里解析, 只有au8Busy在发送完成中断里修改
+typedef struct _FXP_Ctx_ {
+    UartDrv_t *pDrv;
+    uint8_t u8Mode;
+    FXP_Parser_t stParser;
+    uint32_t u32Frames;                         // 收到的有效帧数, 用于超时判断
+    bool bCancel;
+    int32_t s32Peer;                            // 对方CAN/FIN帧里的状态
+    // 接收: 块u32Expect之前都已收到, u32Freed之前都已写入文件
+    uint32_t u32Expect;
+    uint32_t u32Freed;
+    uint32_t u32NakFor;                         // 已经为哪一块发过NAK(块号+1), 每个缺口只发一次
+    uint16_t au16Len[FXP_SLOTS];
+    bool bShort;                                // 收到过短块(只能是最后一块)
+    bool bEnd;
+    uint32_t u32EndSize;
+    uint32_t u32EndCrc;
+    // 发送: 块u32Acked之前都已确认, 可以发到u32Limit之前
+    uint32_t u32Acked;
+    uint32_t u32Limit;
+    bool bStarted;                              // 收到了对START的ACK
+    bool bRewind;                               // 收到NAK, 从u32Acked重发
+    bool bFin;
+    volatile uint8_t au8Busy[FXP_SLOTS];        // 发送槽还在UART发送队列里
+} FXP_Ctx_t;
+
+static FXP_Ctx_t stFxp;
+static FXP_Stat_t stFxpStat;
+static lfs_file_t stFxpFile;
+static uint32_t u32FxpCtrlIdx = 0U;
+static uint32_t au32FxpCrcTab[256];
+static bool bFxpCrcTab = false;
+// 接收时是FXP_SLOTS个数据块(两半各FXP_HALF块), 发送时是FXP_SLOTS个整帧
+ALIGN_32BYTES(static uint8_t au8FxpBuf[FXP_SLOTS * FXP_SLOT_SIZE]);
+ALIGN_32BYTES(static uint8_t au8FxpCtrl[UART_DRV_TXQ_DEPTH][FXP_CTRL_SIZE]);
+
+
+/*--------------------------------------------------------------------------------------*/
+// CRC32(多项式0xEDB88320, 和zlib.crc32相同), 可以分段计算: 第一段u32Crc为0
+uint32_t FXP_u32Crc32(uint32_t u32Crc, const void *pData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pData;
+    uint32_t i, j, u32Val;
+
+    if (!bFxpCrcTab) {
+        for (i = 0U; i < 256U; i++) {
+            u32Val = i;
+            for (j = 0U; j < 8U; j++) {
+                u32Val = (u32Val & 1U) ? ((u32Val >> 1) ^ 0xEDB88320UL) : (u32Val >> 1);
+            }
+            au32FxpCrcTab[i] = u32Val;
+        }
+        bFxpCrcTab = true;
+    }
+
+    u32Crc = ~u32Crc;
+    for (i = 0U; i < u32Len; i++) {
+        u32Crc = au32FxpCrcTab[(u32Crc ^ pu8Data[i]) & 0xFFU] ^ (u32Crc >> 8);
+    }
+    return ~u32Crc;
+}
+
+static void FXP_Put32(uint8_t *pu8Dst, uint32_t u32Val)
+{
+    pu8Dst[0] = (uint8_t)u32Val;
+    pu8Dst[1] = (uint8_t)(u32Val >> 8);
+    pu8Dst[2] = (uint8_t)(u32Val >> 16);
+    pu8Dst[3] = (uint8_t)(u32Val >> 24);
+}
+
+static uint32_t FXP_u32Get32(const uint8_t *pu8Src)
+{
+    return (uint32_t)pu8Src[0] | ((uint32_t)pu8Src[1] << 8) | ((uint32_t)pu8Src[2] << 16) | ((uint32_t)pu8Src[3] << 24);
+}
+
+// 组帧: 数据已经在pu8Frame[FXP_HDR_LEN]开始的位置, 填写帧头和CRC, 返回帧长度
+static uint32_t FXP_u32Build(uint8_t *pu8Frame, uint8_t u8Type, uint32_t u32Seq, uint16_t u16Len)
+{
+    uint32_t u32Crc;
+
+    pu8Frame[0] = FXP_SOF0;
+    pu8Frame[1] = FXP_SOF1;
+    pu8Frame[2] = u8Type;
+    FXP_Put32(&pu8Frame[3], u32Seq);
+    pu8Frame[7] = (uint8_t)u16Len;
+    pu8Frame[8] = (uint8_t)(u16Len >> 8);
+    u32Crc = FXP_u32Crc32(0U, &pu8Frame[2], FXP_HDR_LEN - 2U + u16Len);
+    FXP_Put32(&pu8Frame[FXP_HDR_LEN + u16Len], u32Crc);
+    return FXP_HDR_LEN + u16Len + FXP_CRC_LEN;
+}
+
+// 发送控制帧(数据是u32Num个32位数), 只在传输任务里调用
+// 发送队列里的帧都是最近放入的, 队列没满时轮到的缓存一定已经发送完成
+static bool FXP_bSendCtrl(uint8_t u8Type, uint32_t u32Seq, uint32_t u32Val0, uint32_t u32Val1, uint32_t u32Num)
+{
+    uint8_t *pu8Frame;
+    uint32_t u32Len;
+    bool bOk = false;
+
+    if (UartDrv_u32TxPending(stFxp.pDrv) < UART_DRV_TXQ_DEPTH) {
+        pu8Frame = au8FxpCtrl[u32FxpCtrlIdx % UART_DRV_TXQ_DEPTH];
+        FXP_Put32(&pu8Frame[FXP_HDR_LEN], u32Val0);
+        FXP_Put32(&pu8Frame[FXP_HDR_LEN + 4U], u32Val1);
+        u32Len = FXP_u32Build(pu8Frame, u8Type, u32Seq, (uint16_t)(u32Num * 4U));
+        bOk = UartDrv_bSend(stFxp.pDrv, pu8Frame, u32Len, NULL, NULL);
+        if (bOk) {
+            u32FxpCtrlIdx++;
+        }
+    }
+    return bOk;
+}
+
+// 接收: 确认并发放信用, 空出来的槽才能发放
+static void FXP_Ack(uint8_t u8Type)
+{
+    (void)FXP_bSendCtrl(u8Type, stFxp.u32Expect, stFxp.u32Freed + FXP_SLOTS, 0U, 1U);
+}
+
+// 接收: 每个缺口只回一次NAK, 发送方重发之后的帧按顺序到达
+static void FXP_Nak(void)
+{
+    if (stFxp.u32NakFor != (stFxp.u32Expect + 1U)) {
+        stFxp.u32NakFor = stFxp.u32Expect + 1U;
+        stFxpStat.u32Naks++;
+        FXP_Ack(FXP_T_NAK);
+    }
+}
+
+
+/*--------------------------------------------------------------------------------------*/
+// 帧头收完后决定数据放在哪里: 按顺序到达、有空槽的数据块直接拷贝到接收缓存
+static uint8_t *FXP_pu8Dst(const FXP_Parser_t *pParser)
+{
+    if (pParser->u8Type != FXP_T_DATA) {
+        return (pParser->u16Len <= FXP_CTRL_MAX) ? (uint8_t *)pParser->au8Ctrl : NULL;
+    }
+    if ((stFxp.u8Mode == FXP_MODE_RECV) && (pParser->u32Seq == stFxp.u32Expect)
+        && (pParser->u32Seq < (stFxp.u32Freed + FXP_SLOTS)) && (pParser->u16Len != 0U)
+        && !stFxp.bShort && !stFxp.bEnd) {
+        return &au8FxpBuf[(pParser->u32Seq % FXP_SLOTS) * FXP_BLOCK];
+    }
+    return NULL;
+}
+
+// 接收: 处理一个完整的帧
+static void FXP_RecvFrame(const FXP_Parser_t *pParser)
+{
+    switch (pParser->u8Type) {
+    case FXP_T_DATA:
+        if (pParser->pu8Dst != NULL) {
+            stFxp.au16Len[pParser->u32Seq % FXP_SLOTS] = pParser->u16Len;
+            stFxp.bShort = (pParser->u16Len < FXP_BLOCK);
+            stFxp.u32Expect++;
+            stFxpStat.u32Blocks++;
+            FXP_Ack(FXP_T_ACK);
+        } else if (pParser->u32Seq < stFxp.u32Expect) {
+            FXP_Ack(FXP_T_ACK);                 // 重复的块: 确认可能丢了
+        } else {
+            FXP_Nak();
+        }
+        break;
+    case FXP_T_END:
+        if ((pParser->u32Seq == stFxp.u32Expect) && (pParser->u16Len >= 8U)) {
+            stFxp.u32EndSize = FXP_u32Get32(&pParser->au8Ctrl[0]);
+            stFxp.u32EndCrc = FXP_u32Get32(&pParser->au8Ctrl[4]);
+            stFxp.bEnd = true;
+        } else {
+            FXP_Nak();
+        }
+        break;
+    case FXP_T_CAN:
+        stFxp.s32Peer = (pParser->u16Len >= 4U) ? (int32_t)FXP_u32Get32(pParser->au8Ctrl) : FXP_ERR_CANCEL;
+        stFxp.bCancel = true;
+        break;
+    default:
+        break;
+    }
+}
+
+// 发送: 处理对方的确认
+static void FXP_SendFrame(const FXP_Parser_t *pParser)
+{
+    uint32_t u32Limit;
+
+    switch (pParser->u8Type) {
+    case FXP_T_ACK:
+    case FXP_T_NAK:
+        if (pParser->u16Len < 4U) {
+            break;
+        }
+        if ((int32_t)(pParser->u32Seq - stFxp.u32Acked) > 0) {
+            stFxp.u32Acked = pParser->u32Seq;
+        }
+        u32Limit = FXP_u32Get32(pParser->au8Ctrl);
+        if ((int32_t)(u32Limit - stFxp.u32Limit) > 0) {
+            stFxp.u32Limit = u32Limit;
+        }
+        stFxp.bStarted = true;
+        if (pParser->u8Type == FXP_T_NAK) {
+            stFxpStat.u32Naks++;
+            stFxp.bRewind = true;
+        }
+        break;
+    case FXP_T_FIN:
+    case FXP_T_CAN:
+        stFxp.s32Peer = (pParser->u16Len >= 4U) ? (int32_t)FXP_u32Get32(pParser->au8Ctrl) : FXP_ERR_CANCEL;
+        if (pParser->u8Type == FXP_T_FIN) {
+            stFxp.bFin = true;
+        } else {
+            stFxp.bCancel = true;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// 逐段解析接收到的字节流, 帧之外的字节(shell回显等)都丢弃
+static void FXP_Parse(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    FXP_Parser_t *pParser = &stFxp.stParser;
+    uint32_t u32Copy;
+
+    while (u32Len > 0U) {
+        switch (pParser->u8State) {
+        case FXP_PS_SOF0:
+            if (*pu8Data == FXP_SOF0) {
+                pParser->u8State = FXP_PS_SOF1;
+            }
+            u32Copy = 1U;
+            break;
+        case FXP_PS_SOF1:
+            if (*pu8Data == FXP_SOF1) {
+                pParser->u8State = FXP_PS_HDR;
+                pParser->u32Got = 0U;
+            } else if (*pu8Data != FXP_SOF0) {
+                pParser->u8State = FXP_PS_SOF0;
+            }
+            u32Copy = 1U;
+            break;
+        case FXP_PS_HDR:
+            pParser->au8Hdr[pParser->u32Got++] = *pu8Data;
+            u32Copy = 1U;
+            if (pParser->u32Got == sizeof(pParser->au8Hdr)) {
+                pParser->u8Type = pParser->au8Hdr[0];
+                pParser->u32Seq = FXP_u32Get32(&pParser->au8Hdr[1]);
+                pParser->u16Len = (uint16_t)(pParser->au8Hdr[5] | (pParser->au8Hdr[6] << 8));
+                pParser->u32Crc = FXP_u32Crc32(0U, pParser->au8Hdr, sizeof(pParser->au8Hdr));
+                pParser->u32Got = 0U;
+                if (pParser->u16Len > FXP_BLOCK) {
+                    pParser->u8State = FXP_PS_SOF0;     // 不可能的长度, 重新找帧头
+                } else {
+                    pParser->pu8Dst = FXP_pu8Dst(pParser);
+                    pParser->u8State = (pParser->u16Len != 0U) ? FXP_PS_DATA : FXP_PS_CRC;
+                }
+            }
+            break;
+        case FXP_PS_DATA:
+            u32Copy = pParser->u16Len - pParser->u32Got;
+            if (u32Copy > u32Len) {
+                u32Copy = u32Len;
+            }
+            if (pParser->pu8Dst != NULL) {
+                memcpy(&pParser->pu8Dst[pParser->u32Got], pu8Data, u32Copy);
+            }
+            pParser->u32Crc = FXP_u32Crc32(pParser->u32Crc, pu8Data, u32Copy);
+            pParser->u32Got += u32Copy;
+            if (pParser->u32Got == pParser->u16Len) {
+                pParser->u8State = FXP_PS_CRC;
+                pParser->u32Got = 0U;
+            }
+            break;
+        default:    // FXP_PS_CRC
+            pParser->au8Crc[pParser->u32Got++] = *pu8Data;
+            u32Copy = 1U;
+            if (pParser->u32Got == FXP_CRC_LEN) {
+                pParser->u8State = FXP_PS_SOF0;
+                if (FXP_u32Get32(pParser->au8Crc) != pParser->u32Crc) {
+                    stFxpStat.u32CrcErrors++;
+                    if (stFxp.u8Mode == FXP_MODE_RECV) {
+                        FXP_Nak();
+                    }
+                } else {
+                    stFxp.u32Frames++;
+                    if (stFxp.u8Mode == FXP_MODE_RECV) {
+                        FXP_RecvFrame(pParser);
+                    } else {
+                        FXP_SendFrame(pParser);
+                    }
+                }
+            }
+            break;
+        }
+        pu8Data += u32Copy;
+        u32Len -= u32Copy;
+    }
+}
+
+// UART接收事件(中断里): 只唤醒传输任务, CRC和拷贝都不在中断里做
+static void FXP_RxNotify(UartDrv_t *pDrv)
+{
+    (void)pDrv;
+    FXP_WAKE();
+}
+
+// 传输任务: 等接收/发送完成事件, 然后直接在接收环形缓存里解析收到的字节
+// 写FLASH期间不解析, 数据留在接收缓存里(COM1_RX_BLEN要放得下整个窗口)
+static void FXP_Wait(UartDrv_t *pDrv)
+{
+    const uint8_t *pu8Data = NULL;
+    uint32_t u32Len;
+
+    FXP_POLL(pDrv);
+    while ((u32Len = UartDrv_u32RxPeek(pDrv, &pu8Data)) != 0U) {
+        FXP_Parse(pu8Data, u32Len);
+        UartDrv_RxConsume(pDrv, u32Len);
+    }
+}
+
+// 发送槽的DMA发送完成(中断里)
+static void FXP_TxDone(void *pArg)
+{
+    stFxp.au8Busy[(uintptr_t)pArg]--;
+    FXP_WAKE();
+}
+
+// 接管通道的接收, 返回原来的通知回调
+static void FXP_Attach(UartDrv_t *pDrv, uint8_t u8Mode, UartDrv_RxNotify_t *ppfOld, void **ppOldArg)
+{
+    memset(&stFxp, 0, sizeof(stFxp));
+    memset(&stFxpStat, 0, sizeof(stFxpStat));
+    stFxp.pDrv = pDrv;
+    stFxp.u8Mode = u8Mode;
+    (void)FXP_u32Crc32(0U, NULL, 0U);          // 先生成CRC表
+    *ppfOld = pDrv->pfRxNotify;
+    *ppOldArg = pDrv->pRxArg;
+    UartDrv_SetRxNotify(pDrv, FXP_RxNotify, NULL);
+}
+
+static void FXP_Detach(UartDrv_RxNotify_t pfOld, void *pOldArg, int s32Ret, uint32_t u32Start)
+{
+    UartDrv_SetRxNotify(stFxp.pDrv, pfOld, pOldArg);
+    stFxpStat.s32Result = s32Ret;
+    stFxpStat.u32Ms = FXP_u32NowMs() - u32Start;
+}
+
+
+/*--------------------------------------------------------------------------------------*/
+// 接收文件(上位机 -> 本机), 写到pcPath(覆盖)
+// 收满一半缓存后写文件并发放新的信用, 写的同时后面的数据由DMA收到UART接收缓存里
+int FXP_s32Receive(lfs_t *pLfs, UartDrv_t *pDrv, const char *pcPath)
+{
+    UartDrv_RxNotify_t pfOld;
+    void *pOldArg;
+    uint32_t u32Start, u32Last, u32Retry, u32Frames, u32Num, u32Off, u32Len, u32Crc = 0U, u32Size = 0U;
+    int s32Ret;
+
+    FXP_Attach(pDrv, FXP_MODE_RECV, &pfOld, &pOldArg);
+    u32Start = FXP_u32NowMs();
+    s32Ret = lfs_file_open(pLfs, &stFxpFile, pcPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (s32Ret < 0) {
+        (void)FXP_bSendCtrl(FXP_T_CAN, 0U, (uint32_t)s32Ret, 0U, 1U);
+        FXP_Detach(pfOld, pOldArg, s32Ret, u32Start);
+        return s32Ret;
+    }
+    u32Last = u32Start;
+    u32Retry = u32Start;
+    u32Frames = 0U;
+    FXP_Ack(FXP_T_ACK);                         // 就绪: 期望块0, 信用是整个缓存
+
+    while (1) {
+        FXP_Wait(pDrv);
+        if (stFxp.bCancel) {
+            s32Ret = FXP_ERR_CANCEL;
+            break;
+        }
+
+        u32Num = stFxp.u32Expect - stFxp.u32Freed;
+        if (u32Num >= FXP_HALF) {
+            // 一半已收满; 另一半也满了说明发送方在等信用, FLASH是瓶颈
+            if (u32Num == FXP_SLOTS) {
+                stFxpStat.u32Stalls++;
+            }
+            u32Num = FXP_HALF;
+        } else if (!stFxp.bEnd) {
+            if (stFxp.u32Frames != u32Frames) {
+                u32Frames = stFxp.u32Frames;
+                u32Last = FXP_u32NowMs();
+                u32Retry = u32Last;
+            } else if ((FXP_u32NowMs() - u32Last) >= FXP_IDLE_MS) {
+                s32Ret = FXP_ERR_TIMEOUT;
+                break;
+            } else if ((FXP_u32NowMs() - u32Retry) >= FXP_TIMEOUT_MS) {
+                // 确认、信用或者重发的块可能丢了: 定时再回NAK, 发送方从u32Expect重发
+                u32Retry = FXP_u32NowMs();
+                stFxp.u32NakFor = 0U;
+                FXP_Nak();
+            }
+            continue;
+        }
+
+        // 写入u32Num块, 只有最后一块可能是短块
+        if (u32Num != 0U) {
+            u32Off = (stFxp.u32Freed % FXP_SLOTS) * FXP_BLOCK;
+            u32Len = (u32Num - 1U) * FXP_BLOCK + stFxp.au16Len[(stFxp.u32Freed + u32Num - 1U) % FXP_SLOTS];
+            s32Ret = (int)lfs_file_write(pLfs, &stFxpFile, &au8FxpBuf[u32Off], u32Len);
+            if (s32Ret != (int)u32Len) {
+                s32Ret = (s32Ret < 0) ? s32Ret : LFS_ERR_NOSPC;
+                break;
+            }
+            s32Ret = 0;
+            u32Crc = FXP_u32Crc32(u32Crc, &au8FxpBuf[u32Off], u32Len);
+            u32Size += u32Len;
+            stFxp.u32Freed += u32Num;
+            FXP_Ack(FXP_T_ACK);                 // 新的信用
+        }
+        if (!stFxp.bEnd || (stFxp.u32Freed != stFxp.u32Expect)) {
+            continue;
+        }
+
+        // 结束: 核对长度和整个文件的CRC
+        s32Ret = lfs_file_close(pLfs, &stFxpFile);
+        if ((s32Ret == 0) && (u32Size != stFxp.u32EndSize)) {
+            s32Ret = FXP_ERR_LENGTH;
+        } else if ((s32Ret == 0) && (u32Crc != stFxp.u32EndCrc)) {
+            s32Ret = FXP_ERR_CRC;
+        }
+        if (s32Ret != 0) {
+            (void)lfs_remove(pLfs, pcPath);
+        }
+        stFxpStat.u32Bytes = u32Size;
+        (void)FXP_bSendCtrl(FXP_T_FIN, stFxp.u32Expect, (uint32_t)s32Ret, 0U, 1U);
+        FXP_Detach(pfOld, pOldArg, s32Ret, u32Start);
+        return s32Ret;
+    }
+
+    // 出错: 通知对方, 删除写了一半的文件
+    if (s32Ret != FXP_ERR_CANCEL) {
+        (void)FXP_bSendCtrl(FXP_T_CAN, stFxp.u32Expect, (uint32_t)s32Ret, 0U, 1U);
+    }
+    (void)lfs_file_close(pLfs, &stFxpFile);
+    (void)lfs_remove(pLfs, pcPath);
+    stFxpStat.u32Bytes = u32Size;
+    FXP_Detach(pfOld, pOldArg, s32Ret, u32Start);
+    return s32Ret;
+}
+
+// 发送文件(本机 -> 上位机)
+// 确认过的槽马上读入下一块, 读FLASH的同时前面的槽在DMA发送; 超时或NAK时从未确认的块重发
+int FXP_s32Send(lfs_t *pLfs, UartDrv_t *pDrv, const char *pcPath)
+{
+    UartDrv_RxNotify_t pfOld;
+    void *pOldArg;
+    uint32_t u32Start, u32Last, u32Retry, u32Acked, u32Size, u32Blocks, u32Slot;
+    uint32_t u32Filled = 0U, u32Next = 0U, u32Sent = 0U, u32Crc = 0U, u32Len, u32State;
+    uint8_t *pu8Frame;
+    lfs_soff_t s32Size = 0;
+    int s32Ret;
+    bool bOk;
+
+    FXP_Attach(pDrv, FXP_MODE_SEND, &pfOld, &pOldArg);
+    u32Start = FXP_u32NowMs();
+    s32Ret = lfs_file_open(pLfs, &stFxpFile, pcPath, LFS_O_RDONLY);
+    if (s32Ret == 0) {
+        s32Size = lfs_file_size(pLfs, &stFxpFile);
+        if (s32Size < 0) {
+            (void)lfs_file_close(pLfs, &stFxpFile);
+            s32Ret = (int)s32Size;
+        }
+    }
+    if (s32Ret < 0) {
+        (void)FXP_bSendCtrl(FXP_T_CAN, 0U, (uint32_t)s32Ret, 0U, 1U);
+        FXP_Detach(pfOld, pOldArg, s32Ret, u32Start);
+        return s32Ret;
+    }
+    u32Size = (uint32_t)s32Size;
+    u32Blocks = (u32Size + FXP_BLOCK - 1U) / FXP_BLOCK;
+
+    u32Last = u32Start - FXP_TIMEOUT_MS;
+    u32Acked = 0U;
+    s32Ret = 0;
+
+    // 开始: 等对方的第一个ACK(信用)
+    while (!stFxp.bStarted) {
+        FXP_Wait(pDrv);
+        if (stFxp.bCancel) {
+            s32Ret = FXP_ERR_CANCEL;
+        } else if ((FXP_u32NowMs() - u32Start) >= FXP_IDLE_MS) {
+            s32Ret = FXP_ERR_TIMEOUT;
+        } else if ((FXP_u32NowMs() - u32Last) >= FXP_TIMEOUT_MS) {
+            u32Last = FXP_u32NowMs();
+            (void)FXP_bSendCtrl(FXP_T_START, 0U, u32Size, 0U, 1U);
+        }
+        if (s32Ret != 0) {
+            break;
+        }
+    }
+    u32Last = FXP_u32NowMs();
+
+    while ((s32Ret == 0) && (stFxp.u32Acked != u32Blocks)) {
+        FXP_Wait(pDrv);
+        if (stFxp.bCancel) {
+            s32Ret = FXP_ERR_CANCEL;
+            break;
+        }
+
+        // 进展和重发
+        if (stFxp.u32Acked != u32Acked) {
+            u32Acked = stFxp.u32Acked;
+            u32Last = FXP_u32NowMs();
+        } else if ((FXP_u32NowMs() - u32Last) >= FXP_IDLE_MS) {
+            s32Ret = FXP_ERR_TIMEOUT;
+            break;
+        } else if (((FXP_u32NowMs() - u32Last) >= FXP_TIMEOUT_MS) && (u32Next != u32Acked)) {
+            stFxp.bRewind = true;
+            u32Last = FXP_u32NowMs();
+        }
+        if (stFxp.bRewind) {
+            stFxp.bRewind = false;
+            u32Next = u32Acked;
+        }
+
+        // 预读: 确认过的槽读入下一块
+        while ((u32Filled < u32Blocks) && (u32Filled < (u32Acked + FXP_SLOTS))
+               && (stFxp.au8Busy[u32Filled % FXP_SLOTS] == 0U)) {
+            pu8Frame = &au8FxpBuf[(u32Filled % FXP_SLOTS) * FXP_SLOT_SIZE];
+            u32Len = ((u32Filled + 1U) < u32Blocks) ? FXP_BLOCK : (u32Size - u32Filled * FXP_BLOCK);
+            s32Ret = (int)lfs_file_read(pLfs, &stFxpFile, &pu8Frame[FXP_HDR_LEN], u32Len);
+            if (s32Ret != (int)u32Len) {
+                s32Ret = (s32Ret < 0) ? s32Ret : LFS_ERR_IO;
+                break;
+            }
+            s32Ret = 0;
+            u32Crc = FXP_u32Crc32(u32Crc, &pu8Frame[FXP_HDR_LEN], u32Len);
+            (void)FXP_u32Build(pu8Frame, FXP_T_DATA, u32Filled, (uint16_t)u32Len);
+            u32Filled++;
+        }
+        if (s32Ret != 0) {
+            break;
+        }
+
+        // 在信用范围内发送
+        while ((u32Next < u32Filled) && ((int32_t)(stFxp.u32Limit - u32Next) > 0)) {
+            u32Slot = u32Next % FXP_SLOTS;
+            u32Len = ((u32Next + 1U) < u32Blocks) ? FXP_BLOCK : (u32Size - u32Next * FXP_BLOCK);
+            FXP_LOCK(u32State);
+            bOk = UartDrv_bSend(pDrv, &au8FxpBuf[u32Slot * FXP_SLOT_SIZE], FXP_HDR_LEN + u32Len + FXP_CRC_LEN,
+                                FXP_TxDone, (void *)(uintptr_t)u32Slot);
+            if (bOk) {
+                stFxp.au8Busy[u32Slot]++;
+            }
+            FXP_UNLOCK(u32State);
+            if (!bOk) {
+                break;                          // 发送队列满, 等DMA
+            }
+            if (u32Next < u32Sent) {
+                stFxpStat.u32Resends++;
+            } else {
+                stFxpStat.u32Blocks++;
+                u32Sent = u32Next + 1U;
+            }
+            u32Next++;
+        }
+    }
+    (void)lfs_file_close(pLfs, &stFxpFile);
+
+    // 结束: 发送长度和CRC, 等对方核对后的FIN
+    u32Last = FXP_u32NowMs();
+    u32Retry = u32Last - FXP_TIMEOUT_MS;
+    while ((s32Ret == 0) && !stFxp.bFin) {
+        FXP_Wait(pDrv);
+        if (stFxp.bCancel) {
+            s32Ret = FXP_ERR_CANCEL;
+        } else if ((FXP_u32NowMs() - u32Last) >= FXP_IDLE_MS) {
+            s32Ret = FXP_ERR_TIMEOUT;
+        } else if ((FXP_u32NowMs() - u32Retry) >= FXP_TIMEOUT_MS) {
+            u32Retry = FXP_u32NowMs();
+            (void)FXP_bSendCtrl(FXP_T_END, u32Blocks, u32Size, u32Crc, 2U);
+        }
+    }
+    if (stFxp.bFin) {
+        s32Ret = stFxp.s32Peer;
+    } else if (s32Ret != FXP_ERR_CANCEL) {
+        (void)FXP_bSendCtrl(FXP_T_CAN, u32Next, (uint32_t)s32Ret, 0U, 1U);
+    }
+
+    // 等还在队列里的发送槽发完, 缓存才能交还
+    while (UartDrv_u32TxPending(pDrv) != 0U) {
+        FXP_Wait(pDrv);
+    }
+    stFxpStat.u32Bytes = u32Size;
+    FXP_Detach(pfOld, pOldArg, s32Ret, u32Start);
+    return s32Ret;
+}
+
+const FXP_Stat_t *FXP_pStat(void)
+{
+    return &stFxpStat;
+}
+
+
+//-------------------------------------------------------------
+#if !defined (FXP_HOST)
+//-------------------------------------------------------------
+#include "usart.h"
+#include "littlefsapi.h"
+#include "debug_printf.h"
+#include "shell.h"
+#include "shell_port.h"
+
+#define FXP_DRAIN_MS        (500U)              // 等打印任务已经放入发送队列的日志发完
+
+extern uint8_t FileSystemStatus;
+
+// 传输期间暂停日志打印, 串口上只有传输的帧
+static int FXP_s32Shell(int argc, char *argv[], bool bPut)
+{
+    const FXP_Stat_t *pStat = FXP_pStat();
+    uint32_t u32Start;
+    int s32Ret;
+
+    if (argc != 2) {
+        shellPrint(&shell, "usage: %s <path>, run Tools/file_xfer.py on the host\r\n", argv[0]);
+        return -1;
+    }
+    if (FileSystemStatus != 0U) {
+        shellPrint(&shell, "file system not ready\r\n");
+        return -1;
+    }
+
+    LOG_Hold(true);
+    u32Start = FXP_u32NowMs();
+    while ((UartDrv_u32TxPending(&stUart1Drv) != 0U) && ((FXP_u32NowMs() - u32Start) < FXP_DRAIN_MS)) {
+        vTaskDelay(1);
+    }
+    xFxpTask = xTaskGetCurrentTaskHandle();
+    if (bPut) {
+        s32Ret = FXP_s32Receive(&lfs_ext_flash, &stUart1Drv, argv[1]);
+    } else {
+        s32Ret = FXP_s32Send(&lfs_ext_flash, &stUart1Drv, argv[1]);
+    }
+    xFxpTask = NULL;
+    LOG_Hold(false);
+
+    shellPrint(&shell, "\r\n[%s] %s: %lu bytes, %lu ms, blocks %lu, resends %lu, crc err %lu, naks %lu, stalls %lu, ret %d\r\n",
+               argv[0], argv[1], pStat->u32Bytes, pStat->u32Ms, pStat->u32Blocks, pStat->u32Resends,
+               pStat->u32CrcErrors, pStat->u32Naks, pStat->u32Stalls, s32Ret);
+    return s32Ret;
+}
+
+// shell: fxput <path>, 接收上位机发来的文件
+int FXP_PutShell(int argc, char *argv[])
+{
+    return FXP_s32Shell(argc, argv, true);
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                 fxput, FXP_PutShell, Receive a file from Tools/file_xfer.py put);
+
+// shell: fxget <path>, 把文件发给上位机
+int FXP_GetShell(int argc, char *argv[])
+{
+    return FXP_s32Shell(argc, argv, false);
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                 fxget, FXP_GetShell, Send a file to Tools/file_xfer.py get);
+
+//-------------------------------------------------------------
+#endif
+//-------------------------------------------------------------
@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file    filexfer.h
+  * @author  Drive FW team
+  * @brief   Header file of binary file transfer over the shell UART
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * shell命令fxput/fxget进入二进制传输模式, 在shell串口上收发littlefs里的文件,
+  * 上位机工具是Tools/file_xfer.py.
+  *
+  * 帧格式(小端): A5 5A | 类型(1) | 序号(4) | 长度(2) | 数据(长度) | CRC32(4, 从类型到数据)
+  * 数据块每块FXP_BLOCK字节(最后一块可以短), 序号是块号. 接收方用ACK(序号=期望的下一块,
+  * 数据=允许发送的块号上限)做累计确认和流量控制; CRC错误或缺块时回NAK, 发送方从该块重发.
+  *
+  * 接收(fxput): UART接收事件(中断)只唤醒传输任务(shell), 帧在任务里解析, CRC和拷贝到双缓存
+  * 都不占中断时间; 一半写满后写入文件, 写FLASH期间DMA继续把数据收到UART接收缓存里.
+  * 只有空出来的缓存才发放信用(上限), 在路上的数据不超过一个窗口, UART接收缓存要放得下.
+  * 发送(fxget): 文件读到发送槽里组帧后放入UART发送队列, DMA发送的同时读下一块.
+  * 最后用END帧核对文件长度和整个文件的CRC32, 对方回FIN(状态).
+  *
+  * 协议和文件操作部分只依赖littlefs和uart_drv, 主机测试时定义FXP_HOST(和UART_DRV_HOST).
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FILEXFER_H__
+#define __FILEXFER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lfs.h"
+#include "uart_drv.h"
+
+#define FXP_SOF0            (0xA5U)
+#define FXP_SOF1            (0x5AU)
+#define FXP_HDR_LEN         (9U)                // SOF + 类型 + 序号 + 长度
+#define FXP_CRC_LEN         (4U)
+#define FXP_BLOCK           (1024U)             // 数据块长度, prog_size的整数倍
+#define FXP_SLOTS           (8U)                // 收发窗口的块数, 接收时分成两半做双缓存
+#define FXP_CTRL_MAX        (16U)               // 控制帧数据的最大长度
+#define FXP_TIMEOUT_MS      (1000U)             // 没有确认时重发的时间
+#define FXP_IDLE_MS         (10000U)            // 对方一直没有响应时放弃
+
+// 帧类型
+#define FXP_T_START         ('S')               // 发送方开始, 数据: 文件长度
+#define FXP_T_DATA          ('D')               // 数据块, 序号: 块号
+#define FXP_T_END           ('E')               // 结束, 序号: 块数, 数据: 文件长度, 文件CRC32
+#define FXP_T_ACK           ('A')               // 序号: 期望的下一块, 数据: 允许发送的块号上限(不含)
+#define FXP_T_NAK           ('N')               // 同ACK, 发送方从序号处重发
+#define FXP_T_FIN           ('F')               // 接收方的结果, 数据: 状态(0成功)
+#define FXP_T_CAN           ('C')               // 取消, 数据: 原因
+
+// 错误码, 和littlefs的错误码(负数)一起使用
+#define FXP_ERR_TIMEOUT     (-1001)
+#define FXP_ERR_CANCEL      (-1002)
+#define FXP_ERR_LENGTH      (-1003)
+#define FXP_ERR_CRC         (-1004)
+#define FXP_ERR_UART        (-1005)
+
+typedef struct _FXP_Stat_ {
+    uint32_t u32Bytes;                          // 最近一次传输的文件长度
+    uint32_t u32Blocks;                         // 收到(或发出)的数据块数
+    uint32_t u32Resends;                        // 重发的数据块数
+    uint32_t u32CrcErrors;                      // CRC错误的帧数
+    uint32_t u32Naks;                           // 发出(或收到)的NAK数
+    uint32_t u32Stalls;                         // 接收时两半缓存都满, 等待写FLASH的次数
+    uint32_t u32Ms;                             // 传输用时
+    int32_t  s32Result;
+} FXP_Stat_t;
+
+
+uint32_t FXP_u32Crc32(uint32_t u32Crc, const void *pData, uint32_t u32Len);
+
+// 传输期间独占pDrv的接收和发送; 不是线程安全的
+int FXP_s32Receive(lfs_t *pLfs, UartDrv_t *pDrv, const char *pcPath);
+int FXP_s32Send(lfs_t *pLfs, UartDrv_t *pDrv, const char *pcPath);
+const FXP_Stat_t *FXP_pStat(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __FILEXFER_H__ */
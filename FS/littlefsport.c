@@ -11,6 +11,11 @@
 #include "shell_port.h"
 #include <string.h>
 #include "stdio.h"
+#ifdef LFS_THREADSAFE
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
 
 
 #define READ_PROG_BYTEMIN       128   // 读/写的最小字节数, 所有的读写都是该数的整数倍
@@ -45,6 +50,9 @@ static int BSP_FS_UnLock(const struct lfs_config *c);
 //uint8_t FS_Look_Buff[LOOKAHEADE_SIZE] __attribute__ ((aligned (8)));//__ALIGN_END;
 
 lfs_t lfs_ext_flash;
+#ifdef LFS_THREADSAFE
+static SemaphoreHandle_t xMutex_Lfs = NULL;  // 日志任务和shell的文件操作互斥
+#endif
 lfs_file_t file_ext_flash;
 uint8_t FileSystemStatus = 0U;    // 0:normal, !0:abnormal
 
@@ -106,6 +114,9 @@ void FileSystemIint(void)
 {
     // 初始化文件服务器
     // memset(FileLocSer, 0, sizeof(FileLocSer));
+#ifdef LFS_THREADSAFE
+    xMutex_Lfs = xSemaphoreCreateRecursiveMutex();
+#endif
 
     // mount the filesystem
     int err = lfs_mount(&lfs_ext_flash, &lfs_cfg_ext_flash);
@@ -201,15 +212,24 @@ static int BSP_FS_Sync(const struct lfs_config *c)
 }
 
 #ifdef LFS_THREADSAFE // 使能线程安全
+// 调度器启动之前不需要加锁
 static int BSP_FS_Lock(const struct lfs_config *c)
 {
     (void)c;
+    if ((xMutex_Lfs == NULL) || (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)) {
+        return 0;
+    }
+    (void)xSemaphoreTakeRecursive(xMutex_Lfs, portMAX_DELAY);
     return 0;
 }
 
 static int BSP_FS_UnLock(const struct lfs_config *c)
 {
     (void)c;
+    if ((xMutex_Lfs == NULL) || (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)) {
+        return 0;
+    }
+    (void)xSemaphoreGiveRecursive(xMutex_Lfs);
     return 0;
 }
 #endif
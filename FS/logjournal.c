@@ -0,0 +1,395 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include <stdio.h>
+#include "logjournal.h"
+
+
+#define LOGJ_PATH_LEN       (16U)
+#define LOGJ_READ_SIZE      (128U)              // logcat一次读出的长度
+
+static lfs_t *pLogjFs = NULL;
+static lfs_file_t stLogjFile;
+static bool bLogjOpen = false;
+static bool bLogjReopen = false;               // 轮转失败后当前文件也没能打开, 下次写时再试
+static uint32_t u32LogjSize = 0U;              // 当前文件长度(包括已写入未sync的部分)
+static uint32_t u32LogjUnsynced = 0U;          // 上次sync之后写入的字节数
+static uint8_t au8LogjBatch[LOGJ_BATCH];
+static uint32_t u32LogjBatchLen = 0U;
+static LOGJ_Stat_t stLogjStat;
+
+
+static void LOGJ_Path(char *pcPath, uint32_t u32Idx)
+{
+    (void)snprintf(pcPath, LOGJ_PATH_LEN, "%s/%lu", LOGJ_DIR, (unsigned long)u32Idx);
+}
+
+static int LOGJ_s32Err(int s32Err)
+{
+    if (s32Err < 0) {
+        stLogjStat.s32LastErr = s32Err;
+    }
+    return s32Err;
+}
+
+// 打开当前文件(log/0), 追加写
+static int LOGJ_s32OpenCurrent(int s32Flags)
+{
+    char acPath[LOGJ_PATH_LEN];
+    lfs_soff_t s32Size;
+    int s32Err;
+
+    LOGJ_Path(acPath, 0U);
+    s32Err = lfs_file_open(pLogjFs, &stLogjFile, acPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND | s32Flags);
+    if (s32Err < 0) {
+        return LOGJ_s32Err(s32Err);
+    }
+    s32Size = lfs_file_size(pLogjFs, &stLogjFile);
+    if (s32Size < 0) {
+        (void)lfs_file_close(pLogjFs, &stLogjFile);
+        return LOGJ_s32Err((int)s32Size);
+    }
+    u32LogjSize = (uint32_t)s32Size;
+    u32LogjUnsynced = 0U;
+    bLogjOpen = true;
+    return 0;
+}
+
+// 轮转: 删除最老的文件, 其余文件序号加1, 重新建立log/0
+// 每一步都是littlefs的原子操作, 掉电后最多少一个文件, 不会损坏
+// 中途失败时重新打开log/0(没有改名的就还是原来的文件)接着写, 下一块再轮转
+static int LOGJ_s32Rotate(void)
+{
+    char acOld[LOGJ_PATH_LEN], acNew[LOGJ_PATH_LEN];
+    uint32_t i;
+    int s32Err;
+
+    bLogjOpen = false;
+    s32Err = lfs_file_close(pLogjFs, &stLogjFile);
+
+    if (s32Err >= 0) {
+        LOGJ_Path(acOld, LOGJ_FILE_NUM - 1U);
+        s32Err = lfs_remove(pLogjFs, acOld);
+        s32Err = (s32Err == LFS_ERR_NOENT) ? 0 : s32Err;
+    }
+    for (i = LOGJ_FILE_NUM - 1U; (i > 0U) && (s32Err >= 0); i--) {
+        LOGJ_Path(acOld, i - 1U);
+        LOGJ_Path(acNew, i);
+        s32Err = lfs_rename(pLogjFs, acOld, acNew);
+        s32Err = (s32Err == LFS_ERR_NOENT) ? 0 : s32Err;
+    }
+
+    if (s32Err < 0) {
+        (void)LOGJ_s32Err(s32Err);
+        bLogjReopen = (LOGJ_s32OpenCurrent(0) < 0);
+        return s32Err;
+    }
+    stLogjStat.u32Rotations++;
+    return LOGJ_s32OpenCurrent(LFS_O_TRUNC);
+}
+
+// 写文件, 写满时先轮转; 轮转失败但当前文件还开着时继续写(文件暂时超过LOGJ_FILE_MAX)
+static int LOGJ_s32Write(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    lfs_ssize_t s32Ret;
+
+    if (!bLogjOpen) {
+        if (!bLogjReopen || (LOGJ_s32OpenCurrent(0) < 0)) {
+            return LFS_ERR_BADF;
+        }
+        bLogjReopen = false;
+    }
+    if ((u32LogjSize + u32Len) > LOGJ_FILE_MAX) {
+        s32Ret = LOGJ_s32Rotate();
+        if ((s32Ret < 0) && !bLogjOpen) {
+            return (int)s32Ret;
+        }
+    }
+
+    s32Ret = lfs_file_write(pLogjFs, &stLogjFile, pu8Data, u32Len);
+    if (s32Ret < 0) {
+        return LOGJ_s32Err((int)s32Ret);
+    }
+    u32LogjSize += u32Len;
+    u32LogjUnsynced += u32Len;
+    stLogjStat.u32Written += u32Len;
+    return 0;
+}
+
+
+// 挂载后调用, 打开(或建立)日志目录和当前文件
+int LOGJ_s32Open(lfs_t *pLfs)
+{
+    int s32Err;
+
+    if (pLfs == NULL) {
+        return LFS_ERR_INVAL;
+    }
+    if ((LOGJ_CHUNK % pLfs->cfg->prog_size) != 0U) {
+        return LFS_ERR_INVAL;
+    }
+
+    pLogjFs = pLfs;
+    u32LogjBatchLen = 0U;
+    bLogjReopen = false;
+    s32Err = lfs_mkdir(pLogjFs, LOGJ_DIR);
+    if ((s32Err < 0) && (s32Err != LFS_ERR_EXIST)) {
+        return LOGJ_s32Err(s32Err);
+    }
+    return LOGJ_s32OpenCurrent(0);
+}
+
+void LOGJ_Close(void)
+{
+    bLogjReopen = false;
+    if (bLogjOpen) {
+        (void)LOGJ_s32Flush();
+        bLogjOpen = false;
+        (void)lfs_file_close(pLogjFs, &stLogjFile);
+    }
+}
+
+// 追加日志: 先放到RAM缓存, 只有攒够一块时才写文件
+// 每块的结束位置都对齐到文件里LOGJ_CHUNK的整数倍, littlefs可以整块写入, 不需要先读出
+int LOGJ_s32Append(const void *pData, uint32_t u32Len)
+{
+    const uint8_t *pu8Src = (const uint8_t *)pData;
+    uint32_t u32Copy, u32Need;
+    int s32Err;
+
+    while (u32Len != 0U) {
+        u32Copy = LOGJ_BATCH - u32LogjBatchLen;
+        if (u32Copy > u32Len) {
+            u32Copy = u32Len;
+        }
+        memcpy(&au8LogjBatch[u32LogjBatchLen], pu8Src, u32Copy);
+        u32LogjBatchLen += u32Copy;
+        pu8Src += u32Copy;
+        u32Len -= u32Copy;
+
+        u32Need = LOGJ_CHUNK - (u32LogjSize % LOGJ_CHUNK);
+        while (u32LogjBatchLen >= u32Need) {
+            s32Err = LOGJ_s32Write(au8LogjBatch, u32Need);
+            if (s32Err < 0) {
+                stLogjStat.u32Drops += u32LogjBatchLen + u32Len;   // 写失败, 丢弃缓存中的日志
+                u32LogjBatchLen = 0U;
+                return s32Err;
+            }
+            u32LogjBatchLen -= u32Need;
+            memmove(au8LogjBatch, &au8LogjBatch[u32Need], u32LogjBatchLen);
+            u32Need = LOGJ_CHUNK;
+        }
+    }
+    return 0;
+}
+
+// 把缓存中不满一块的日志也写入文件, 然后sync
+int LOGJ_s32Flush(void)
+{
+    int s32Err;
+
+    if (!bLogjOpen && !bLogjReopen) {
+        return LFS_ERR_BADF;
+    }
+    if (u32LogjBatchLen != 0U) {
+        s32Err = LOGJ_s32Write(au8LogjBatch, u32LogjBatchLen);
+        u32LogjBatchLen = 0U;
+        if (s32Err < 0) {
+            return s32Err;
+        }
+    }
+    if (u32LogjUnsynced == 0U) {
+        return 0;
+    }
+    s32Err = lfs_file_sync(pLogjFs, &stLogjFile);
+    if (s32Err < 0) {
+        return LOGJ_s32Err(s32Err);
+    }
+    u32LogjUnsynced = 0U;
+    stLogjStat.u32Syncs++;
+    return 0;
+}
+
+// 从最老的文件开始, 把所有日志交给pfOut输出; pfOut返回负数时停止
+int LOGJ_s32Dump(LOGJ_Output_t pfOut, void *pArg)
+{
+    char acPath[LOGJ_PATH_LEN];
+    uint8_t au8Buff[LOGJ_READ_SIZE];
+    lfs_file_t stFile;
+    lfs_ssize_t s32Len;
+    uint32_t i;
+    int s32Err = 0;
+
+    if ((pLogjFs == NULL) || (pfOut == NULL)) {
+        return LFS_ERR_INVAL;
+    }
+    if (bLogjOpen) {
+        (void)LOGJ_s32Flush();
+    }
+
+    for (i = LOGJ_FILE_NUM; (i > 0U) && (s32Err >= 0); i--) {
+        LOGJ_Path(acPath, i - 1U);
+        if (lfs_file_open(pLogjFs, &stFile, acPath, LFS_O_RDONLY) < 0) {
+            continue;
+        }
+        while ((s32Len = lfs_file_read(pLogjFs, &stFile, au8Buff, sizeof(au8Buff))) > 0) {
+            if ((s32Err = pfOut(au8Buff, (uint32_t)s32Len, pArg)) < 0) {
+                break;
+            }
+        }
+        (void)lfs_file_close(pLogjFs, &stFile);
+    }
+    return s32Err;
+}
+
+const LOGJ_Stat_t *LOGJ_pStat(void)
+{
+    return &stLogjStat;
+}
+
+
+//----------------- RTOS, used in Core M7 ---------------------
+#if !defined (LOGJ_HOST)
+//-------------------------------------------------------------
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+#include "littlefsapi.h"
+
+#define LOGJ_STREAM_SIZE    (2048U)             // 打印任务和日志任务之间的缓存
+
+static StreamBufferHandle_t xLogjStream = NULL;
+static SemaphoreHandle_t xLogjMutex = NULL;   // 日志任务和shell(logcat)互斥, 日志文件打开后才建立
+static volatile bool bLogjSyncReq = false;     // 收到ERROR及以上的日志, 写入后马上sync
+extern uint8_t FileSystemStatus;
+
+static void LOGJ_Lock(void)
+{
+    (void)xSemaphoreTake(xLogjMutex, portMAX_DELAY);
+}
+
+static void LOGJ_Unlock(void)
+{
+    (void)xSemaphoreGive(xLogjMutex);
+}
+
+// 打印任务调用, 日志任务来不及写时丢弃
+// bSync: 这段里有ERROR及以上的日志, 不等LOGJ_SYNC_MS, 日志任务写入后马上sync;
+// 先置标志再发送, 发送唤醒日志任务时一定能看到
+void LOGJ_Feed(const uint8_t *pu8Data, uint32_t u32Len, bool bSync)
+{
+    size_t xSent;
+
+    if (xLogjStream == NULL) {
+        return;
+    }
+    if (bSync) {
+        bLogjSyncReq = true;
+    }
+    xSent = xStreamBufferSend(xLogjStream, pu8Data, u32Len, 0);
+    stLogjStat.u32Drops += u32Len - (uint32_t)xSent;
+}
+
+// 日志任务: 收到日志就攒块写入; 有未sync的数据时, 到期或攒够LOGJ_SYNC_BYTES才sync,
+// 有ERROR及以上的日志时把流里的日志都写入后马上sync
+// (出错死机的路径上不能sync: littlefs要用RTOS互斥量和QSPI, 那时中断已经关了)
+void LOGJ_Task(void *pvParameters)
+{
+    uint8_t au8Rx[LOGJ_CHUNK];
+    size_t xLen;
+    TickType_t xDeadline = 0, xWait, xNow;
+    StreamBufferHandle_t xStream;
+    SemaphoreHandle_t xMutex;
+    bool bPending = false;                      // 有写入但还没有sync的数据
+    bool bSyncNow;
+    uint32_t i;
+
+    (void)pvParameters;
+    if ((FileSystemStatus != 0U) || (LOGJ_s32Open(&lfs_ext_flash) < 0)) {
+        vTaskDelete(NULL);
+    }
+    // 文件打开后才建立, logcat以xLogjMutex判断日志任务是否在运行
+    xStream = xStreamBufferCreate(LOGJ_STREAM_SIZE, 1);
+    xMutex = xSemaphoreCreateMutex();
+    if ((xStream == NULL) || (xMutex == NULL)) {
+        LOGJ_Close();
+        vTaskDelete(NULL);
+    }
+    xLogjStream = xStream;
+    xLogjMutex = xMutex;
+
+    while (1) {
+        xWait = portMAX_DELAY;
+        if (bPending) {
+            xNow = xTaskGetTickCount();
+            xWait = ((int32_t)(xDeadline - xNow) > 0) ? (xDeadline - xNow) : 0;
+        }
+        xLen = xStreamBufferReceive(xLogjStream, au8Rx, sizeof(au8Rx), xWait);
+
+        bSyncNow = bLogjSyncReq;
+        bLogjSyncReq = false;
+
+        LOGJ_Lock();
+        if (xLen != 0U) {
+            (void)LOGJ_s32Append(au8Rx, (uint32_t)xLen);
+            if (!bPending) {
+                bPending = true;
+                xDeadline = xTaskGetTickCount() + pdMS_TO_TICKS(LOGJ_SYNC_MS);
+            }
+        }
+        // 要马上sync的那段可能还有一部分在流里, 最多取完一个流的长度
+        for (i = 0; bSyncNow && (i < (LOGJ_STREAM_SIZE / LOGJ_CHUNK)); i++) {
+            xLen = xStreamBufferReceive(xLogjStream, au8Rx, sizeof(au8Rx), 0);
+            if (xLen == 0U) {
+                break;
+            }
+            (void)LOGJ_s32Append(au8Rx, (uint32_t)xLen);
+            bPending = true;
+        }
+        if (bPending && (bSyncNow || (u32LogjUnsynced >= LOGJ_SYNC_BYTES)
+                         || ((int32_t)(xTaskGetTickCount() - xDeadline) >= 0))) {
+            (void)LOGJ_s32Flush();
+            bPending = false;
+        }
+        LOGJ_Unlock();
+    }
+}
+
+
+#include "shell.h"
+#include "shell_port.h"
+
+static int LOGJ_s32ShellOut(const void *pData, uint32_t u32Len, void *pArg)
+{
+    (void)pArg;
+    shell.write((char *)pData, (unsigned short)u32Len);
+    return 0;
+}
+
+// shell: logcat, 从最老的日志开始输出整个日志文件
+// 二进制日志记录原样输出, 可以用Tools/binlog_decode.py解码
+void LOGJ_Shell(void)
+{
+    const LOGJ_Stat_t *pStat = LOGJ_pStat();
+
+    if (xLogjMutex == NULL) {
+        shellPrint(&shell, "log journal not running\r\n");
+        return;
+    }
+    LOGJ_Lock();
+    (void)LOGJ_s32Dump(LOGJ_s32ShellOut, NULL);
+    LOGJ_Unlock();
+    shellPrint(&shell, "\r\n[logcat] written %lu, syncs %lu, rotations %lu, drops %lu, err %ld\r\n",
+               pStat->u32Written, pStat->u32Syncs, pStat->u32Rotations, pStat->u32Drops, pStat->s32LastErr);
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_FUNC),
+                 logcat, LOGJ_Shell, Dump the persistent log journal);
+
+//-------------------------------------------------------------
+#endif
+//-------------------------------------------------------------
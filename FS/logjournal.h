@@ -0,0 +1,73 @@
+/**
+  ******************************************************************************
+  * @file    logjournal.h
+  * @author  Drive FW team
+  * @brief   Header file of persistent log journal on littlefs
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * 打印任务发送完的日志再写一份到littlefs, 复位后还可以用shell命令logcat读出.
+  * 日志先在RAM里攒成prog_size整数倍的块再写文件, 定时(或攒够一个擦除块)才sync,
+  * 减少FLASH的写入和擦除次数. 文件写满后轮转: log/0是当前文件, log/1...是更早的.
+  * littlefs保证掉电时文件是上一次sync的完整状态, 最多丢失最近一个sync周期的日志.
+  *
+  * 文件操作部分只依赖littlefs, 主机测试时定义LOGJ_HOST, 用文件模拟的块设备即可.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOGJOURNAL_H__
+#define __LOGJOURNAL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lfs.h"
+
+#define LOGJ_DIR            "log"
+#define LOGJ_FILE_NUM       (4U)                // 轮转的文件个数
+#define LOGJ_FILE_MAX       (64U * 1024U)       // 单个文件的最大长度
+#define LOGJ_CHUNK          (256U)              // 一次写文件的长度, prog_size的整数倍
+#define LOGJ_BATCH          (4U * LOGJ_CHUNK)   // RAM批量缓存
+#define LOGJ_SYNC_MS        (10000U)            // 有未sync的数据时, 最长多久sync一次
+#define LOGJ_SYNC_BYTES     (8U * 1024U)        // 未sync的数据达到这个长度时马上sync
+
+typedef struct _LOGJ_Stat_ {
+    uint32_t u32Written;                        // 写入文件的字节数
+    uint32_t u32Syncs;                          // sync次数
+    uint32_t u32Rotations;                      // 文件轮转次数
+    uint32_t u32Drops;                          // 来不及写入被丢弃的字节数
+    int32_t  s32LastErr;                        // 最近一次littlefs错误
+} LOGJ_Stat_t;
+
+typedef int (*LOGJ_Output_t)(const void *pData, uint32_t u32Len, void *pArg);
+
+
+// 文件操作, 不是线程安全的, 由调用者保证互斥
+int LOGJ_s32Open(lfs_t *pLfs);
+int LOGJ_s32Append(const void *pData, uint32_t u32Len);
+int LOGJ_s32Flush(void);
+int LOGJ_s32Dump(LOGJ_Output_t pfOut, void *pArg);
+void LOGJ_Close(void);
+const LOGJ_Stat_t *LOGJ_pStat(void);
+
+#if !defined (LOGJ_HOST)
+// RTOS: 打印任务把发送完的日志交给日志任务, 不阻塞; bSync: 有ERROR及以上的日志, 马上sync
+void LOGJ_Feed(const uint8_t *pu8Data, uint32_t u32Len, bool bSync);
+void LOGJ_Task(void *pvParameters);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __LOGJOURNAL_H__ */
@@ -0,0 +1,194 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ */
+#include <string.h>
+#include "shellscript.h"
+
+
+#if defined (SCR_HOST)
+#include <time.h>
+static uint32_t SCR_u32NowMs(void)
+{
+    struct timespec stTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &stTs);
+    return (uint32_t)(stTs.tv_sec * 1000U + stTs.tv_nsec / 1000000U);
+}
+#else
+#include "FreeRTOS.h"
+#include "task.h"
+#define SCR_u32NowMs()            ((uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS))
+#endif
+
+
+static uint8_t au8ScrChunk[SCR_CHUNK];
+static char acScrLine[SCR_LINE_MAX + 1U];
+static lfs_file_t stScrFile;
+static bool bScrRunning = false;
+static SCR_Stat_t stScrStat;
+
+
+// 执行一行, 返回0继续, 负数停止
+static int SCR_s32Line(Shell *pShell, char *pcLine, uint32_t u32Flags)
+{
+    int s32Result = 0;
+
+    stScrStat.u32Lines++;
+    while ((*pcLine == ' ') || (*pcLine == '\t')) {
+        pcLine++;
+    }
+    if ((*pcLine == '\0') || (*pcLine == '#')) {
+        return 0;
+    }
+    for (char *pc = pcLine; *pc != '\0'; pc++) {
+        if (*pc == '\t') {
+            *pc = ' ';                          // shell只用空格分隔参数
+        }
+    }
+
+    if ((u32Flags & SCR_F_ECHO) != 0U) {
+        shellWriteString(pShell, "> ");
+        shellWriteString(pShell, pcLine);
+        shellWriteString(pShell, "\r\n");
+    }
+    stScrStat.u32Cmds++;
+    if ((shellRunLine(pShell, pcLine, &s32Result) == 0) && (s32Result == 0)) {
+        return 0;
+    }
+
+    if (stScrStat.u32Errors++ == 0U) {
+        stScrStat.u32ErrLine = stScrStat.u32Lines;
+    }
+    return ((u32Flags & SCR_F_STOP) != 0U) ? SCR_ERR_CMD : 0;
+}
+
+// 行太长, 整行丢弃并记为错误
+static int SCR_s32LongLine(uint32_t u32Flags)
+{
+    stScrStat.u32Lines++;
+    if (stScrStat.u32Errors++ == 0U) {
+        stScrStat.u32ErrLine = stScrStat.u32Lines;
+    }
+    return ((u32Flags & SCR_F_STOP) != 0U) ? SCR_ERR_LINE : 0;
+}
+
+int SCR_s32Run(lfs_t *pLfs, Shell *pShell, const char *pcPath, uint32_t u32Flags)
+{
+    uint32_t u32Start = SCR_u32NowMs();
+    uint32_t u32Len = 0U;
+    bool bOverflow = false;
+    lfs_ssize_t s32Read;
+    int s32Ret = 0;
+
+    if (bScrRunning) {
+        return SCR_ERR_BUSY;
+    }
+    memset(&stScrStat, 0, sizeof(stScrStat));
+    s32Ret = lfs_file_open(pLfs, &stScrFile, pcPath, LFS_O_RDONLY);
+    if (s32Ret < 0) {
+        stScrStat.s32Result = s32Ret;
+        return s32Ret;
+    }
+    bScrRunning = true;
+
+    // 整块读出, 在块里切行; 行可以跨块
+    while (s32Ret == 0) {
+        s32Read = lfs_file_read(pLfs, &stScrFile, au8ScrChunk, SCR_CHUNK);
+        if (s32Read <= 0) {
+            s32Ret = (int)s32Read;
+            break;
+        }
+        stScrStat.u32Bytes += (uint32_t)s32Read;
+        for (lfs_ssize_t i = 0; (i < s32Read) && (s32Ret == 0); i++) {
+            char c = (char)au8ScrChunk[i];
+
+            if (c == '\n') {
+                acScrLine[u32Len] = '\0';
+                s32Ret = bOverflow ? SCR_s32LongLine(u32Flags) : SCR_s32Line(pShell, acScrLine, u32Flags);
+                u32Len = 0U;
+                bOverflow = false;
+            } else if ((c == '\r') || (c == '\0')) {
+                // 忽略, 兼容\r\n
+            } else if (u32Len < SCR_LINE_MAX) {
+                acScrLine[u32Len++] = c;
+            } else {
+                bOverflow = true;               // 丢弃到行尾
+            }
+        }
+    }
+    // 最后一行没有行尾
+    if ((s32Ret == 0) && bOverflow) {
+        s32Ret = SCR_s32LongLine(u32Flags);
+    } else if ((s32Ret == 0) && (u32Len > 0U)) {
+        acScrLine[u32Len] = '\0';
+        s32Ret = SCR_s32Line(pShell, acScrLine, u32Flags);
+    }
+
+    (void)lfs_file_close(pLfs, &stScrFile);
+    bScrRunning = false;
+    stScrStat.u32Ms = SCR_u32NowMs() - u32Start;
+    stScrStat.s32Result = s32Ret;
+    return s32Ret;
+}
+
+const SCR_Stat_t *SCR_pStat(void)
+{
+    return &stScrStat;
+}
+
+
+//----------------- shell, used in Core M7 ---------------------
+#if !defined (SCR_HOST)
+//-------------------------------------------------------------
+#include "littlefsapi.h"
+#include "shell_port.h"
+
+extern uint8_t FileSystemStatus;
+
+// shell: source [-e] [-v] <path>, 执行littlefs里的脚本
+// -e: 命令不存在或返回非0时停止; -v: 执行前输出命令行
+int SCR_Shell(int argc, char *argv[])
+{
+    const SCR_Stat_t *pStat = SCR_pStat();
+    uint32_t u32Flags = 0U;
+    const char *pcPath = NULL;
+    int s32Ret;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-e") == 0) {
+            u32Flags |= SCR_F_STOP;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            u32Flags |= SCR_F_ECHO;
+        } else if (pcPath == NULL) {
+            pcPath = argv[i];
+        } else {
+            pcPath = NULL;
+            break;
+        }
+    }
+    if (pcPath == NULL) {
+        shellPrint(&shell, "usage: %s [-e] [-v] <path>\r\n", argv[0]);
+        return -1;
+    }
+    if (FileSystemStatus != 0U) {
+        shellPrint(&shell, "file system not ready\r\n");
+        return -1;
+    }
+
+    s32Ret = SCR_s32Run(&lfs_ext_flash, &shell, pcPath, u32Flags);
+    shellPrint(&shell, "[%s] %s: %lu lines, %lu cmds, %lu errors (first at line %lu), %lu bytes, %lu ms, ret %d\r\n",
+               argv[0], pcPath, pStat->u32Lines, pStat->u32Cmds, pStat->u32Errors, pStat->u32ErrLine,
+               pStat->u32Bytes, pStat->u32Ms, s32Ret);
+    return s32Ret;
+}
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                 source, SCR_Shell, Run a shell script on littlefs\r\nsource [-e] [-v] <path>);
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)| SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                 run, SCR_Shell, Same as source);
+
+//-------------------------------------------------------------
+#endif
+//-------------------------------------------------------------
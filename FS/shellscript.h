@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file    shellscript.h
+  * @author  Drive FW team
+  * @brief   Header file of shell scripts stored on littlefs
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (C) 2023 Schneider-Electric.
+  * All rights reserved.
+  *
+  * shell命令source/run把littlefs里的文本文件当作命令序列执行, 用于生产配置和回归测试.
+  * 文件按SCR_CHUNK大块读出, 逐行交给shellRunLine执行: 不回显, 不记录历史, 不输出提示符,
+  * 执行速度取决于读FLASH和命令本身, 而不是串口输入.
+  *
+  * 脚本格式: 每行一条命令, 行尾\n或\r\n; 空行和#开头的行忽略; 行首的空白忽略.
+  *
+  * 只依赖littlefs和shell, 主机测试时定义SCR_HOST, 同一个脚本可以在主机上回放.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SHELLSCRIPT_H__
+#define __SHELLSCRIPT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lfs.h"
+#include "shell.h"
+
+#define SCR_CHUNK           (1024U)             // 一次读文件的长度, read_size的整数倍
+#define SCR_LINE_MAX        (256U)              // 一行命令的最大长度(不含行尾)
+
+// 执行选项
+#define SCR_F_STOP          (1U << 0)           // 命令不存在或返回非0(显示返回值的命令)时停止(-e)
+#define SCR_F_ECHO          (1U << 1)           // 执行前输出命令行(-v)
+
+// 错误码, 和littlefs的错误码(负数)一起使用
+#define SCR_ERR_LINE        (-1101)             // 行太长
+#define SCR_ERR_BUSY        (-1102)             // 已经在执行脚本(不支持嵌套)
+#define SCR_ERR_CMD         (-1103)             // 命令不存在或返回非0(SCR_F_STOP)
+
+typedef struct _SCR_Stat_ {
+    uint32_t u32Bytes;                          // 读出的字节数
+    uint32_t u32Lines;                          // 行数
+    uint32_t u32Cmds;                           // 执行的命令数
+    uint32_t u32Errors;                         // 命令不存在, 返回非0或行太长的次数
+    uint32_t u32ErrLine;                        // 第一个错误的行号
+    uint32_t u32Ms;                             // 执行用时
+    int32_t  s32Result;
+} SCR_Stat_t;
+
+
+// 在pShell上逐行执行脚本, 命令在调用者的上下文里执行(板上是source命令, 主机上是测试程序)
+int SCR_s32Run(lfs_t *pLfs, Shell *pShell, const char *pcPath, uint32_t u32Flags);
+const SCR_Stat_t *SCR_pStat(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* __SHELLSCRIPT_H__ */
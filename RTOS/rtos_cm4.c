@@ -13,6 +13,11 @@
 #include "main.h"
 #include "stm32h747i_discovery.h"
 #include "usart.h"
+#include "ipc_stream.h"
+#include "sharemem.h"
+#include "telemetry.h"
+#include "ipc_rpc.h"
+#include "modbus.h"
 
 #define LED_DELAY   pdMS_TO_TICKS(300) // 发送等待延时为200ms
 
@@ -53,10 +58,6 @@ TaskHandle_t LEDsTaskHandle;	      // LED任务句柄
   ********************************************************************/
 static void LED_Task(void)
 {	
-    char strBuff[64] = {0};
-    strcpy(strBuff, "Uart8 init success!\r\n");
-    (void)Uart_bSend_NonBlocking(&huart8, (uint8_t *)strBuff, strlen((const char *)strBuff));
-    //HAL_UART_Transmit(&huart8, (uint8_t *)strBuff, strlen(strBuff), 10);
     while (1)
     {
         BSP_LED_Toggle(LED3);      
@@ -114,22 +115,91 @@ static void AppTaskCreate(void)
     }
 
     result = pdFAIL;
-    result = xTaskCreate( (TaskFunction_t )UART8_Task,
-                          (const char*    )"UART8_Task",
+    // UART8上的Modbus RTU从站
+    result = xTaskCreate( (TaskFunction_t )MB_Task,
+                          (const char*    )"MB_Task",
                           (uint16_t       )256,
                           (void*          )NULL,
-                          (UBaseType_t    )4,
+                          (UBaseType_t    )5,                 // 最高的应用优先级, 帧间隔超时后马上应答
                           (TaskHandle_t*  )NULL);
     
     if(pdFAIL == result) { // 创建失败
         Error_Handler();
     }
 
+    // 遥测数据发布任务
+    result = pdFAIL;
+    result = xTaskCreate( (TaskFunction_t )TLM_Task,
+                          (const char*    )"TLM_Task",
+                          (uint16_t       )256,
+                          (void*          )NULL,
+                          (UBaseType_t    )1,
+                          (TaskHandle_t*  )NULL);
+
+    if(pdFAIL == result) { // 创建失败
+        Error_Handler();
+    }
+
+    // RPC服务端任务
+    result = pdFAIL;
+    result = xTaskCreate( (TaskFunction_t )IPC_RpcServerTask,
+                          (const char*    )"RpcServer",
+                          (uint16_t       )256,
+                          (void*          )NULL,
+                          (UBaseType_t    )3,
+                          (TaskHandle_t*  )NULL);
+
+    if(pdFAIL == result) { // 创建失败
+        Error_Handler();
+    }
+
+    // CM7 ampbench命令的回送任务
+    result = pdFAIL;
+    result = xTaskCreate( (TaskFunction_t )AMP_BenchEchoTask,
+                          (const char*    )"AmpEchoTask",
+                          (uint16_t       )256,
+                          (void*          )NULL,
+                          (UBaseType_t    )3,
+                          (TaskHandle_t*  )NULL);
+
+    if(pdFAIL == result) { // 创建失败
+        Error_Handler();
+    }
+
+    // CM7 shmbench命令的回送任务, 共享内存借用块的消费者
+    result = pdFAIL;
+    result = xTaskCreate( (TaskFunction_t )AMP_ShmEchoTask,
+                          (const char*    )"ShmEchoTask",
+                          (uint16_t       )256,
+                          (void*          )NULL,
+                          (UBaseType_t    )3,
+                          (TaskHandle_t*  )NULL);
+
+    if(pdFAIL == result) { // 创建失败
+        Error_Handler();
+    }
+
     vTaskDelete(AppTaskCreateHandle); //最后删除AppTaskCreate任务
     taskEXIT_CRITICAL();              //退出临界区
 }
 
 
+/**
+  * @brief  configSUPPORT_STATIC_ALLOCATION为1时, 空闲任务的任务控制块和堆栈由用户提供
+  */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    static StaticTask_t IdleTaskTCB;
+    static StackType_t IdleTaskStack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &IdleTaskTCB;
+    *ppxIdleTaskStackBuffer = IdleTaskStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+
 /**
 * @brief  Handles the tick increment
 * @param  none.
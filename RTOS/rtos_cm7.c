@@ -4,6 +4,7 @@
  * All Rights Reserved.
  *
  */
+#include <stdio.h>
 #include <string.h>
 #include "FreeRTOS.h"	      // FreeRTOS	  
 #include "task.h"           // FreeRTOS task
@@ -14,8 +15,12 @@
 #include "usart.h"
 #include "tim.h"
 #include "task10ms.h"
+#include "logjournal.h"           // 包含stdio.h, 要在debug_printf.h之前
 #include "debug_printf.h"
 #include "shell_port.h"
+#include "telemetry.h"
+#include "ipc_rpc.h"
+#include "binlog.h"
 
 
 static void AppTaskCreate(void);           /* 用于创建任务 */ 
@@ -33,12 +38,6 @@ TaskHandle_t LEDsTaskHandle;	      // LED任务句柄
 TaskHandle_t PrintfTaskHandle;	    // 信息打印任务句柄
 TaskHandle_t TenmsTaskHandle;	    // 10ms任务句柄
 
-SemaphoreHandle_t xSemphr_Printf = NULL;  // 用于锁定打印COM口的二值信号量
-SemaphoreHandle_t xMutex_Uart1 = NULL;
-
-QueueHandle_t xQueue_Printf = NULL;       // 消息队列，消息拷贝到队列里
-QueueHandle_t xQueue_PB = NULL;           // 消息队列，用于发送消息缓存
-
 EventGroupHandle_t xEvent_eFlag = NULL;   // 事件组
 
 static TimerHandle_t hSTimer1 = NULL;     // 软件定时器
@@ -79,6 +78,39 @@ void osSystickHandler(void)
 #endif  /* INCLUDE_xTaskGetSchedulerState */  
 }
 
+// 任务列表和运行时间统计: 按任务逐行写入日志缓存, 行缓存的长度和任务个数无关
+// (vTaskList/vTaskGetRunTimeStats要求一次容纳所有任务, 任务多了会写出栈缓存)
+static void LED_PrintTasks(void)
+{
+    static const char acState[] = { 'X', 'R', 'B', 'S', 'D', '?' };   // eTaskState的顺序
+    TaskStatus_t *pstTask;
+    UBaseType_t uxNum, i;
+    uint32_t u32Total;
+    char acLine[80];
+
+    uxNum = uxTaskGetNumberOfTasks() + 2U;     // 多留两个, 读取之间新建的任务
+    pstTask = pvPortMalloc(uxNum * sizeof(TaskStatus_t));
+    if (pstTask == NULL) {
+        printf2buff("task list: no memory\r\n");
+        return;
+    }
+    uxNum = uxTaskGetSystemState(pstTask, uxNum, &u32Total);
+    u32Total /= 100U;                           // 百分比
+
+    printf2buff("\r\n---------------------------------------------\r\n");
+    printf2buff("任务名\t\t任务状态 优先级\t剩余栈\t任务序号\t运行计数\t使用率\r\n");
+    for (i = 0; i < uxNum; i++) {
+        (void)snprintf(acLine, sizeof(acLine), "%-16s%c\t%lu\t%u\t%lu\t%lu\t%lu%%\r\n",
+                       pstTask[i].pcTaskName, acState[(pstTask[i].eCurrentState < eInvalid) ? pstTask[i].eCurrentState : eInvalid],
+                       (unsigned long)pstTask[i].uxCurrentPriority, (unsigned)pstTask[i].usStackHighWaterMark,
+                       (unsigned long)pstTask[i].xTaskNumber, (unsigned long)pstTask[i].ulRunTimeCounter,
+                       (unsigned long)((u32Total != 0U) ? (pstTask[i].ulRunTimeCounter / u32Total) : 0U));
+        printf2buff(acLine);
+    }
+    printf2buff("---------------------------------------------\r\n");
+    vPortFree(pstTask);
+}
+
 /**********************************************************************
   * @ 函数名  ： LED_Task
   * @ 功能说明： LED_Task任务主体
@@ -88,12 +120,8 @@ void osSystickHandler(void)
 static void LED_Task(void* parameter)
 {	
     EventBits_t uxBits;
-    char strBuff[512] = {0};
-    char taskInfo[256] = {0};
-    uint32_t buffAddr = (uint32_t)strBuff;
 
     //printf2buff("LED_Task Start Running Now...\r\n");
-    //xQueueSend(xQueue_Printf, "LED_Task Start Running Now...\r\n", 0);
     (void)xTaskNotifyGive(TenmsTaskHandle); // 用任务通知,通知10ms任务
 
     while (1)
@@ -103,22 +131,11 @@ static void LED_Task(void* parameter)
         // 接收按键事件
         uxBits = xEventGroupClearBits(xEvent_eFlag, (WAKEUP_EVENT|JOYSEL_EVENT));
         if ((uxBits & WAKEUP_EVENT) == WAKEUP_EVENT) {
-            xQueueSend(xQueue_Printf, "WAKEUP Pressed\r\n", 0);
+            LOGB(LOG_MOD_KEY, LOG_LVL_INFO, "WAKEUP Pressed\r\n");
         } else if ((uxBits & JOYSEL_EVENT) == JOYSEL_EVENT) {
-            //xQueueSend(xQueue_Printf, "JOY_SEL Key Pressed\r\n", 0);
-
-            memset(taskInfo,0,sizeof(taskInfo));
-            vTaskList((char *)&taskInfo); //获取任务运行时间信息
-            strcpy(strBuff, "\r\n---------------------------------------------\r\n");
-            strcat(strBuff, "任务名\t\t任务状态 优先级\t剩余栈\t任务序号\r\n");
-            strcat(strBuff, taskInfo);
-            strcat(strBuff, "---------------------------------------------\r\n");
-            memset(taskInfo,0,sizeof(taskInfo));
-            vTaskGetRunTimeStats((char*)taskInfo);
-            strcat(strBuff, "任务名\t\t运行计数\t使用率\r\n");
-            strcat(strBuff, taskInfo);
-            strcat(strBuff, "---------------------------------------------\r\n");
-            xQueueSend(xQueue_PB, &buffAddr, 0);
+            //LOGB(LOG_MOD_KEY, LOG_LVL_INFO, "JOY_SEL Key Pressed\r\n");
+
+            LED_PrintTasks();
         } else {
             // 读取任务堆栈剩余最小值
             uxHighWaterMark[0] = uxTaskGetStackHighWaterMark( LEDsTaskHandle );
@@ -137,20 +154,16 @@ static void LED_Task(void* parameter)
   **********************************************************************/
 void osAppVariableCreate(void)
 {
-    // 创建打印任务互斥信号量
-    //xMutex_Uart1 = xSemaphoreCreateMutex();
-
-    // 1.写缓存的任务Give信号量(通知); 2.打印专用任务Take信号量(有打印任务)
-    xSemphr_Printf = xSemaphoreCreateBinary();
-
-    // 消息队列,打印的内容通过消息队列传递给打印任务
-    xQueue_Printf = xQueueCreate(4, sizeof(char)*64); // 消息队列长度是4，每个消息可以发送64个字符
-
-    // 消息队列,打印的内容通过消息队列传递给打印任务
-    xQueue_PB = xQueueCreate(2, sizeof(void *));      // 消息队列长度是2，消息发送的是缓存地址
+    // 打印的内容都写入日志环形缓存(debug_printf.c), 不再需要打印用的信号量和消息队列
 
     // 事件组, bit0:Wakeup key, bit1:Joy SET
     xEvent_eFlag = xEventGroupCreate();
+
+    // 二进制日志的时间戳
+    BLOG_Init();
+
+    // 遥测里显示日志环形缓存的占用(字节)
+    (void)TLM_bAddLevel("log", LOG_u32Used);
 }
 
 
@@ -192,12 +205,12 @@ static void AppTaskCreate(void)
 
     result = xTaskCreate( (TaskFunction_t )RTOS_DebugPrintTask,
                           (const char*    )"PrintfTask",
-                          (uint16_t       )128,
+                          (uint16_t       )256,               // 文本模式下在本任务里展开二进制日志(snprintf)
                           (void*          )NULL,
                           (UBaseType_t    )2,
                           (TaskHandle_t*  )&PrintfTaskHandle);
 
-    if((pdPASS == result) && (NULL != xSemphr_Printf)) {
+    if(pdPASS == result) {
       printf2buffatinit("PrintfTask Create Success\r\n");
     }
  
@@ -226,6 +239,45 @@ static void AppTaskCreate(void)
       printf2buffatinit("RTOS_Task10ms Create Success\r\n");
     }
 
+    // 遥测数据发布任务
+    result = pdFAIL;
+    result = xTaskCreate( (TaskFunction_t )TLM_Task,
+                          (const char*    )"TLM_Task",
+                          (uint16_t       )256,
+                          (void*          )NULL,
+                          (UBaseType_t    )1,
+                          (TaskHandle_t*  )NULL);
+
+    if(pdPASS == result) { // 创建成功
+      printf2buffatinit("TLM_Task Create Success\r\n");
+    }
+
+    // RPC客户端任务, 处理CM4的应答
+    result = pdFAIL;
+    result = xTaskCreate( (TaskFunction_t )IPC_RpcClientTask,
+                          (const char*    )"RpcClient",
+                          (uint16_t       )256,
+                          (void*          )NULL,
+                          (UBaseType_t    )4,
+                          (TaskHandle_t*  )NULL);
+
+    if(pdPASS == result) { // 创建成功
+      printf2buffatinit("RpcClient Create Success\r\n");
+    }
+
+    // 日志文件任务, 把打印过的日志写入littlefs
+    result = pdFAIL;
+    result = xTaskCreate( (TaskFunction_t )LOGJ_Task,
+                          (const char*    )"LogJournal",
+                          (uint16_t       )512,
+                          (void*          )NULL,
+                          (UBaseType_t    )1,
+                          (TaskHandle_t*  )NULL);
+
+    if(pdPASS == result) { // 创建成功
+      printf2buffatinit("LogJournal Create Success\r\n");
+    }
+
     // shell任务创建
     Shell_Task_Create();
 
@@ -255,6 +307,37 @@ void xOneSecondTimer(void)
 }
 
 
+/**
+  * @brief  configSUPPORT_STATIC_ALLOCATION为1时, 空闲任务的任务控制块和堆栈由用户提供
+  */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    static StaticTask_t IdleTaskTCB;
+    static StackType_t IdleTaskStack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &IdleTaskTCB;
+    *ppxIdleTaskStackBuffer = IdleTaskStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+/**
+  * @brief  configSUPPORT_STATIC_ALLOCATION为1时, 软件定时器任务的任务控制块和堆栈由用户提供
+  */
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+    static StaticTask_t TimerTaskTCB;
+    static StackType_t TimerTaskStack[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &TimerTaskTCB;
+    *ppxTimerTaskStackBuffer = TimerTaskStack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+
 
 /*********************************** 下面是使用静态创建任务的例子 *****************************************/
 #if 0
@@ -9,6 +9,7 @@
  * 
  */
 
+#include <string.h>
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
@@ -20,14 +21,77 @@
 //#include "serial.h"
 //#include "cevent.h"
 
-#define SHELL_RUN_IN_IDLE_TASK (1)  // shell 任务放在RTOS的IDLE任务内运行
 #define SHELL_BUFF_LEN (512)        // 缓存长度
-#define SHELL_RXTX_TOUT (20)        // 串口发送/接收等待超时,是系统tick数,比如tick的频率是1kHz,则刚好是ms
+#define SHELL_RX_CHUNK (32)         // 一次从接收环形缓存读取的字节数
+#define SHELL_TX_SIZE  (2048U)      // 输出环形缓存, 2的整数次幂, 32字节的整数倍
+#define SHELL_TASK_STACK (1024U)    // shell命令(文件系统、文件传输)在shell任务里运行, 单位是Word
+#define SHELL_TX_RETRY pdMS_TO_TICKS(10)   // 发送队列满, 输出没能放入时重试的间隔
+
+// 输出缓存: 写的一方(任务)关中断拷贝, 连续的一段放入UART1发送队列, 发送完成中断里接着放下一段
+#define SHELL_TX_LOCK(state)      do { (state) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define SHELL_TX_UNLOCK(state)    __set_PRIMASK(state)
 
 
 
 Shell shell;
 ALIGN_32BYTES(char shellBuffer[SHELL_BUFF_LEN]) = {0};
+ALIGN_32BYTES(static uint8_t au8ShellTx[SHELL_TX_SIZE]) = {0};  // DMA发送, 32字节对齐
+
+static uint32_t u32ShellTxHead = 0U;            // 写入位置(自由增长), 关中断修改
+static volatile uint32_t u32ShellTxTail = 0U;   // 发送完成的位置, 只在发送完成中断里修改
+static uint32_t u32ShellTxSend = 0U;            // 已放入发送队列的位置
+static volatile uint8_t u8ShellTxBusy = 0U;     // 有一段在UART1发送队列里
+
+static TaskHandle_t xShellTaskHandle = NULL;
+
+static void Shell_TxDoneFromISR(void *pArg);
+
+// UART1发送队列满(和其他输出共用): 唤醒shell任务, 由它每SHELL_TX_RETRY重试一次
+// 否则其他任务或发送完成中断里没放进去的输出要等到下一次输入或写入才会发送
+static void Shell_TxRetry(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (xShellTaskHandle == NULL) {
+        return;                                 // shell任务启动后会检查输出缓存
+    }
+    if (__get_IPSR() != 0U) {
+        vTaskNotifyGiveFromISR(xShellTaskHandle, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    } else if (xTaskGetCurrentTaskHandle() != xShellTaskHandle) {
+        (void)xTaskNotifyGive(xShellTaskHandle);
+    }
+}
+
+// 把输出缓存里下一段连续的数据放入UART1发送队列, 调用者需要关中断
+static void Shell_TxKick(void)
+{
+    uint32_t u32Off, u32Len;
+
+    if ((u8ShellTxBusy != 0U) || (u32ShellTxSend == u32ShellTxHead)) {
+        return;
+    }
+    u32Off = u32ShellTxSend & (SHELL_TX_SIZE - 1U);
+    u32Len = u32ShellTxHead - u32ShellTxSend;
+    if (u32Len > (SHELL_TX_SIZE - u32Off)) {
+        u32Len = SHELL_TX_SIZE - u32Off;
+    }
+    // 发送队列满时留在缓存里, 由shell任务重试
+    if (UartDrv_bSend(&stUart1Drv, &au8ShellTx[u32Off], u32Len, Shell_TxDoneFromISR, (void *)(uintptr_t)u32Len)) {
+        u8ShellTxBusy = 0xFU;
+        u32ShellTxSend += u32Len;
+    } else {
+        Shell_TxRetry();
+    }
+}
+
+// 一段输出发送完成(中断里): 释放缓存, 接着发送下一段
+static void Shell_TxDoneFromISR(void *pArg)
+{
+    u32ShellTxTail += (uint32_t)(uintptr_t)pArg;
+    u8ShellTxBusy = 0U;
+    Shell_TxKick();
+}
 
 /**
  * @brief 用户shell写
@@ -39,10 +103,33 @@ ALIGN_32BYTES(char shellBuffer[SHELL_BUFF_LEN]) = {0};
  */
 short userShellWrite(char *data, unsigned short len)
 {
-    //serialTransmit(&debugSerial, (uint8_t *)data, len, 0x1FF);
-	//调用STM32 HAL库 API 使用查询方式发送
-	HAL_UART_Transmit(&huart1, (uint8_t*)data, len, SHELL_RXTX_TOUT);
+    uint32_t u32State, u32Off, u32Copy;
+    unsigned short n = 0;
+
+    // 只拷贝到输出缓存, 由DMA发送; 缓存满时写的任务等待, 中断里和调度器启动前丢弃
+    while (n < len) {
+        SHELL_TX_LOCK(u32State);
+        u32Copy = SHELL_TX_SIZE - (u32ShellTxHead - u32ShellTxTail);
+        u32Off = u32ShellTxHead & (SHELL_TX_SIZE - 1U);
+        if (u32Copy > (SHELL_TX_SIZE - u32Off)) {
+            u32Copy = SHELL_TX_SIZE - u32Off;
+        }
+        if (u32Copy > (uint32_t)(len - n)) {
+            u32Copy = len - n;
+        }
+        memcpy(&au8ShellTx[u32Off], &data[n], u32Copy);
+        u32ShellTxHead += u32Copy;
+        n += (unsigned short)u32Copy;
+        Shell_TxKick();
+        SHELL_TX_UNLOCK(u32State);
 
+        if (u32Copy == 0U) {
+            if ((__get_IPSR() != 0U) || (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)) {
+                break;
+            }
+            vTaskDelay(1);
+        }
+    }
     return len;
 }
 
@@ -57,17 +144,8 @@ short userShellWrite(char *data, unsigned short len)
  */
 short userShellRead(char *data, unsigned short len)
 {
-    //return serialReceive(&debugSerial, (uint8_t *)data, len, 0);
-    
-    // shell 1个字符1个字符接收
-
-    // OK返回0, 使用中断/常规
-    //if (0 == HAL_UART_Receive_IT(&huart1, (uint8_t*)data, len)) {
-    if (0 == HAL_UART_Receive(&huart1, (uint8_t*)data, len, SHELL_RXTX_TOUT)) {
-        return len;
-    } else {
-        return 0;
-    }
+    // 从UART1的循环DMA接收缓存里读, 不阻塞
+    return (short)UartDrv_u32Read(&stUart1Drv, (uint8_t *)data, len);
 }
 
 #if (SHELL_TASK_WHILE == 1)            // 使用RTOS
@@ -111,75 +189,75 @@ void User_Shell_Init(void)
     shell.write = userShellWrite;
     shell.read = userShellRead;
     #if (SHELL_USING_LOCK == 1)
-    shellMutex = xSemaphoreCreateMutex();
+    shellMutex = xSemaphoreCreateRecursiveMutex();
     shell.lock = userShellLock;
     shell.unlock = userShellUnlock;
     #endif
-    shellInit(&shell, shellBuffer, SHELL_BUFF_LEN);
-    HAL_Delay(500);           // shell 初始化会通过串口发送字符
+    shellInit(&shell, shellBuffer, SHELL_BUFF_LEN);    // 输出留在缓存里, 调度器启动后发送
+    PutUart1ToLisen();        // 启动UART1的循环DMA接收
 }
 
-#if (SHELL_RUN_IN_IDLE_TASK == 1)   // shell 任务放在RTOS的IDLE任务内运行
-
-// 这个钩子函数不可以调用会引起空闲任务阻塞的API函数，例如：
-// vTaskDelay()、带有阻塞时间的队列和信号量函数
-extern UBaseType_t uxHighWaterMark[5];
-void vApplicationIdleHook( void )
-{
-    char data = 0;
-    //uint32_t buff[32] = {0}; // 用于测试任务堆栈使用
-    if (shell.read && shell.read(&data, 1) == 1)
-    {
-        shellHandler(&shell, data);
-    }
-    uxTaskGetStackHighWaterMark( NULL );
-    //uxHighWaterMark[3] = buff[0];
-}
-
-// shell任务放在RTOS的IDLE任务内运行,不需要单独创建任务
-void Shell_Task_Create(void)
+// UART1接收事件(中断里): 唤醒shell任务
+static void Shell_RxNotify(UartDrv_t *pDrv)
 {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+    (void)pDrv;
+    if (xShellTaskHandle != NULL) {
+        vTaskNotifyGiveFromISR(xShellTaskHandle, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
 }
 
-#else                              // shell 任务单独创建任务运行
-
 /**
  * @brief shell 任务
  * 
  * @param param 参数(shell对象)
  * 
+ * 没有输入时一直阻塞, 由UART1接收事件唤醒, 空闲任务真正空闲
  */
 void User_Shell_Task(void *param)
 {
-    char data = 0;
+    char data[SHELL_RX_CHUNK];
     Shell *shell = (Shell *)param;
+    uint32_t u32State;
+    bool bTxLeft;
+    short i, n;
+
+    xShellTaskHandle = xTaskGetCurrentTaskHandle();
+    UartDrv_SetRxNotify(&stUart1Drv, Shell_RxNotify, NULL);
     while(1)
     {
-        if (shell->read && shell->read(&data, 1) == 1)
+        while ((n = shell->read(data, sizeof(data))) > 0)
         {
-            shellHandler(shell, data);
+            for (i = 0; i < n; i++)
+            {
+                shellHandler(shell, data[i]);
+            }
         }
-        //vTaskDelay(2);  // 任务加延时会导致很多按键不可用
+
+        SHELL_TX_LOCK(u32State);
+        Shell_TxKick();
+        bTxLeft = (u8ShellTxBusy == 0U) && (u32ShellTxSend != u32ShellTxHead);
+        SHELL_TX_UNLOCK(u32State);
+        (void)ulTaskNotifyTake(pdTRUE, bTxLeft ? SHELL_TX_RETRY : portMAX_DELAY);
     }
 }
 
 
 void Shell_Task_Create(void)
 {
-    BaseType_t result = pdFAIL;
-    result = xTaskCreate( (TaskFunction_t )User_Shell_Task,
-                          (const char*    )"shell",
-                          (uint16_t       )256,
-                          (void*          )&shell,
-                          (UBaseType_t    )1,                // 最低的优先级
-                          (TaskHandle_t*  )NULL);
-    
-    if(pdPASS == result) { // 创建成功
-      //printf2buffatinit("shell task Create Success\r\n");
-    }
+    static StaticTask_t ShellTaskTCB;
+    static StackType_t ShellTaskStack[SHELL_TASK_STACK];
+
+    (void)xTaskCreateStatic((TaskFunction_t )User_Shell_Task,
+                            (const char*    )"shell",
+                            (uint32_t       )SHELL_TASK_STACK,
+                            (void*          )&shell,
+                            (UBaseType_t    )1,                // 最低的优先级
+                            (StackType_t*   )ShellTaskStack,
+                            (StaticTask_t*  )&ShellTaskTCB);
 }
-#endif
 //CEVENT_EXPORT(EVENT_INIT_STAGE2, userShellInit);
 
 #else // 不使用RTOS时
@@ -159,6 +159,12 @@ ShellCommand* shellSeekCommand(Shell *shell,
                                ShellCommand *base,
                                unsigned short compareLength);
 static void shellWriteCommandHelp(Shell *shell, char *cmd);
+#if SHELL_COMMAND_INDEX_MAX > 0
+static void shellBuildCommandIndex(Shell *shell);
+#endif
+#if SHELL_KEY_INDEX_MAX > 0
+static void shellBuildKeyIndex(Shell *shell);
+#endif
 
 /**
  * @brief shell 初始化
@@ -170,6 +176,9 @@ void shellInit(Shell *shell, char *buffer, unsigned short size)
     shell->parser.length = 0;
     shell->parser.cursor = 0;
     shell->info.user = NULL;
+#if SHELL_OUTPUT_BUFFER > 0
+    shell->output.length = 0;
+#endif
     shell->status.isChecked = 1;
 
     shell->parser.buffer = buffer;
@@ -210,6 +219,14 @@ void shellInit(Shell *shell, char *buffer, unsigned short size)
     shell->commandList.count = shellCommandCount;
 #endif
 
+#if SHELL_COMMAND_INDEX_MAX > 0
+    shellBuildCommandIndex(shell);
+#endif
+#if SHELL_KEY_INDEX_MAX > 0
+    shell->parser.keyDepth = 0;
+    shellBuildKeyIndex(shell);
+#endif
+
     shellAdd(shell);
 
     shellSetUser(shell, shellSeekCommand(shell,
@@ -217,6 +234,7 @@ void shellInit(Shell *shell, char *buffer, unsigned short size)
                                          shell->commandList.base,
                                          0));
     shellWritePrompt(shell, 1);
+    shellFlush(shell);
 }
 
 
@@ -281,7 +299,80 @@ Shell* shellGetCurrent(void)
  */
 static void shellWriteByte(Shell *shell, char data)
 {
+#if SHELL_OUTPUT_BUFFER > 0
+    SHELL_LOCK(shell);
+    shell->output.buffer[shell->output.length++] = data;
+    if (shell->output.length == SHELL_OUTPUT_BUFFER || data == '\n')
+    {
+        shellFlush(shell);
+    }
+    SHELL_UNLOCK(shell);
+#else
     shell->write(&data, 1);
+#endif
+}
+
+
+/**
+ * @brief shell 写数据
+ *        合并到输出缓冲, 缓冲满或者数据里有换行时调用一次shell->write
+ *        锁只保护输出缓冲, 一次写入的数据不会和其他任务的输出交错
+ * 
+ * @param shell shell对象
+ * @param data 数据
+ * @param length 数据长度
+ */
+static void shellWriteData(Shell *shell, const char *data, unsigned short length)
+{
+#if SHELL_OUTPUT_BUFFER > 0
+    unsigned short count;
+    char newline = 0;
+
+    SHELL_LOCK(shell);
+    while (length > 0)
+    {
+        count = SHELL_OUTPUT_BUFFER - shell->output.length;
+        count = (length < count) ? length : count;
+        memcpy(&shell->output.buffer[shell->output.length], data, count);
+        if (!newline && memchr(data, '\n', count))
+        {
+            newline = 1;
+        }
+        shell->output.length += count;
+        data += count;
+        length -= count;
+        if (shell->output.length == SHELL_OUTPUT_BUFFER)
+        {
+            shellFlush(shell);
+        }
+    }
+    if (newline)
+    {
+        shellFlush(shell);
+    }
+    SHELL_UNLOCK(shell);
+#else
+    shell->write((char *)data, length);
+#endif
+}
+
+
+/**
+ * @brief shell 发送输出缓冲里的数据
+ * 
+ * @param shell shell对象
+ */
+void shellFlush(Shell *shell)
+{
+#if SHELL_OUTPUT_BUFFER > 0
+    SHELL_LOCK(shell);
+    if (shell->output.length > 0)
+    {
+        shell->write(shell->output.buffer, shell->output.length);
+        shell->output.length = 0;
+    }
+    SHELL_UNLOCK(shell);
+#endif
 }
 
 
@@ -302,7 +393,8 @@ unsigned short shellWriteString(Shell *shell, const char *string)
     {
         count ++;
     }
-    return shell->write((char *)string, count);
+    shellWriteData(shell, string, count);
+    return count;
 }
 
 
@@ -327,12 +419,12 @@ static unsigned short shellWriteCommandDesc(Shell *shell, const char *string)
     
     if (count > 36)
     {
-        shell->write((char *)string, 36);
-        shell->write("...", 3);
+        shellWriteData(shell, string, 36);
+        shellWriteData(shell, "...", 3);
     }
     else
     {
-        shell->write((char *)string, count);
+        shellWriteData(shell, string, count);
     }
     return count > 36 ? 36 : 39;
 }
@@ -385,6 +477,11 @@ void shellPrint(Shell *shell, const char *fmt, ...)
     va_end(vargs);
     
     shellWriteString(shell, buffer);
+    if (!shell->status.isActive)
+    {
+        /* 不是在命令里输出的(其他任务), 马上发送 */
+        shellFlush(shell);
+    }
 }
 #endif
 
@@ -407,10 +504,12 @@ void shellScan(Shell *shell, char *fmt, ...)
 
     if (shell->read)
     {
+        shellFlush(shell);
         do {
             if (shell->read(&buffer[index], 1) == 1)
             {
-                shell->write(&buffer[index], 1);
+                shellWriteByte(shell, buffer[index]);
+                shellFlush(shell);
                 index++;
             }
         } while (buffer[index -1] != '\r' && buffer[index -1] != '\n' && index < SHELL_SCAN_BUFFER);
@@ -957,6 +1056,260 @@ static void shellRemoveParamQuotes(Shell *shell)
 }
 
 
+#if SHELL_COMMAND_INDEX_MAX > 0
+/**
+ * 命令索引, 所有shell共用同一个命令表, 只建立一次
+ */
+static unsigned short shellCommandIndex[SHELL_COMMAND_INDEX_MAX];
+static unsigned short shellCommandIndexCount = 0;
+static void *shellCommandIndexBase = NULL;
+
+/**
+ * @brief shell 建立命令索引
+ *        按命令名排序(插入排序, 同名的保持命令表里的顺序), 按键不参与索引
+ *        命令数超过SHELL_COMMAND_INDEX_MAX时不建立索引, 仍然顺序查找
+ * 
+ * @param shell shell对象
+ */
+static void shellBuildCommandIndex(Shell *shell)
+{
+    ShellCommand *base = (ShellCommand *)shell->commandList.base;
+    unsigned short count = 0;
+    short j;
+
+    shell->commandList.index = NULL;
+    shell->commandList.indexCount = 0;
+    if (shellCommandIndexBase != shell->commandList.base)
+    {
+        for (unsigned short i = 0; i < shell->commandList.count; i++)
+        {
+            if (base[i].attr.attrs.type == SHELL_TYPE_KEY)
+            {
+                continue;
+            }
+            if (count >= SHELL_COMMAND_INDEX_MAX)
+            {
+                shellCommandIndexBase = NULL;
+                return;
+            }
+            for (j = count - 1;
+                 j >= 0 && strcmp(shellGetCommandName(&base[shellCommandIndex[j]]),
+                                  shellGetCommandName(&base[i])) > 0;
+                 j--)
+            {
+                shellCommandIndex[j + 1] = shellCommandIndex[j];
+            }
+            shellCommandIndex[j + 1] = i;
+            count++;
+        }
+        shellCommandIndexCount = count;
+        shellCommandIndexBase = shell->commandList.base;
+    }
+    shell->commandList.index = shellCommandIndex;
+    shell->commandList.indexCount = shellCommandIndexCount;
+}
+
+
+/**
+ * @brief shell 在命令索引里查找第一个不小于cmd的位置
+ * 
+ * @param shell shell对象
+ * @param cmd 命令
+ * @param compareLength 匹配字符串长度, 为0时比较整个命令名
+ * @return unsigned short 索引位置
+ */
+static unsigned short shellCommandLowerBound(Shell *shell,
+                                             const char *cmd,
+                                             unsigned short compareLength)
+{
+    ShellCommand *base = (ShellCommand *)shell->commandList.base;
+    unsigned short *index = shell->commandList.index;
+    unsigned short low = 0;
+    unsigned short high = shell->commandList.indexCount;
+    unsigned short mid;
+    const char *name;
+    int result;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        name = shellGetCommandName(&base[index[mid]]);
+        result = compareLength ? strncmp(name, cmd, compareLength) : strcmp(name, cmd);
+        if (result < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+#endif /** SHELL_COMMAND_INDEX_MAX > 0 */
+
+
+#if SHELL_KEY_INDEX_MAX > 0
+/**
+ * 按键索引, 按键值(无符号)升序, 等价于按字节的前缀树:
+ * 前几个字节相同的按键在索引里相邻, 匹配过程只需要记录当前的区间
+ */
+#define SHELL_KEY_BYTE(value, depth) \
+        ((unsigned char)((unsigned int)(value) >> (24 - 8 * (depth))))
+
+static unsigned short shellKeyIndex[SHELL_KEY_INDEX_MAX];
+static unsigned short shellKeyIndexCount = 0;
+static unsigned char shellKeyFirst[32];                 /* 按键第一个字节的位图 */
+static void *shellKeyIndexBase = NULL;
+
+/**
+ * @brief shell 建立按键索引
+ *        按键值相同的保持命令表里的顺序
+ *        按键数超过SHELL_KEY_INDEX_MAX时不建立索引, 仍然遍历命令表匹配
+ * 
+ * @param shell shell对象
+ */
+static void shellBuildKeyIndex(Shell *shell)
+{
+    ShellCommand *base = (ShellCommand *)shell->commandList.base;
+    unsigned short count = 0;
+    unsigned char byte;
+    short j;
+
+    shell->commandList.keyIndex = NULL;
+    shell->commandList.keyCount = 0;
+    if (shellKeyIndexBase != shell->commandList.base)
+    {
+        memset(shellKeyFirst, 0, sizeof(shellKeyFirst));
+        for (unsigned short i = 0; i < shell->commandList.count; i++)
+        {
+            if (base[i].attr.attrs.type != SHELL_TYPE_KEY
+                || base[i].data.key.value == 0)
+            {
+                continue;
+            }
+            if (count >= SHELL_KEY_INDEX_MAX)
+            {
+                shellKeyIndexBase = NULL;
+                return;
+            }
+            for (j = count - 1;
+                 j >= 0 && (unsigned int)base[shellKeyIndex[j]].data.key.value
+                            > (unsigned int)base[i].data.key.value;
+                 j--)
+            {
+                shellKeyIndex[j + 1] = shellKeyIndex[j];
+            }
+            shellKeyIndex[j + 1] = i;
+            count++;
+            byte = SHELL_KEY_BYTE(base[i].data.key.value, 0);
+            shellKeyFirst[byte >> 3] |= 1 << (byte & 0x07);
+        }
+        shellKeyIndexCount = count;
+        shellKeyIndexBase = shell->commandList.base;
+    }
+    shell->commandList.keyIndex = shellKeyIndex;
+    shell->commandList.keyCount = shellKeyIndexCount;
+}
+
+
+/**
+ * @brief shell 按键索引匹配
+ *        在前缀匹配的区间里二分出第depth个字节等于data的一段,
+ *        取命令表里最靠前的有权限的按键, 和遍历命令表的结果相同
+ * 
+ * @param shell shell对象
+ * @param data 输入的数据
+ * @return char 没有匹配的按键时返回data, 否则返回0
+ */
+static char shellKeyMatch(Shell *shell, char data)
+{
+    ShellCommand *base = (ShellCommand *)shell->commandList.base;
+    unsigned short *index = shell->commandList.keyIndex;
+    unsigned char byte = (unsigned char)data;
+    unsigned char depth = shell->parser.keyDepth;
+    unsigned short low = 0;
+    unsigned short high = shell->commandList.keyCount;
+    unsigned short left, right, mid;
+    unsigned short found = shell->commandList.count;
+
+    if (depth == 0)
+    {
+        /* 普通字符直接返回, 不用查找 */
+        if (!(shellKeyFirst[byte >> 3] & (1 << (byte & 0x07))))
+        {
+            return data;
+        }
+    }
+    else
+    {
+        low = shell->parser.keyLow;
+        high = shell->parser.keyHigh;
+    }
+
+    left = low;
+    right = high;
+    while (left < right)
+    {
+        mid = left + (right - left) / 2;
+        if (SHELL_KEY_BYTE(base[index[mid]].data.key.value, depth) < byte)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    low = left;
+    right = high;
+    while (left < right)
+    {
+        mid = left + (right - left) / 2;
+        if (SHELL_KEY_BYTE(base[index[mid]].data.key.value, depth) <= byte)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    high = left;
+
+    for (unsigned short i = low; i < high; i++)
+    {
+        if (index[i] < found && shellCheckPermission(shell, &base[index[i]]) == 0)
+        {
+            found = index[i];
+        }
+    }
+    if (found == shell->commandList.count)
+    {
+        return data;
+    }
+
+    shell->parser.keyValue |= (int)((unsigned int)byte << (24 - 8 * depth));
+    if (depth == 3 || SHELL_KEY_BYTE(base[found].data.key.value, depth + 1) == 0)
+    {
+        if (base[found].data.key.function)
+        {
+            base[found].data.key.function(shell);
+        }
+        shell->parser.keyValue = 0x00000000;
+        shell->parser.keyDepth = 0;
+    }
+    else
+    {
+        shell->parser.keyDepth = depth + 1;
+        shell->parser.keyLow = low;
+        shell->parser.keyHigh = high;
+    }
+    return 0x00;
+}
+#endif /** SHELL_KEY_INDEX_MAX > 0 */
+
+
 /**
  * @brief shell匹配命令
  * 
@@ -972,6 +1325,28 @@ ShellCommand* shellSeekCommand(Shell *shell,
                                unsigned short compareLength)
 {
     const char *name;
+#if SHELL_COMMAND_INDEX_MAX > 0
+    if (shell->commandList.index && base == shell->commandList.base)
+    {
+        unsigned short *index = shell->commandList.index;
+        unsigned short found = shell->commandList.count;
+        /* 同名(或同前缀)的命令在索引里相邻, 按命令表顺序取第一个有权限的 */
+        for (unsigned short i = shellCommandLowerBound(shell, cmd, compareLength);
+             i < shell->commandList.indexCount; i++)
+        {
+            name = shellGetCommandName(&base[index[i]]);
+            if ((compareLength ? strncmp(name, cmd, compareLength) : strcmp(name, cmd)) != 0)
+            {
+                break;
+            }
+            if (index[i] < found && shellCheckPermission(shell, &base[index[i]]) == 0)
+            {
+                found = index[i];
+            }
+        }
+        return (found < shell->commandList.count) ? &base[found] : NULL;
+    }
+#endif /** SHELL_COMMAND_INDEX_MAX > 0 */
     unsigned short count = shell->commandList.count -
         ((int)base - (int)shell->commandList.base) / sizeof(ShellCommand);
     for (unsigned short i = 0; i < count; i++)
@@ -1184,6 +1559,7 @@ setVar, shellSetVar, set var);
 unsigned int shellRunCommand(Shell *shell, ShellCommand *command)
 {
     int returnValue = 0;
+    shellFlush(shell);
     shell->status.isActive = 1;
     if (command->attr.attrs.type == SHELL_TYPE_CMD_MAIN)
     {
@@ -1520,8 +1896,27 @@ void shellTab(Shell *shell)
     {
         shell->parser.buffer[shell->parser.length] = 0;
         ShellCommand *base = (ShellCommand *)shell->commandList.base;
-        for (short i = 0; i < shell->commandList.count; i++)
+        unsigned short first = 0;
+        unsigned short last = shell->commandList.count;
+        unsigned short *index = NULL;
+    #if SHELL_COMMAND_INDEX_MAX > 0
+        /* 有索引时只遍历前缀相同的一段, 按命令名顺序列出 */
+        index = shell->commandList.index;
+        if (index)
+        {
+            first = shellCommandLowerBound(shell, shell->parser.buffer, shell->parser.length);
+            last = shell->commandList.indexCount;
+        }
+    #endif
+        for (unsigned short k = first; k < last; k++)
         {
+            unsigned short i = index ? index[k] : k;
+            if (index
+                && strncmp(shellGetCommandName(&base[i]),
+                           shell->parser.buffer, shell->parser.length) != 0)
+            {
+                break;
+            }
             if (shellCheckPermission(shell, &base[i]) == 0
                 && shellStringCompare(shell->parser.buffer,
                                    (char *)shellGetCommandName(&base[i]))
@@ -1702,28 +2097,14 @@ SHELL_CMD_PERMISSION(0)|SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN)|SHELL_CMD_DISABLE_RE
 help, shellHelp, show command info\r\nhelp [cmd]);
 
 /**
- * @brief shell 输入处理
+ * @brief shell 遍历命令表匹配按键
  * 
  * @param shell shell对象
- * @param data 输入数据
+ * @param data 输入的数据
+ * @return char 没有匹配的按键时返回data, 否则返回0
  */
-void shellHandler(Shell *shell, char data)
+static char shellKeySeek(Shell *shell, char data)
 {
-    SHELL_ASSERT(data, return);
-    SHELL_LOCK(shell);
-
-#if SHELL_LOCK_TIMEOUT > 0
-    if (shell->info.user->data.user.password
-        && strlen(shell->info.user->data.user.password) != 0
-        && SHELL_GET_TICK())
-    {
-        if (SHELL_GET_TICK() - shell->info.activeTime > SHELL_LOCK_TIMEOUT)
-        {
-            shell->status.isChecked = 0;
-        }
-    }
-#endif
-
     /* 根据记录的按键键值计算当前字节在按键键值中的偏移 */
     char keyByteOffset = 24;
     int keyFilter = 0x00000000;
@@ -1772,10 +2153,49 @@ void shellHandler(Shell *shell, char data)
             }
         }
     }
+    return data;
+}
+
+
+/**
+ * @brief shell 输入处理
+ * 
+ * @param shell shell对象
+ * @param data 输入数据
+ */
+void shellHandler(Shell *shell, char data)
+{
+    SHELL_ASSERT(data, return);
+
+#if SHELL_LOCK_TIMEOUT > 0
+    if (shell->info.user->data.user.password
+        && strlen(shell->info.user->data.user.password) != 0
+        && SHELL_GET_TICK())
+    {
+        if (SHELL_GET_TICK() - shell->info.activeTime > SHELL_LOCK_TIMEOUT)
+        {
+            shell->status.isChecked = 0;
+        }
+    }
+#endif
+
+#if SHELL_KEY_INDEX_MAX > 0
+    if (shell->commandList.keyIndex)
+    {
+        data = shellKeyMatch(shell, data);
+    }
+    else
+#endif
+    {
+        data = shellKeySeek(shell, data);
+    }
 
     if (data != 0x00)
     {
         shell->parser.keyValue = 0x00000000;
+    #if SHELL_KEY_INDEX_MAX > 0
+        shell->parser.keyDepth = 0;
+    #endif
         shellNormalInput(shell, data);
     }
 
@@ -1783,7 +2203,7 @@ void shellHandler(Shell *shell, char data)
     {
         shell->info.activeTime = SHELL_GET_TICK();
     }
-    SHELL_UNLOCK(shell);
+    shellFlush(shell);
 }
 
 
@@ -1795,7 +2215,7 @@ void shellWriteEndLine(Shell *shell, char *buffer, int len)
     {
         shellWriteString(shell, shellText[SHELL_TEXT_CLEAR_LINE]);
     }
-    shell->write(buffer, len);
+    shellWriteData(shell, buffer, (unsigned short)len);
 
     if (!shell->status.isActive)
     {
@@ -1809,6 +2229,7 @@ void shellWriteEndLine(Shell *shell, char *buffer, int len)
             }
         }
     }
+    shellFlush(shell);
     SHELL_UNLOCK(shell);
 }
 #endif /** SHELL_SUPPORT_END_LINE == 1 */
@@ -1944,6 +2365,64 @@ int shellRun(Shell *shell, const char *cmd)
 }
 
 
+/**
+ * @brief shell 执行一行命令(脚本)
+ *        不回显, 不记录历史, 不输出提示符; 在line里原地解析参数,
+ *        不使用也不破坏输入缓冲, 可以在命令函数里调用
+ * 
+ * @param shell shell对象
+ * @param line 命令行, 解析时会被修改
+ * @param result 命令的返回值, 可以为NULL; 不显示返回值的命令(disableReturn)为0
+ * @return int 0 执行成功(或空行), -1 命令不存在
+ */
+int shellRunLine(Shell *shell, char *line, int *result)
+{
+    SHELL_ASSERT(shell && line, return -1);
+    char *buffer = shell->parser.buffer;
+    unsigned short length = shell->parser.length;
+    unsigned short cursor = shell->parser.cursor;
+    unsigned short paramCount = shell->parser.paramCount;
+    char *param[SHELL_PARAMETER_MAX_NUMBER];
+    char active = shell->status.isActive;
+    ShellCommand *command;
+    int returnValue;
+    int ret = 0;
+
+    memcpy(param, shell->parser.param, sizeof(param));
+    shell->parser.buffer = line;
+    shell->parser.length = strlen(line);
+    shellParserParam(shell);
+    if (shell->parser.paramCount > 0)
+    {
+        command = shellSeekCommand(shell,
+                                   shell->parser.param[0],
+                                   shell->commandList.base,
+                                   0);
+        if (command != NULL)
+        {
+            returnValue = (int)shellRunCommand(shell, command);
+            if (result)
+            {
+                *result = command->attr.attrs.disableReturn ? 0 : returnValue;
+            }
+        }
+        else
+        {
+            shellWriteString(shell, shellText[SHELL_TEXT_CMD_NOT_FOUND]);
+            ret = -1;
+        }
+    }
+
+    shell->parser.buffer = buffer;
+    shell->parser.length = length;
+    shell->parser.cursor = cursor;
+    shell->parser.paramCount = paramCount;
+    memcpy(shell->parser.param, param, sizeof(param));
+    shell->status.isActive = active;
+    return ret;
+}
+
+
 #if SHELL_EXEC_UNDEF_FUNC == 1
 /**
  * @brief shell执行未定义函数
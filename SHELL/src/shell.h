@@ -343,6 +343,11 @@ typedef struct shell_def
         unsigned short bufferSize;                              /**< 输入缓冲大小 */
         unsigned short paramCount;                              /**< 参数数量 */
         int keyValue;                                           /**< 输入按键键值 */
+    #if SHELL_KEY_INDEX_MAX > 0
+        unsigned char keyDepth;                                 /**< 已匹配的按键字节数 */
+        unsigned short keyLow;                                  /**< 前缀匹配的按键索引区间 */
+        unsigned short keyHigh;
+    #endif
     } parser;
 #if SHELL_HISTORY_MAX_NUMBER > 0
     struct
@@ -357,7 +362,22 @@ typedef struct shell_def
     {
         void *base;                                             /**< 命令表基址 */
         unsigned short count;                                   /**< 命令数量 */
+    #if SHELL_COMMAND_INDEX_MAX > 0
+        unsigned short *index;                                  /**< 按命令名排序的索引 */
+        unsigned short indexCount;                              /**< 索引条目数 */
+    #endif
+    #if SHELL_KEY_INDEX_MAX > 0
+        unsigned short *keyIndex;                               /**< 按键值排序的按键索引 */
+        unsigned short keyCount;                                /**< 按键索引条目数 */
+    #endif
     } commandList;
+#if SHELL_OUTPUT_BUFFER > 0
+    struct
+    {
+        char buffer[SHELL_OUTPUT_BUFFER];                       /**< 输出缓冲 */
+        unsigned short length;                                  /**< 缓冲中的数据长度 */
+    } output;
+#endif
     struct
     {
         unsigned char isChecked : 1;                            /**< 密码校验通过 */
@@ -440,6 +460,7 @@ typedef struct
 void shellInit(Shell *shell, char *buffer, unsigned short size);
 void shellRemove(Shell *shell);
 unsigned short shellWriteString(Shell *shell, const char *string);
+void shellFlush(Shell *shell);
 void shellPrint(Shell *shell, const char *fmt, ...);
 void shellScan(Shell *shell, char *fmt, ...);
 Shell* shellGetCurrent(void);
@@ -447,6 +468,7 @@ void shellHandler(Shell *shell, char data);
 void shellWriteEndLine(Shell *shell, char *buffer, int len);
 void shellTask(void *param);
 int shellRun(Shell *shell, const char *cmd);
+int shellRunLine(Shell *shell, char *line, int *result);
 
 
 
@@ -157,6 +157,24 @@
 #define     SHELL_MAX_NUMBER            5
 #endif /** SHELL_MAX_NUMBER */
 
+#ifndef SHELL_COMMAND_INDEX_MAX
+/**
+ * @brief 命令索引的最大条目数
+ *        shellInit时把命令表按命令名排序建立索引，查找命令和tab补全使用二分查找
+ *        为0时不使用索引，命令数(不含按键)超过此值时仍然顺序查找
+ */
+#define     SHELL_COMMAND_INDEX_MAX     256
+#endif /** SHELL_COMMAND_INDEX_MAX */
+
+#ifndef SHELL_KEY_INDEX_MAX
+/**
+ * @brief 按键索引的最大条目数
+ *        shellInit时把按键按键值排序，输入的每个字节只在前缀相同的按键里匹配
+ *        为0时不使用索引，按键数超过此值时仍然遍历命令表匹配
+ */
+#define     SHELL_KEY_INDEX_MAX         32
+#endif /** SHELL_KEY_INDEX_MAX */
+
 #ifndef SHELL_PRINT_BUFFER
 /**
  * @brief shell格式化输出的缓冲大小
@@ -165,6 +183,15 @@
 #define     SHELL_PRINT_BUFFER          128
 #endif /** SHELL_PRINT_BUFFER */
 
+#ifndef SHELL_OUTPUT_BUFFER
+/**
+ * @brief shell输出缓冲大小
+ *        输出先合并到缓冲里，遇到换行、缓冲满、处理完一个输入字节或调用`shellFlush()`时
+ *        才调用一次`shell->write`；为0时不使用输出缓冲，每次输出直接调用`shell->write`
+ */
+#define     SHELL_OUTPUT_BUFFER         128
+#endif /** SHELL_OUTPUT_BUFFER */
+
 #ifndef SHELL_SCAN_BUFFER
 /**
  * @brief shell格式化输入的缓冲大小
@@ -187,8 +214,10 @@
 /**
  * @brief 使用锁
  * @note 使用shell锁时，需要对加锁和解锁进行实现
+ *       使用操作系统时其他任务也会调用`shellPrint()`，需要用锁保护输出缓冲；
+ *       锁只在写输出缓冲和发送时持有，执行命令时不持有，不会阻塞其他任务的输出
  */
-#define     SHELL_USING_LOCK            0
+#define     SHELL_USING_LOCK            SHELL_TASK_WHILE
 #endif /** SHELL_USING_LOCK */
 
 #ifndef SHELL_MALLOC
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+STM32H747I-DISCO study
+二进制日志(binlog)主机解码工具
+
+从ELF文件读出.logstr段的格式字符串, 把串口(或抓包文件)里的二进制记录还原成文本,
+普通文本日志原样输出.
+
+记录格式(小端): 0x00 | 参数个数 | 格式字符串地址(4) | DWT时间戳(4) | 参数(4*n)
+
+用法:
+    python binlog_decode.py FreeRTOS_CM7.elf COM5 [--baud 115200] [--clock 400000000]
+    python binlog_decode.py FreeRTOS_CM7.elf capture.bin
+串口需要安装pyserial.
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = 0x00
+ARGS_MAX = 4
+SECTION = '.logstr'
+
+# C格式转换: 去掉长度修饰符, 按32位整数处理
+CONV = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXcp%])')
+
+
+def load_logstr(elf_path):
+    """返回 {地址: 格式字符串}"""
+    with open(elf_path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        raise SystemExit('%s: not an ELF32 file' % elf_path)
+    e_shoff, = struct.unpack_from('<I', elf, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from('<HHH', elf, 0x2E)
+
+    def shdr(i):
+        return struct.unpack_from('<10I', elf, e_shoff + i * e_shentsize)
+
+    shstr = shdr(e_shstrndx)
+    names = elf[shstr[4]:shstr[4] + shstr[5]]
+    table = {}
+    for i in range(e_shnum):
+        sh = shdr(i)
+        name = names[sh[0]:names.index(b'\0', sh[0])].decode()
+        if name != SECTION:
+            continue
+        addr, off, size = sh[3], sh[4], sh[5]
+        data = elf[off:off + size]
+        pos = 0
+        while pos < size:
+            end = data.find(b'\0', pos)
+            if end < 0:
+                end = size
+            if end > pos:
+                table[addr + pos] = data[pos:end].decode('utf-8', 'replace')
+            pos = end + 1
+    if not table:
+        raise SystemExit('%s: no %s section' % (elf_path, SECTION))
+    return table
+
+
+def format_c(fmt, args):
+    """用32位整数参数实现C的printf整数转换"""
+    it = iter(args)
+
+    def repl(m):
+        flags, conv = m.group(1), m.group(3)
+        if conv == '%':
+            return '%'
+        val = next(it, 0)
+        if conv in 'di':
+            val = val - (1 << 32) if val & 0x80000000 else val
+            conv = 'd'
+        elif conv == 'u':
+            conv = 'd'
+        elif conv == 'p':
+            return '0x%08x' % val
+        elif conv == 'c':
+            return chr(val & 0xFF)
+        return ('%' + flags + conv) % val
+
+    return CONV.sub(repl, fmt)
+
+
+class Decoder(object):
+    def __init__(self, table, clock):
+        self.table = table
+        self.clock = float(clock)
+        self.buf = bytearray()
+        self.last_ts = None
+
+    def feed(self, data):
+        self.buf += data
+        out = []
+        while self.buf:
+            if self.buf[0] != SYNC:
+                end = self.buf.find(bytes([SYNC]))
+                end = len(self.buf) if end < 0 else end
+                out.append(self.buf[:end].decode('utf-8', 'replace'))
+                del self.buf[:end]
+                continue
+            if len(self.buf) < 2:
+                break
+            nargs = self.buf[1]
+            if nargs > ARGS_MAX:                      # 不是记录, 丢掉起始字节重新同步
+                del self.buf[:1]
+                continue
+            size = 10 + 4 * nargs
+            if len(self.buf) < size:
+                break
+            addr, ts = struct.unpack_from('<II', self.buf, 2)
+            args = struct.unpack_from('<%dI' % nargs, self.buf, 10)
+            fmt = self.table.get(addr)
+            if fmt is None:
+                del self.buf[:1]
+                continue
+            del self.buf[:size]
+            out.append(self.stamp(ts) + format_c(fmt, args))
+        return ''.join(out)
+
+    def stamp(self, ts):
+        # DWT计数器会回绕, 只显示和上一条记录的时间差
+        if self.last_ts is None:
+            delta = 0
+        else:
+            delta = (ts - self.last_ts) & 0xFFFFFFFF
+        self.last_ts = ts
+        return '[+%10.3f us] ' % (delta * 1e6 / self.clock)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='decode binlog records from the CM7 debug UART')
+    ap.add_argument('elf', help='CM7 ELF image with the .logstr section')
+    ap.add_argument('source', help='serial port (COMx, /dev/ttyX) or capture file')
+    ap.add_argument('--baud', type=int, default=115200)
+    ap.add_argument('--clock', type=float, default=400e6, help='DWT cycle counter clock in Hz')
+    opt = ap.parse_args()
+
+    dec = Decoder(load_logstr(opt.elf), opt.clock)
+    out = sys.stdout
+
+    if os.path.isfile(opt.source):
+        with open(opt.source, 'rb') as f:
+            out.write(dec.feed(f.read()))
+        return
+
+    import serial
+    port = serial.Serial(opt.source, opt.baud, timeout=0.1)
+    try:
+        while True:
+            data = port.read(256)
+            if data:
+                out.write(dec.feed(data))
+                out.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+STM32H747I-DISCO study
+shell串口文件传输工具, 对应板上的shell命令fxput/fxget(FS/filexfer.c)
+
+帧格式(小端): A5 5A | 类型(1) | 序号(4) | 长度(2) | 数据 | CRC32(4, 从类型到数据, 同zlib.crc32)
+数据块1024字节, 序号是块号; 接收方用ACK(序号=期望的下一块, 数据=允许发送的块号上限)
+确认和发放信用, 缺块或CRC错误时回NAK, 发送方从该块重发. 最后END帧核对长度和文件CRC32.
+
+用法:
+    python file_xfer.py put local.bin /dir/name.bin COM6 [--baud 115200]
+    python file_xfer.py get /dir/name.bin local.bin /dev/pts/3
+串口需要安装pyserial; 没有pyserial时, POSIX系统上直接用termios打开tty/pty.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+SOF = b'\xa5\x5a'
+HDR = struct.Struct('<BIH')                 # 类型, 序号, 长度
+BLOCK = 1024
+WINDOW = 8                                  # get时本工具发放的信用(块数)
+TIMEOUT = 1.0                               # 没有确认时重发
+IDLE = 10.0                                 # 对方一直没有响应时放弃
+
+T_START, T_DATA, T_END, T_ACK, T_NAK, T_FIN, T_CAN = b'SDEANFC'
+
+ERRORS = {
+    -1001: 'timeout', -1002: 'cancelled', -1003: 'length mismatch', -1004: 'crc mismatch', -1005: 'uart',
+    -5: 'lfs io', -2: 'lfs no such file', -28: 'lfs no space', -36: 'lfs name too long',
+}
+
+
+def build(ftype, seq, payload=b''):
+    body = HDR.pack(ftype, seq, len(payload)) + payload
+    return SOF + body + struct.pack('<I', zlib.crc32(body))
+
+
+class TermiosPort(object):
+    """没有pyserial时的最小实现, 只支持POSIX tty/pty"""
+
+    def __init__(self, path, baud):
+        import termios
+        import tty
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        attr = termios.tcgetattr(self.fd)
+        speed = getattr(termios, 'B%d' % baud, None)
+        if speed is not None:
+            attr[4] = attr[5] = speed
+        termios.tcsetattr(self.fd, termios.TCSANOW, attr)
+
+    def write(self, data):
+        while data:
+            n = os.write(self.fd, data)
+            data = data[n:]
+
+    def read(self, timeout):
+        import select
+        r, _, _ = select.select([self.fd], [], [], timeout)
+        return os.read(self.fd, 4096) if r else b''
+
+    def close(self):
+        os.close(self.fd)
+
+
+class SerialPort(object):
+    def __init__(self, path, baud):
+        import serial
+        self.port = serial.Serial(path, baud, timeout=0)
+
+    def write(self, data):
+        self.port.write(data)
+
+    def read(self, timeout):
+        self.port.timeout = timeout
+        return self.port.read(max(1, self.port.in_waiting))
+
+    def close(self):
+        self.port.close()
+
+
+def open_port(path, baud):
+    try:
+        return SerialPort(path, baud)
+    except ImportError:
+        return TermiosPort(path, baud)
+
+
+class Link(object):
+    """帧收发, 帧之外的字节(shell回显和提示符)丢弃"""
+
+    def __init__(self, port):
+        self.port = port
+        self.buf = bytearray()
+        self.crc_errors = 0
+        self.text = bytearray()
+
+    def send(self, ftype, seq, payload=b''):
+        self.port.write(build(ftype, seq, payload))
+
+    def recv(self, timeout):
+        """返回(类型, 序号, 数据), 超时返回None, CRC错误返回(None, 0, b'')"""
+        deadline = time.monotonic() + timeout
+        while True:
+            frame = self._parse()
+            if frame is not None:
+                return frame
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return None
+            self.buf += self.port.read(left)
+
+    def _parse(self):
+        i = self.buf.find(SOF)
+        if i < 0:
+            keep = 1 if self.buf.endswith(SOF[:1]) else 0
+            self.text += self.buf[:len(self.buf) - keep]
+            del self.buf[:len(self.buf) - keep]
+            return None
+        self.text += self.buf[:i]
+        del self.buf[:i]
+        if len(self.buf) < 2 + HDR.size:
+            return None
+        ftype, seq, length = HDR.unpack_from(self.buf, 2)
+        if length > BLOCK:
+            del self.buf[:1]                # 假的帧头, 继续找
+            return self._parse()
+        total = 2 + HDR.size + length + 4
+        if len(self.buf) < total:
+            return None
+        body = bytes(self.buf[2:total - 4])
+        crc, = struct.unpack_from('<I', self.buf, total - 4)
+        if zlib.crc32(body) != crc:
+            self.crc_errors += 1
+            del self.buf[:1]
+            return (None, 0, b'')
+        del self.buf[:total]
+        return (ftype, seq, body[HDR.size:])
+
+
+def status_text(code):
+    return 'ok' if code == 0 else '%d (%s)' % (code, ERRORS.get(code, 'error'))
+
+
+def put(link, data, remote):
+    """本工具发送, 板子接收(fxput)"""
+    link.port.write(b'fxput ' + remote.encode() + b'\r')
+    blocks = (len(data) + BLOCK - 1) // BLOCK
+    acked = nxt = sent = 0
+    limit = None
+    resends = naks = 0
+    end_sent = False
+    last = progress = time.monotonic()
+    while True:
+        if limit is not None:
+            while nxt < blocks and nxt < limit:
+                link.send(T_DATA, nxt, data[nxt * BLOCK:(nxt + 1) * BLOCK])
+                if nxt < sent:
+                    resends += 1
+                nxt += 1
+                sent = max(sent, nxt)
+            if acked == blocks and not end_sent:
+                link.send(T_END, blocks, struct.pack('<II', len(data), zlib.crc32(data)))
+                end_sent = True
+        frame = link.recv(TIMEOUT)
+        now = time.monotonic()
+        if now - progress > TIMEOUT:
+            progress = now                  # 没有进展: 确认或重发的块丢了, 从没有确认的块(或END)重发
+            nxt = acked
+            end_sent = False
+        if frame is None:
+            if now - last > IDLE:
+                link.send(T_CAN, nxt, struct.pack('<i', -1001))
+                return -1001, resends, naks
+            continue
+        ftype, seq, payload = frame
+        if ftype in (T_ACK, T_NAK) and len(payload) >= 4:
+            last = now
+            if seq > acked:
+                acked = seq
+                progress = now
+            lim, = struct.unpack_from('<I', payload)
+            limit = lim if limit is None else max(limit, lim)
+            if ftype == T_NAK:
+                naks += 1
+                nxt = acked
+        elif ftype in (T_FIN, T_CAN):
+            code, = struct.unpack_from('<i', payload) if len(payload) >= 4 else (-1002,)
+            return code, resends, naks
+
+
+def get(link, remote):
+    """板子发送(fxget), 本工具接收"""
+    link.port.write(b'fxget ' + remote.encode() + b'\r')
+    data = bytearray()
+    expect = 0
+    nak_for = None
+    size = None
+    naks = 0
+    last = time.monotonic()
+    while True:
+        frame = link.recv(TIMEOUT)
+        now = time.monotonic()
+        if frame is None:
+            if now - last > IDLE:
+                link.send(T_CAN, expect, struct.pack('<i', -1001))
+                return -1001, None, naks
+            if size is not None:
+                link.send(T_ACK, expect, struct.pack('<I', expect + WINDOW))
+            continue
+        ftype, seq, payload = frame
+        if ftype is None or (ftype == T_DATA and seq > expect):
+            if size is not None and nak_for != expect:
+                nak_for = expect
+                naks += 1
+                link.send(T_NAK, expect, struct.pack('<I', expect + WINDOW))
+            continue
+        last = now
+        if ftype == T_START:
+            size, = struct.unpack_from('<I', payload)
+            link.send(T_ACK, expect, struct.pack('<I', expect + WINDOW))
+        elif ftype == T_DATA:
+            if seq == expect:
+                data += payload
+                expect += 1
+            link.send(T_ACK, expect, struct.pack('<I', expect + WINDOW))
+        elif ftype == T_END:
+            total, crc = struct.unpack_from('<II', payload)
+            if seq != expect:
+                link.send(T_NAK, expect, struct.pack('<I', expect + WINDOW))
+                continue
+            code = 0
+            if total != len(data):
+                code = -1003
+            elif crc != zlib.crc32(data):
+                code = -1004
+            link.send(T_FIN, expect, struct.pack('<i', code))
+            return code, bytes(data), naks
+        elif ftype == T_CAN:
+            code, = struct.unpack_from('<i', payload) if len(payload) >= 4 else (-1002,)
+            return code, None, naks
+
+
+def main():
+    ap = argparse.ArgumentParser(description='binary file transfer over the board shell UART')
+    ap.add_argument('cmd', choices=('put', 'get'))
+    ap.add_argument('src', help='put: local file; get: path on the board')
+    ap.add_argument('dst', help='put: path on the board; get: local file')
+    ap.add_argument('port', help='serial port (COMx, /dev/ttyX) or pty')
+    ap.add_argument('--baud', type=int, default=115200)
+    opt = ap.parse_args()
+
+    port = open_port(opt.port, opt.baud)
+    link = Link(port)
+    t0 = time.monotonic()
+    try:
+        if opt.cmd == 'put':
+            with open(opt.src, 'rb') as f:
+                data = f.read()
+            code, resends, naks = put(link, data, opt.dst)
+            size = len(data)
+        else:
+            code, data, naks = get(link, opt.src)
+            resends = 0
+            size = len(data) if data is not None else 0
+            if code == 0:
+                with open(opt.dst, 'wb') as f:
+                    f.write(data)
+        seconds = time.monotonic() - t0
+        link.recv(0.2)                      # 板子打印的统计
+    finally:
+        port.close()
+
+    rate = size / seconds if seconds > 0 else 0
+    line = opt.baud / 10.0                  # 8N1, 每字节10位
+    print('%s %s: %d bytes in %.2f s, %.1f kB/s (%.0f%% of line rate), resends %d, naks %d, crc err %d'
+          % (opt.cmd, status_text(code), size, seconds, rate / 1024, 100 * rate / line, resends, naks,
+             link.crc_errors))
+    for text in link.text.decode('ascii', 'replace').splitlines():
+        if text.startswith('[fx'):
+            print('board: ' + text)
+    sys.exit(0 if code == 0 else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,199 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 文件传输(filexfer.c)的主机程序(Linux/gcc): 协议和文件操作用板上的同一份代码, shell串口换成伪终端,
+ * littlefs的块设备在内存里(块大小和编程长度和板上相同, 程序退出后文件就没有了).
+ * 从伪终端读命令行, 只认fxput/fxget两个命令, 结束后和板上的shell一样回一行统计.
+ * 启动后打印伪终端从设备的路径, 用Tools/file_xfer.py先上传再下载, 比较两个文件:
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -DFXP_HOST -DUART_DRV_HOST -ICore/Common/Inc -IFS -IFS/littlefs Tools/filexfer_host.c \
+ *       FS/filexfer.c Core/Common/Src/uart_drv.c FS/littlefs/lfs.c FS/littlefs/lfs_util.c -o filexfer_host
+ * 用法:
+ *   ./filexfer_host [baud, 默认115200] &
+ *   head -c 200000 /dev/urandom > a.bin
+ *   python3 Tools/file_xfer.py put a.bin /a.bin /dev/pts/N
+ *   python3 Tools/file_xfer.py get /a.bin b.bin /dev/pts/N && cmp a.bin b.bin
+ */
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "lfs.h"
+#include "uart_drv.h"
+#include "filexfer.h"
+
+#define HOST_BLOCK_SIZE         (8192U)         // BSP_FS_BLOCK_SIZE
+#define HOST_BLOCK_COUNT        (128U)          // 1MB, 板上是2048块
+#define HOST_PROG_SIZE          (128U)          // READ_PROG_BYTEMIN
+#define HOST_RX_SIZE            (16384U)        // COM1_RX_BLEN
+#define HOST_QUIET_MS           (200)           // 传输结束后丢弃对方还在发的帧, 直到安静这么久
+#define HOST_LINE_MAX           (128U)
+
+
+static uint8_t au8Flash[HOST_BLOCK_COUNT][HOST_BLOCK_SIZE];
+static uint8_t au8RxBuff[HOST_RX_SIZE];
+static char acTx[256];
+static UartDrv_Port_t stPort;
+static UartDrv_t stDrv;
+static lfs_t stLfs;
+
+
+static int Host_s32Read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    (void)c;
+    memcpy(buffer, &au8Flash[block][off], size);
+    return 0;
+}
+
+static int Host_s32Prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    const uint8_t *pu8Src = (const uint8_t *)buffer;
+
+    (void)c;
+    for (lfs_size_t i = 0; i < size; i++) {
+        au8Flash[block][off + i] &= pu8Src[i];  // NOR FLASH只能把1写成0
+    }
+    return 0;
+}
+
+static int Host_s32Erase(const struct lfs_config *c, lfs_block_t block)
+{
+    (void)c;
+    memset(au8Flash[block], 0xFF, HOST_BLOCK_SIZE);
+    return 0;
+}
+
+static int Host_s32Sync(const struct lfs_config *c)
+{
+    (void)c;
+    return 0;
+}
+
+static const struct lfs_config stCfg = {
+    .read  = Host_s32Read,
+    .prog  = Host_s32Prog,
+    .erase = Host_s32Erase,
+    .sync  = Host_s32Sync,
+    .read_size = HOST_PROG_SIZE,
+    .prog_size = HOST_PROG_SIZE,
+    .block_size = HOST_BLOCK_SIZE,
+    .block_count = HOST_BLOCK_COUNT,
+    .cache_size = 256,                          // CACHE_SIZE
+    .lookahead_size = 128,                      // LOOKAHEADE_SIZE
+    .block_cycles = 500,                        // BLOCK_CYCLES
+};
+
+// 打开伪终端主设备, 设成原始模式和非阻塞(UartDrv_HostPoll读到没有数据为止)
+static int Host_s32OpenPty(void)
+{
+    struct termios stTio;
+    int s32Fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((s32Fd < 0) || (grantpt(s32Fd) != 0) || (unlockpt(s32Fd) != 0)) {
+        return -1;
+    }
+    if (tcgetattr(s32Fd, &stTio) == 0) {
+        cfmakeraw(&stTio);
+        (void)tcsetattr(s32Fd, TCSANOW, &stTio);
+    }
+    (void)fcntl(s32Fd, F_SETFL, fcntl(s32Fd, F_GETFL) | O_NONBLOCK);
+    return s32Fd;
+}
+
+// 执行一行命令, 和板上的fxput/fxget一样回一行统计(file_xfer.py打印以"[fx"开头的行)
+static void Host_Command(char *pcLine)
+{
+    const FXP_Stat_t *pStat = FXP_pStat();
+    const uint8_t *pu8Data = NULL;
+    struct pollfd stPoll;
+    char *pcCmd = strtok(pcLine, " ");
+    char *pcPath = strtok(NULL, " ");
+    int s32Ret, s32Len;
+
+    if ((pcCmd == NULL) || (pcPath == NULL)) {
+        return;
+    }
+    if (strcmp(pcCmd, "fxput") == 0) {
+        s32Ret = FXP_s32Receive(&stLfs, &stDrv, pcPath);
+    } else if (strcmp(pcCmd, "fxget") == 0) {
+        s32Ret = FXP_s32Send(&stLfs, &stDrv, pcPath);
+    } else {
+        return;
+    }
+
+    s32Len = snprintf(acTx, sizeof(acTx),
+                      "\r\n[%s] %s: %u bytes, %u ms, blocks %u, resends %u, crc err %u, naks %u, stalls %u, ret %d\r\n",
+                      pcCmd, pcPath, (unsigned)pStat->u32Bytes, (unsigned)pStat->u32Ms, (unsigned)pStat->u32Blocks,
+                      (unsigned)pStat->u32Resends, (unsigned)pStat->u32CrcErrors, (unsigned)pStat->u32Naks,
+                      (unsigned)pStat->u32Stalls, s32Ret);
+    (void)UartDrv_bSend(&stDrv, (const uint8_t *)acTx, (uint32_t)s32Len, NULL, NULL);
+    UartDrv_HostPoll(&stDrv);                   // 发送完成事件
+    printf("%s", acTx + 2);
+    fflush(stdout);
+
+    // 出错结束时对方可能还在发数据帧, 丢掉, 不当作下一行命令
+    stPoll.fd = stPort.s32Fd;
+    stPoll.events = POLLIN;
+    while (poll(&stPoll, 1, HOST_QUIET_MS) > 0) {
+        if ((stPoll.revents & POLLIN) == 0) {
+            break;
+        }
+        UartDrv_HostPoll(&stDrv);
+        UartDrv_RxConsume(&stDrv, UartDrv_u32RxPeek(&stDrv, &pu8Data));
+        UartDrv_RxConsume(&stDrv, UartDrv_u32RxPeek(&stDrv, &pu8Data));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct pollfd stPoll;
+    char acLine[HOST_LINE_MAX];
+    uint32_t u32Len = 0U;
+    uint8_t u8Ch;
+
+    stPort.u32Baud = (argc > 1) ? (uint32_t)atoi(argv[1]) : 115200U;
+    stPort.s32Fd = Host_s32OpenPty();
+    if (stPort.s32Fd < 0) {
+        perror("pty");
+        return 1;
+    }
+    if ((lfs_format(&stLfs, &stCfg) != 0) || (lfs_mount(&stLfs, &stCfg) != 0)) {
+        fprintf(stderr, "lfs mount failed\n");
+        return 1;
+    }
+    if (!UartDrv_bInit(&stDrv, "UART1", &stPort, au8RxBuff, sizeof(au8RxBuff)) || !UartDrv_bListen(&stDrv)) {
+        fprintf(stderr, "uart init failed\n");
+        return 1;
+    }
+    printf("%s\n", ptsname(stPort.s32Fd));
+    fflush(stdout);
+
+    stPoll.fd = stPort.s32Fd;
+    stPoll.events = POLLIN;
+    while (poll(&stPoll, 1, -1) >= 0) {
+        if ((stPoll.revents & POLLIN) == 0) {
+            usleep(10000);                      // 从设备还没有打开(POLLHUP)
+            continue;
+        }
+        UartDrv_HostPoll(&stDrv);
+        // 命令行按字节读, 命令后面的帧留在接收缓存里由FXP_s32Receive/FXP_s32Send解析
+        while (UartDrv_u32Read(&stDrv, &u8Ch, 1U) == 1U) {
+            if ((u8Ch == '\r') || (u8Ch == '\n')) {
+                acLine[u32Len] = '\0';
+                u32Len = 0U;
+                Host_Command(acLine);
+            } else if (u32Len < (sizeof(acLine) - 1U)) {
+                acLine[u32Len++] = (char)u8Ch;
+            }
+        }
+    }
+    return 0;
+}
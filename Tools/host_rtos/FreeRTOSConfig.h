@@ -0,0 +1,40 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 主机测试用的FreeRTOS配置: 只编译stream_buffer.c, 任务相关的函数在host_rtos.c里用pthread实现.
+ * 和板上(Core/CM7/Inc/FreeRTOSConfig.h)一样重定义sbSEND_COMPLETED/sbRECEIVE_COMPLETED,
+ * 共享的message buffer通过门铃vGenerateM7ToM4Interrupt()通知对方.
+ */
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <stdint.h>
+#include <assert.h>
+
+void vGenerateM7ToM4Interrupt( void * xUpdatedMessageBuffer );
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configTICK_RATE_HZ                      ( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES                    ( 16 )
+#define configMINIMAL_STACK_SIZE                ( ( uint16_t ) 256 )
+#define configMAX_TASK_NAME_LEN                 ( 16 )
+#define configUSE_16_BIT_TICKS                  0
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   1
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+#define configUSE_TRACE_FACILITY                0
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+
+#define configASSERT( x )                       assert( x )
+
+/* 主机上所有message buffer都当作共享的, 收发完成都走门铃 */
+#define sbIS_SHARED( pxStreamBuffer )           ( 1 )
+#define sbSEND_COMPLETED( pxStreamBuffer )      vGenerateM7ToM4Interrupt( pxStreamBuffer )
+#define sbRECEIVE_COMPLETED( pxStreamBuffer )   vGenerateM7ToM4Interrupt( pxStreamBuffer )
+
+#endif /* FREERTOS_CONFIG_H */
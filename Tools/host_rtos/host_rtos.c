@@ -0,0 +1,218 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 主机测试用的FreeRTOS任务接口(Linux/pthread): 只实现stream_buffer.c用到的部分,
+ * 让板上的message buffer代码不改动地在主机上运行. 每个线程第一次调用时得到自己的任务句柄,
+ * 任务通知用互斥锁加条件变量, tick是CLOCK_MONOTONIC的毫秒数.
+ * 调度器挂起(vTaskSuspendAll)和临界区一样, 都是全局的递归互斥锁.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define HOST_NOTIFY_NONE        (0U)
+#define HOST_NOTIFY_WAITING     (1U)
+#define HOST_NOTIFY_RECEIVED    (2U)
+
+struct tskTaskControlBlock {
+    pthread_mutex_t xLock;
+    pthread_cond_t  xCond;
+    uint32_t u32Value;                          // 通知值
+    uint8_t  u8State;                           // HOST_NOTIFY_xxx
+};
+
+static pthread_mutex_t xHostCritical;
+static pthread_once_t xHostOnce = PTHREAD_ONCE_INIT;
+static __thread struct tskTaskControlBlock *pHostSelf = NULL;
+
+
+static void HostInit(void)
+{
+    pthread_mutexattr_t xAttr;
+
+    (void)pthread_mutexattr_init(&xAttr);
+    (void)pthread_mutexattr_settype(&xAttr, PTHREAD_MUTEX_RECURSIVE);
+    (void)pthread_mutex_init(&xHostCritical, &xAttr);
+}
+
+static TickType_t HostTick(void)
+{
+    struct timespec stTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &stTs);
+    return (TickType_t)(stTs.tv_sec * 1000U + stTs.tv_nsec / 1000000U);
+}
+
+void vHostEnterCritical(void)
+{
+    (void)pthread_once(&xHostOnce, HostInit);
+    (void)pthread_mutex_lock(&xHostCritical);
+}
+
+void vHostExitCritical(void)
+{
+    (void)pthread_mutex_unlock(&xHostCritical);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return HostTick();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    static struct tskTaskControlBlock astTask[16];
+    static uint32_t u32Tasks = 0U;
+    pthread_condattr_t xAttr;
+
+    if (pHostSelf == NULL) {
+        vHostEnterCritical();
+        configASSERT(u32Tasks < sizeof(astTask) / sizeof(astTask[0]));
+        pHostSelf = &astTask[u32Tasks++];
+        vHostExitCritical();
+        (void)pthread_condattr_init(&xAttr);
+        (void)pthread_condattr_setclock(&xAttr, CLOCK_MONOTONIC);   // 超时时间和tick一样用CLOCK_MONOTONIC
+        (void)pthread_mutex_init(&pHostSelf->xLock, NULL);
+        (void)pthread_cond_init(&pHostSelf->xCond, &xAttr);
+    }
+    return pHostSelf;
+}
+
+void vTaskSuspendAll(void)
+{
+    vHostEnterCritical();
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    vHostExitCritical();
+    return pdFALSE;
+}
+
+void vTaskSetTimeOutState(TimeOut_t * const pxTimeOut)
+{
+    pxTimeOut->xOverflowCount = 0;
+    pxTimeOut->xTimeOnEntering = HostTick();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait)
+{
+    TickType_t xElapsed = HostTick() - pxTimeOut->xTimeOnEntering;
+
+    if (*pxTicksToWait == portMAX_DELAY) {
+        return pdFALSE;
+    }
+    if (xElapsed >= *pxTicksToWait) {
+        *pxTicksToWait = 0;
+        return pdTRUE;
+    }
+    *pxTicksToWait -= xElapsed;
+    vTaskSetTimeOutState(pxTimeOut);
+    return pdFALSE;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue,
+                              eNotifyAction eAction, uint32_t *pulPreviousNotificationValue)
+{
+    BaseType_t xRet = pdPASS;
+
+    (void)uxIndexToNotify;
+    (void)pthread_mutex_lock(&xTaskToNotify->xLock);
+    if (pulPreviousNotificationValue != NULL) {
+        *pulPreviousNotificationValue = xTaskToNotify->u32Value;
+    }
+    switch (eAction) {
+    case eSetBits:
+        xTaskToNotify->u32Value |= ulValue;
+        break;
+    case eIncrement:
+        xTaskToNotify->u32Value++;
+        break;
+    case eSetValueWithOverwrite:
+        xTaskToNotify->u32Value = ulValue;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (xTaskToNotify->u8State == HOST_NOTIFY_RECEIVED) {
+            xRet = pdFAIL;
+        } else {
+            xTaskToNotify->u32Value = ulValue;
+        }
+        break;
+    default:
+        break;
+    }
+    xTaskToNotify->u8State = HOST_NOTIFY_RECEIVED;
+    (void)pthread_cond_signal(&xTaskToNotify->xCond);
+    (void)pthread_mutex_unlock(&xTaskToNotify->xLock);
+    return xRet;
+}
+
+BaseType_t xTaskGenericNotifyFromISR(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue,
+                                     eNotifyAction eAction, uint32_t *pulPreviousNotificationValue,
+                                     BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+    return xTaskGenericNotify(xTaskToNotify, uxIndexToNotify, ulValue, eAction, pulPreviousNotificationValue);
+}
+
+BaseType_t xTaskGenericNotifyWait(UBaseType_t uxIndexToWaitOn, uint32_t ulBitsToClearOnEntry,
+                                  uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue,
+                                  TickType_t xTicksToWait)
+{
+    struct tskTaskControlBlock *pTask = xTaskGetCurrentTaskHandle();
+    struct timespec stTs;
+    BaseType_t xRet = pdFALSE;
+
+    (void)uxIndexToWaitOn;
+    clock_gettime(CLOCK_MONOTONIC, &stTs);
+    stTs.tv_sec += xTicksToWait / 1000U;
+    stTs.tv_nsec += (long)(xTicksToWait % 1000U) * 1000000L;
+    if (stTs.tv_nsec >= 1000000000L) {
+        stTs.tv_sec++;
+        stTs.tv_nsec -= 1000000000L;
+    }
+
+    (void)pthread_mutex_lock(&pTask->xLock);
+    if (pTask->u8State != HOST_NOTIFY_RECEIVED) {
+        pTask->u32Value &= ~ulBitsToClearOnEntry;
+        pTask->u8State = HOST_NOTIFY_WAITING;
+        while ((pTask->u8State != HOST_NOTIFY_RECEIVED) && (xTicksToWait > 0U)) {
+            if (xTicksToWait == portMAX_DELAY) {
+                (void)pthread_cond_wait(&pTask->xCond, &pTask->xLock);
+            } else if (pthread_cond_timedwait(&pTask->xCond, &pTask->xLock, &stTs) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+    if (pulNotificationValue != NULL) {
+        *pulNotificationValue = pTask->u32Value;
+    }
+    if (pTask->u8State == HOST_NOTIFY_RECEIVED) {
+        pTask->u32Value &= ~ulBitsToClearOnExit;
+        xRet = pdTRUE;
+    }
+    pTask->u8State = HOST_NOTIFY_NONE;
+    (void)pthread_mutex_unlock(&pTask->xLock);
+    return xRet;
+}
+
+BaseType_t xTaskGenericNotifyStateClear(TaskHandle_t xTask, UBaseType_t uxIndexToClear)
+{
+    struct tskTaskControlBlock *pTask = (xTask != NULL) ? xTask : xTaskGetCurrentTaskHandle();
+    BaseType_t xRet = pdFAIL;
+
+    (void)uxIndexToClear;
+    (void)pthread_mutex_lock(&pTask->xLock);
+    if (pTask->u8State == HOST_NOTIFY_RECEIVED) {
+        pTask->u8State = HOST_NOTIFY_NONE;
+        xRet = pdPASS;
+    }
+    (void)pthread_mutex_unlock(&pTask->xLock);
+    return xRet;
+}
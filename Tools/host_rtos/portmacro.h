@@ -0,0 +1,48 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 主机测试用的FreeRTOS移植层: 类型和板上(GCC/ARM_CM7)相同, 临界区是一个全局的递归互斥锁
+ * (host_rtos.c), 中断里的临界区也用它, 相当于两个核共用一把锁.
+ */
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+#include <sched.h>
+
+#define portSTACK_TYPE                  uint32_t
+#define portBASE_TYPE                   long
+
+typedef portSTACK_TYPE                  StackType_t;
+typedef long                            BaseType_t;
+typedef unsigned long                   UBaseType_t;
+typedef uint32_t                        TickType_t;
+#define portMAX_DELAY                   ( TickType_t ) 0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC         1
+
+#define portSTACK_GROWTH                ( -1 )
+#define portTICK_PERIOD_MS              ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT              8
+#define portPOINTER_SIZE_TYPE           uintptr_t
+
+void vHostEnterCritical( void );
+void vHostExitCritical( void );
+
+#define portENTER_CRITICAL()                        vHostEnterCritical()
+#define portEXIT_CRITICAL()                         vHostExitCritical()
+#define portDISABLE_INTERRUPTS()                    vHostEnterCritical()
+#define portENABLE_INTERRUPTS()                     vHostExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()           ( vHostEnterCritical(), 0U )
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )      do { ( void ) ( x ); vHostExitCritical(); } while( 0 )
+
+#define portYIELD()                                 ( void ) sched_yield()
+#define portYIELD_FROM_ISR( x )                     ( void ) ( x )
+#define portEND_SWITCHING_ISR( x )                  ( void ) ( x )
+#define portNOP()
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters )    void vFunction( void * pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )          void vFunction( void * pvParameters )
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,262 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 批量记录帧(ipc_frame.c)的主机测试(Linux/gcc): 在主机上的借用块池(sharemen.c, SHM_HOST回环)上
+ * 写入变长记录, 再读出检查. 记录长度0~1500字节, 大部分要分成多片.
+ * 记录的类型是序号, 数据是由序号决定的字节序列, 处理函数检查长度和数据, 记录不能重复.
+ *   1. 分片和重组: 每一轮写几帧再全部读出, 所有记录都要原样收到, 没有丢弃和序号错误.
+ *   2. 丢帧和乱序: 读之前把这一轮的帧取出来, 丢掉一帧或交换两帧后重新提交.
+ *      没有碰到被改动的帧的记录都要收到; 碰到的记录可以收不到, 但收到的必须完整.
+ *   3. 块池用完: 不读, 一直写到IPC_bFramePut失败, 读完后之前的记录都要收到,
+ *      写了一半的记录被丢弃, 所有块都归还, 之后继续写读正常.
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -DSHM_HOST -DSHM_LEND_CHECK=1 -ICore/Common/Inc Tools/ipc_frame_test.c Core/Common/Src/ipc_frame.c \
+ *       Core/Common/Src/sharemen.c Core/Common/Src/ipc_ring.c -o ipc_frame_test
+ * 用法:
+ *   ./ipc_frame_test [每种情况的轮数, 默认200]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sharemem.h"
+#include "ipc_frame.h"
+
+#define TEST_LEN_MAX            (1500U)                         // 最长记录, 比一个块大两倍多
+#define TEST_REC_MAX            (IPC_FRM_TYPE_MASK)             // 序号就是类型, 不能超过14位
+#define TEST_ROUND_FRAMES       (8U)                            // 每轮至少写的帧数, 最多再多出一条记录的帧
+#define TEST_BATCH_MAX          (SHM_LEND_SLOTS)
+
+typedef struct _Test_Span_ {
+    uint16_t u16First;                          // 记录的第一片所在帧的序号
+    uint16_t u16Last;                           // 最后一片所在帧的序号
+} Test_Span_t;
+
+typedef struct _Test_Frame_ {
+    uint8_t  au8Data[SHM_LEND_SLOT_SIZE];
+    uint16_t u16Len;
+    uint16_t u16Seq;
+} Test_Frame_t;
+
+static IPC_FrameWriter_t stW;
+static IPC_FrameReader_t stR;
+static uint8_t au8Reasm[TEST_LEN_MAX];
+static uint8_t au8Got[TEST_REC_MAX];            // 每条记录收到的次数
+static Test_Span_t astSpan[TEST_REC_MAX];
+static bool abBad[0x10000];                     // 被丢弃或交换过的帧序号
+static uint32_t u32Next = 0U;                   // 下一条记录的序号
+static unsigned long u32BadData = 0;
+static unsigned long u32Dup = 0;
+static unsigned long u32Notify = 0;
+
+
+// 主机上没有门铃
+bool IPC_bNotifySignal(uint8_t u8Ch)
+{
+    (void)u8Ch;
+    u32Notify++;
+    return true;
+}
+
+static uint16_t Test_u16Len(uint32_t u32Seq)
+{
+    return (uint16_t)(((u32Seq * 2654435761U) >> 8) % (TEST_LEN_MAX + 1U));
+}
+
+static uint8_t Test_u8Byte(uint32_t u32Seq, uint32_t i)
+{
+    return (uint8_t)(u32Seq * 7U + i);
+}
+
+static void Test_Handler(uint16_t u16Type, const uint8_t *pData, uint32_t u32Len, void *pArg)
+{
+    (void)pArg;
+    if ((u16Type >= u32Next) || (u32Len != Test_u16Len(u16Type))) {
+        u32BadData++;
+        return;
+    }
+    for (uint32_t i = 0; i < u32Len; i++) {
+        if (pData[i] != Test_u8Byte(u16Type, i)) {
+            u32BadData++;
+            return;
+        }
+    }
+    if (au8Got[u16Type]++ != 0U) {
+        u32Dup++;
+    }
+}
+
+// 写一条记录, 记下它占用的帧
+static bool Test_bPut(void)
+{
+    static uint8_t au8Data[TEST_LEN_MAX];
+    uint32_t u32Seq = u32Next++;
+    uint16_t u16Len = Test_u16Len(u32Seq);
+    bool bOk;
+
+    for (uint32_t i = 0; i < u16Len; i++) {
+        au8Data[i] = Test_u8Byte(u32Seq, i);
+    }
+    astSpan[u32Seq].u16First = stW.u16Seq;
+    bOk = IPC_bFramePut(&stW, (uint16_t)u32Seq, au8Data, u16Len);
+    astSpan[u32Seq].u16Last = stW.bOpen ? stW.u16Seq : (uint16_t)(stW.u16Seq - 1U);
+    return bOk;
+}
+
+// 写一轮: 至少TEST_ROUND_FRAMES帧, 最后一帧也提交; 块池放得下, 不会失败
+static bool Test_bRound(void)
+{
+    uint32_t u32Start = stW.u32Frames;
+
+    while ((stW.u32Frames - u32Start) < TEST_ROUND_FRAMES) {
+        if (!Test_bPut()) {
+            return false;
+        }
+    }
+    return IPC_bFrameFlush(&stW);
+}
+
+// 把已提交的帧都取出来, 丢掉或交换后按新的顺序重新提交
+static void Test_Relay(uint32_t u32Round)
+{
+    static Test_Frame_t astFrame[TEST_BATCH_MAX];
+    Test_Frame_t stTmp;
+    SHM_Lend_t stLend;
+    uint32_t u32Num = 0U, u32Drop = TEST_BATCH_MAX, i;
+
+    while ((u32Num < TEST_BATCH_MAX) && SHM_bAcquire(&stLend)) {
+        memcpy(astFrame[u32Num].au8Data, stLend.pu8Data, stLend.u16Size);
+        astFrame[u32Num].u16Len = stLend.u16Size;
+        astFrame[u32Num].u16Seq = ((const uint16_t *)stLend.pu8Data)[1];
+        (void)SHM_bRelease(&stLend);
+        u32Num++;
+    }
+
+    if (u32Num >= 4U) {
+        if ((u32Round & 1U) != 0U) {
+            u32Drop = 2U;                                   // 丢掉第3帧
+            abBad[astFrame[2].u16Seq] = true;
+        } else {
+            stTmp = astFrame[1];                            // 交换第2, 3帧
+            astFrame[1] = astFrame[2];
+            astFrame[2] = stTmp;
+            abBad[astFrame[1].u16Seq] = true;
+            abBad[astFrame[2].u16Seq] = true;
+        }
+    }
+
+    for (i = 0; i < u32Num; i++) {
+        if ((i == u32Drop) || !SHM_bBorrow(&stLend)) {
+            continue;
+        }
+        memcpy(stLend.pu8Data, astFrame[i].au8Data, astFrame[i].u16Len);
+        (void)SHM_bCommit(&stLend, astFrame[i].u16Len);
+    }
+}
+
+// 检查到u32Next为止的记录: 没有碰到坏帧的记录都要收到一次
+static unsigned long Test_u32Missing(uint32_t u32From, uint32_t u32To)
+{
+    unsigned long u32Miss = 0;
+    uint16_t u16Seq;
+    bool bTouched;
+
+    for (uint32_t n = u32From; n < u32To; n++) {
+        bTouched = false;
+        for (u16Seq = astSpan[n].u16First; u16Seq != (uint16_t)(astSpan[n].u16Last + 1U); u16Seq++) {
+            bTouched |= abBad[u16Seq];
+        }
+        if (!bTouched && (au8Got[n] == 0U)) {
+            u32Miss++;
+        }
+    }
+    return u32Miss;
+}
+
+// 所有块都是空闲的
+static bool Test_bPoolFree(void)
+{
+    SHM_Lend_t astLend[SHM_LEND_SLOTS];
+    uint32_t u32Num = 0U;
+
+    while ((u32Num < SHM_LEND_SLOTS) && SHM_bBorrow(&astLend[u32Num])) {
+        u32Num++;
+    }
+    for (uint32_t i = 0; i < u32Num; i++) {
+        (void)SHM_bCancel(&astLend[i]);
+    }
+    return (u32Num == SHM_LEND_SLOTS);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t u32Rounds = (argc > 1) ? (uint32_t)atoi(argv[1]) : 200U;
+    uint32_t u32From, u32Recs, u32Fail, r;
+    unsigned long u32Miss;
+    bool bOk, bPass = true;
+
+    // 每轮最多TEST_ROUND_FRAMES + 4帧, 每帧至少一条记录
+    if ((u32Rounds == 0U) || ((u32Rounds * 2U + 2U) * (TEST_ROUND_FRAMES + 4U) >= TEST_REC_MAX)) {
+        fprintf(stderr, "bad round count %u\n", (unsigned)u32Rounds);
+        return 1;
+    }
+    ShareMemInit();
+    IPC_FrameWriterInit(&stW);
+    IPC_FrameReaderInit(&stR, au8Reasm, sizeof(au8Reasm));
+
+    // 1.分片和重组
+    u32Recs = 0U;
+    for (r = 0; r < u32Rounds; r++) {
+        bOk = Test_bRound();
+        u32Recs += IPC_u32FrameProcess(&stR, Test_Handler, NULL);
+        bPass &= bOk;
+    }
+    u32Miss = Test_u32Missing(0U, u32Next);
+    bOk = bPass && (u32Miss == 0) && (u32Recs == u32Next) && (stR.u32Drops == 0U) && (stR.u32SeqErr == 0U)
+          && (stR.u32Frames == stW.u32Frames) && (stW.u32Drops == 0U);
+    printf("fragments: %u records in %u frames, %u delivered, %lu missing, reader drops %u, seq errors %u: %s\n",
+           (unsigned)u32Next, (unsigned)stW.u32Frames, (unsigned)u32Recs, u32Miss, (unsigned)stR.u32Drops,
+           (unsigned)stR.u32SeqErr, bOk ? "ok" : "FAIL");
+    bPass &= bOk;
+
+    // 2.丢帧和乱序
+    u32From = u32Next;
+    for (r = 0; r < u32Rounds; r++) {
+        bPass &= Test_bRound();
+        Test_Relay(r);
+        (void)IPC_u32FrameProcess(&stR, Test_Handler, NULL);
+    }
+    u32Miss = Test_u32Missing(u32From, u32Next);
+    bOk = (u32Miss == 0) && (stR.u32Drops != 0U) && (stR.u32SeqErr != 0U);
+    printf("lost/reordered: %u records, %lu missing, reader drops %u, seq errors %u: %s\n",
+           (unsigned)(u32Next - u32From), u32Miss, (unsigned)stR.u32Drops, (unsigned)stR.u32SeqErr,
+           bOk ? "ok" : "FAIL");
+    bPass &= bOk;
+
+    // 3.块池用完: 一直写到失败, 失败的那条写了一半
+    u32From = u32Next;
+    while (Test_bPut()) {
+    }
+    u32Fail = u32Next - 1U;
+    bOk = (stW.u32Drops != 0U);
+    (void)IPC_u32FrameProcess(&stR, Test_Handler, NULL);
+    bOk &= Test_bPoolFree();
+    for (r = 0; r < u32Rounds; r++) {
+        bOk &= Test_bRound();
+        (void)IPC_u32FrameProcess(&stR, Test_Handler, NULL);
+    }
+    u32Miss = Test_u32Missing(u32From, u32Fail) + Test_u32Missing(u32Fail + 1U, u32Next);
+    bOk &= (u32Miss == 0) && (au8Got[u32Fail] == 0U) && Test_bPoolFree();
+    printf("pool exhausted: record %u dropped after %u records, %lu missing, writer drops %u: %s\n",
+           (unsigned)u32Fail, (unsigned)(u32Fail - u32From), u32Miss, (unsigned)stW.u32Drops, bOk ? "ok" : "FAIL");
+    bPass &= bOk;
+
+    bPass &= (u32BadData == 0) && (u32Dup == 0) && (pShareData->stLend7to4.u32GenErr == 0U);
+    printf("%lu data errors, %lu duplicates, %u stale lends, %lu notifies\n", u32BadData, u32Dup,
+           (unsigned)pShareData->stLend7to4.u32GenErr, u32Notify);
+    printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 核间环形缓存(ipc_ring.c)的主机压力测试(Linux/gcc): 一个生产者线程和一个消费者线程代替两个核,
+ * 通过一个很小的环形缓存传送变长记录, 让填充记录和回绕经常出现.
+ * 最大记录长度不超过缓存的一半(否则填充记录加上这条记录可能永远放不下).
+ * 记录的类型是序号(跳过IPC_REC_TYPE_PAD), 数据是由序号决定的字节序列, 消费者检查序号是否连续,
+ * 长度和数据是否正确. 缓存满时生产者重试(IPC_bRingWrite返回false, 同时u32Drops加1).
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -pthread -ICore/Common/Inc Tools/ipc_ring_stress.c Core/Common/Src/ipc_ring.c -o ipc_ring_stress
+ * 用法:
+ *   ./ipc_ring_stress [秒, 默认5] [缓存字节数, 2的整数次幂, 默认1024] [最大记录长度, 默认300]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "ipc_ring.h"
+
+#define STRESS_TYPE_NUM         (IPC_REC_TYPE_PAD)  // 序号取模, 类型0~0xFFFE
+
+static IPC_Ring_t stRing;
+static volatile int s32Stop = 0;
+static volatile int s32Done = 0;                // 生产者已经退出
+static uint32_t u32LenMax = 300U;
+static unsigned long u32Sent = 0;
+static unsigned long u32Full = 0;
+static unsigned long u32Recv = 0;
+static unsigned long u32Bytes = 0;
+static unsigned long u32BadSeq = 0;
+static unsigned long u32BadData = 0;
+
+// 第u32Seq条记录的长度, 生产者和消费者算出的相同
+static uint16_t Stress_u16Len(uint32_t u32Seq)
+{
+    uint32_t u32Hash = u32Seq * 2654435761U;
+
+    return (uint16_t)((u32Hash >> 8) % (u32LenMax + 1U));
+}
+
+static uint8_t Stress_u8Byte(uint32_t u32Seq, uint32_t i)
+{
+    return (uint8_t)(u32Seq * 7U + i);
+}
+
+static void *Stress_Producer(void *pArg)
+{
+    static uint8_t au8Data[IPC_REC_LEN_MAX];
+    uint32_t u32Seq = 0U;
+    uint16_t u16Len;
+
+    (void)pArg;
+    while (!s32Stop) {
+        u16Len = Stress_u16Len(u32Seq);
+        for (uint32_t i = 0; i < u16Len; i++) {
+            au8Data[i] = Stress_u8Byte(u32Seq, i);
+        }
+        if (!IPC_bRingWrite(&stRing, (uint16_t)(u32Seq % STRESS_TYPE_NUM), au8Data, u16Len)) {
+            u32Full++;
+            sched_yield();
+            continue;                           // 同一条记录重试
+        }
+        u32Sent++;
+        u32Seq++;
+    }
+    IPC_DMB();
+    s32Done = 1;
+    return NULL;
+}
+
+static void *Stress_Consumer(void *pArg)
+{
+    static uint8_t au8Data[IPC_REC_LEN_MAX];
+    uint32_t u32Seq = 0U;
+    uint16_t u16Type;
+    int32_t s32Len;
+
+    (void)pArg;
+    // 生产者停止后把缓存里剩下的记录读完
+    while (!s32Done || !IPC_bRingEmpty(&stRing)) {
+        s32Len = IPC_s32RingRead(&stRing, &u16Type, au8Data, sizeof(au8Data));
+        if (s32Len < 0) {
+            sched_yield();
+            continue;
+        }
+        u32Recv++;
+        u32Bytes += (unsigned long)s32Len;
+        if (u16Type != (uint16_t)(u32Seq % STRESS_TYPE_NUM)) {
+            u32BadSeq++;
+            u32Seq = u16Type;                   // 重新同步, 继续检查后面的记录
+        }
+        if ((uint32_t)s32Len != Stress_u16Len(u32Seq)) {
+            u32BadData++;
+        } else {
+            for (int32_t i = 0; i < s32Len; i++) {
+                if (au8Data[i] != Stress_u8Byte(u32Seq, (uint32_t)i)) {
+                    u32BadData++;
+                    break;
+                }
+            }
+        }
+        u32Seq++;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int s32Sec = (argc > 1) ? atoi(argv[1]) : 5;
+    uint32_t u32Size = (argc > 2) ? (uint32_t)atoi(argv[2]) : 1024U;
+    uint8_t *pu8Buff;
+    pthread_t xProducer, xConsumer;
+    bool bPass;
+
+    if (argc > 3) {
+        u32LenMax = (uint32_t)atoi(argv[3]);
+    }
+    if ((u32Size < 64U) || ((u32Size & (u32Size - 1U)) != 0U)
+        || (2U * (IPC_REC_HDR_SIZE + IPC_REC_ALIGN(u32LenMax)) > u32Size) || (u32LenMax > IPC_REC_LEN_MAX)) {
+        fprintf(stderr, "bad ring size %u or record length %u\n", (unsigned)u32Size, (unsigned)u32LenMax);
+        return 1;
+    }
+    pu8Buff = aligned_alloc(IPC_CACHE_LINE, u32Size);
+    if (pu8Buff == NULL) {
+        return 1;
+    }
+    IPC_RingInit(&stRing, pu8Buff, u32Size);
+
+    (void)pthread_create(&xConsumer, NULL, Stress_Consumer, NULL);
+    (void)pthread_create(&xProducer, NULL, Stress_Producer, NULL);
+    sleep((unsigned)s32Sec);
+    s32Stop = 1;
+    (void)pthread_join(xProducer, NULL);
+    (void)pthread_join(xConsumer, NULL);
+
+    bPass = (u32BadSeq == 0) && (u32BadData == 0) && (u32Recv == u32Sent) && (stRing.u32Drops == u32Full);
+    printf("ring %u bytes, records 0~%u bytes, %d s: %lu sent, %lu received, %lu bytes, %lu full (drops %u)\n",
+           (unsigned)u32Size, (unsigned)u32LenMax, s32Sec, u32Sent, u32Recv, u32Bytes, u32Full, (unsigned)stRing.u32Drops);
+    printf("%lu sequence errors, %lu data errors\n", u32BadSeq, u32BadData);
+    printf("%s\n", bPass ? "PASS" : "FAIL");
+    free(pu8Buff);
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * ampbench(ipc_bench.c)的主机版本(Linux/gcc): 两个线程代替两个核, 通过两个message buffer往返消息,
+ * message buffer用板上同一份stream_buffer.c, 任务通知等在Tools/host_rtos里用pthread实现.
+ * 通道长度和板上的bench7to4/bench4to7相同, 收发完成和板上一样走门铃:
+ * vGenerateM7ToM4Interrupt()在这里直接执行对方核的门铃中断(ipc_stream.c的StreamNotifyHandler).
+ * 主机上的数字只用来比较不同长度和修改前后, 不代表板上的绝对值.
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -pthread -ITools/host_rtos -IRTOS/FreeRTOS/include Tools/ipc_stream_bench.c \
+ *       Tools/host_rtos/host_rtos.c RTOS/FreeRTOS/stream_buffer.c -o ipc_stream_bench
+ * 用法:
+ *   ./ipc_stream_bench [每种长度的往返次数, 默认10000]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "message_buffer.h"
+
+#define BENCH_MSG_MAX           (4096U)                         // IPC_BENCH_MSG_MAX
+#define BENCH_BUFF_SIZE         (2U * (BENCH_MSG_MAX + 32U))    // 和ipc_stream.c的通道配置相同
+#define BENCH_TIMEOUT           pdMS_TO_TICKS(100)
+#define BENCH_TO_CM7            (7U)
+#define BENCH_TO_CM4            (4U)
+
+typedef struct _Bench_Chan_ {
+    MessageBufferHandle_t xBuff;
+    uint8_t u8RxCore;
+} Bench_Chan_t;
+
+static StaticMessageBuffer_t astCtrl[2];
+static uint8_t au8Storage[2][BENCH_BUFF_SIZE];
+static Bench_Chan_t astChan[2];                 // 0: bench7to4, 1: bench4to7
+static __thread uint8_t u8ThisCore = BENCH_TO_CM7;
+static volatile int s32Stop = 0;
+static const uint16_t au16BenchSize[] = {1, 16, 64, 256, 1024, BENCH_MSG_MAX};
+
+
+// 门铃: 在对方核上执行StreamNotifyHandler
+void vGenerateM7ToM4Interrupt(void *xUpdatedMessageBuffer)
+{
+    BaseType_t xWoken = pdFALSE;
+
+    (void)xUpdatedMessageBuffer;
+    for (uint32_t i = 0; i < sizeof(astChan) / sizeof(astChan[0]); i++) {
+        if (astChan[i].u8RxCore != u8ThisCore) {
+            if (xMessageBufferIsEmpty(astChan[i].xBuff) == pdFALSE) {
+                xMessageBufferSendCompletedFromISR(astChan[i].xBuff, &xWoken);
+            }
+        } else {
+            xMessageBufferReceiveCompletedFromISR(astChan[i].xBuff, &xWoken);
+        }
+    }
+}
+
+// CM4: AMP_BenchEchoTask
+static void *Bench_Echo(void *pArg)
+{
+    static uint8_t au8Buff[BENCH_MSG_MAX];
+    size_t xLen;
+
+    (void)pArg;
+    u8ThisCore = BENCH_TO_CM4;
+    while (!s32Stop) {
+        xLen = xMessageBufferReceive(astChan[0].xBuff, au8Buff, sizeof(au8Buff), BENCH_TIMEOUT);
+        if (xLen > 0) {
+            (void)xMessageBufferSend(astChan[1].xBuff, au8Buff, xLen, portMAX_DELAY);
+        }
+    }
+    return NULL;
+}
+
+static double Bench_dUs(const struct timespec *pStart, const struct timespec *pEnd)
+{
+    return (double)(pEnd->tv_sec - pStart->tv_sec) * 1e6 + (double)(pEnd->tv_nsec - pStart->tv_nsec) / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t au8Tx[BENCH_MSG_MAX];
+    static uint8_t au8Rx[BENCH_MSG_MAX];
+    uint32_t u32Count = (argc > 1) ? (uint32_t)atoi(argv[1]) : 10000U;
+    struct timespec stStart, stEnd;
+    double dUs, dMin, dMax, dSum;
+    uint32_t n, u32Err, u32Ok;
+    uint16_t u16Len;
+    pthread_t xEcho;
+
+    astChan[0].xBuff = xMessageBufferCreateStatic(BENCH_BUFF_SIZE, au8Storage[0], &astCtrl[0]);
+    astChan[0].u8RxCore = BENCH_TO_CM4;
+    astChan[1].xBuff = xMessageBufferCreateStatic(BENCH_BUFF_SIZE, au8Storage[1], &astCtrl[1]);
+    astChan[1].u8RxCore = BENCH_TO_CM7;
+    for (n = 0; n < sizeof(au8Tx); n++) {
+        au8Tx[n] = (uint8_t)n;
+    }
+    (void)pthread_create(&xEcho, NULL, Bench_Echo, NULL);
+
+    printf("size(B)  min(us)  avg(us)  max(us)  KB/s     err\n");
+    for (size_t i = 0; i < sizeof(au16BenchSize) / sizeof(au16BenchSize[0]); i++) {
+        u16Len = au16BenchSize[i];
+        dMin = 1e12;
+        dMax = 0.0;
+        dSum = 0.0;
+        u32Err = 0U;
+
+        for (n = 0; n < u32Count; n++) {
+            clock_gettime(CLOCK_MONOTONIC, &stStart);
+            if ((xMessageBufferSend(astChan[0].xBuff, au8Tx, u16Len, BENCH_TIMEOUT) != u16Len)
+                || (xMessageBufferReceive(astChan[1].xBuff, au8Rx, sizeof(au8Rx), BENCH_TIMEOUT) != u16Len)) {
+                u32Err++;
+                continue;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &stEnd);
+            dUs = Bench_dUs(&stStart, &stEnd);
+            dSum += dUs;
+            dMin = (dUs < dMin) ? dUs : dMin;
+            dMax = (dUs > dMax) ? dUs : dMax;
+            if (memcmp(au8Tx, au8Rx, u16Len) != 0) {
+                u32Err++;
+            }
+        }
+
+        u32Ok = u32Count - u32Err;
+        if ((u32Ok == 0U) || (dSum <= 0.0)) {
+            printf("%7u  -        -        -        -        %u\n", u16Len, u32Err);
+            continue;
+        }
+        // 往返一次传输2*u16Len字节
+        printf("%7u  %7.2f  %7.2f  %7.1f  %7.0f  %u\n", u16Len, dMin, dSum / u32Ok, dMax,
+               2.0 * u16Len * u32Ok * 1e6 / (dSum * 1024.0), u32Err);
+    }
+
+    s32Stop = 1;
+    (void)pthread_join(xEcho, NULL);
+    return 0;
+}
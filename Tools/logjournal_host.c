@@ -0,0 +1,317 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 日志文件(logjournal.c)的主机测试(Linux/gcc): littlefs的块设备是一个镜像文件,
+ * 读写长度和块大小和板上(littlefsport.c)相同, 编程前检查是否已擦除(NOR FLASH只能把1写成0).
+ *  1. 格式化后写入带序号的日志行, 每隔一段sync一次, 总长度超过所有轮转文件, 让轮转发生几次;
+ *  2. 最后一批不sync, 直接丢掉内存里的littlefs状态, 相当于掉电;
+ *  3. 从镜像文件重新挂载, 用LOGJ_s32Dump读出全部日志, 检查行的格式, 序号从老到新连续
+ *     (轮转按字节而不是按行, 最老的文件开头可能是半行, 跳过第一个换行之前的内容),
+ *     最后一行不早于最后一次sync, 总长度不超过轮转文件的容量;
+ *  4. 掉电后继续追加, 再检查一次;
+ *  5. 轮转失败: 接下来几次lfs_rename返回错误(链接时用--wrap换掉), 写到轮转几次,
+ *     日志不能丢, 序号仍然连续, 轮转在之后的块上重试成功(文件最多超出失败次数个块).
+ * 最后打印块设备的编程/擦除统计, 用来比较批量写入和sync策略的效果.
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -DLOGJ_HOST -IFS -IFS/littlefs -Wl,--wrap=lfs_rename Tools/logjournal_host.c FS/logjournal.c \
+ *       FS/littlefs/lfs.c FS/littlefs/lfs_util.c -o logjournal_host
+ * 用法:
+ *   ./logjournal_host [镜像文件, 默认logj.img] [日志行数, 默认20000]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "lfs.h"
+#include "logjournal.h"
+
+#define HOST_BLOCK_SIZE         (8192U)         // BSP_FS_BLOCK_SIZE
+#define HOST_BLOCK_COUNT        (256U)          // 2MB, 板上是2048块
+#define HOST_PROG_SIZE          (128U)          // READ_PROG_BYTEMIN
+#define HOST_SYNC_LINES         (100U)          // 每隔多少行sync一次
+#define HOST_LOST_LINES         (37U)           // 掉电前没有sync的行数
+#define HOST_LINE_MAX           (80U)
+#define HOST_RENAME_FAILS       (5U)            // 情况5: 连续失败的改名次数
+
+typedef struct _Host_Check_ {
+    char acLine[HOST_LINE_MAX];
+    uint32_t u32Len;                            // acLine里未结束的一行
+    bool     bStart;                            // 已经过了第一个换行
+    uint32_t u32Lines;
+    uint32_t u32First;
+    uint32_t u32Last;
+    uint32_t u32Bytes;
+    uint32_t u32Errors;
+} Host_Check_t;
+
+static int s32ImgFd = -1;
+static unsigned long u32Progs = 0, u32ProgBytes = 0, u32Erases = 0, u32BadProgs = 0;
+static uint32_t u32RenameFails = 0U;            // 之后这么多次lfs_rename返回LFS_ERR_IO
+
+
+int __real_lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath);
+
+int __wrap_lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath)
+{
+    if (u32RenameFails != 0U) {
+        u32RenameFails--;
+        return LFS_ERR_IO;
+    }
+    return __real_lfs_rename(lfs, oldpath, newpath);
+}
+
+
+static int Host_s32Read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    off_t xPos = (off_t)block * c->block_size + off;
+
+    return (pread(s32ImgFd, buffer, size, xPos) == (ssize_t)size) ? 0 : LFS_ERR_IO;
+}
+
+static int Host_s32Prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    static uint8_t au8Old[HOST_BLOCK_SIZE];
+    off_t xPos = (off_t)block * c->block_size + off;
+
+    if (pread(s32ImgFd, au8Old, size, xPos) != (ssize_t)size) {
+        return LFS_ERR_IO;
+    }
+    for (lfs_size_t i = 0; i < size; i++) {
+        if (au8Old[i] != 0xFFU) {
+            u32BadProgs++;                      // 没有擦除就编程
+            break;
+        }
+    }
+    u32Progs++;
+    u32ProgBytes += size;
+    return (pwrite(s32ImgFd, buffer, size, xPos) == (ssize_t)size) ? 0 : LFS_ERR_IO;
+}
+
+static int Host_s32Erase(const struct lfs_config *c, lfs_block_t block)
+{
+    static uint8_t au8Erased[HOST_BLOCK_SIZE];
+
+    memset(au8Erased, 0xFF, sizeof(au8Erased));
+    u32Erases++;
+    return (pwrite(s32ImgFd, au8Erased, c->block_size, (off_t)block * c->block_size) == (ssize_t)c->block_size)
+           ? 0 : LFS_ERR_IO;
+}
+
+static int Host_s32Sync(const struct lfs_config *c)
+{
+    (void)c;
+    return 0;
+}
+
+static const struct lfs_config stCfg = {
+    .read  = Host_s32Read,
+    .prog  = Host_s32Prog,
+    .erase = Host_s32Erase,
+    .sync  = Host_s32Sync,
+    .read_size = HOST_PROG_SIZE,
+    .prog_size = HOST_PROG_SIZE,
+    .block_size = HOST_BLOCK_SIZE,
+    .block_count = HOST_BLOCK_COUNT,
+    .cache_size = 256,                          // CACHE_SIZE
+    .lookahead_size = 128,                      // LOOKAHEADE_SIZE
+    .block_cycles = 500,                        // BLOCK_CYCLES
+};
+
+// 第u32Seq行: 8位序号, 空格, 长度随序号变化的内容, 换行
+static uint32_t Host_u32Line(char *pcLine, uint32_t u32Seq)
+{
+    uint32_t u32Len = (uint32_t)snprintf(pcLine, HOST_LINE_MAX, "%08lu ", (unsigned long)u32Seq);
+    uint32_t u32Fill = (u32Seq * 7U) % 60U;
+
+    for (uint32_t i = 0; i < u32Fill; i++) {
+        pcLine[u32Len++] = (char)('a' + (u32Seq + i) % 26U);
+    }
+    pcLine[u32Len++] = '\n';
+    return u32Len;
+}
+
+static void Host_CheckLine(Host_Check_t *pChk)
+{
+    char acExp[HOST_LINE_MAX];
+    unsigned long u32Seq;
+
+    if (sscanf(pChk->acLine, "%8lu", &u32Seq) != 1) {
+        pChk->u32Errors++;
+        return;
+    }
+    if ((Host_u32Line(acExp, (uint32_t)u32Seq) != pChk->u32Len) || (memcmp(acExp, pChk->acLine, pChk->u32Len) != 0)) {
+        pChk->u32Errors++;
+    } else if ((pChk->u32Lines != 0U) && ((uint32_t)u32Seq != pChk->u32Last + 1U)) {
+        pChk->u32Errors++;                      // 序号不连续
+    }
+    if (pChk->u32Lines++ == 0U) {
+        pChk->u32First = (uint32_t)u32Seq;
+    }
+    pChk->u32Last = (uint32_t)u32Seq;
+}
+
+// LOGJ_s32Dump的输出: 拼成行后检查
+static int Host_s32Out(const void *pData, uint32_t u32Len, void *pArg)
+{
+    Host_Check_t *pChk = (Host_Check_t *)pArg;
+    const char *pc = (const char *)pData;
+
+    pChk->u32Bytes += u32Len;
+    for (uint32_t i = 0; i < u32Len; i++) {
+        if (pChk->u32Len >= HOST_LINE_MAX) {
+            pChk->u32Errors++;
+            pChk->u32Len = 0U;
+        }
+        pChk->acLine[pChk->u32Len++] = pc[i];
+        if (pc[i] == '\n') {
+            if (pChk->bStart) {
+                Host_CheckLine(pChk);
+            }
+            pChk->bStart = true;
+            pChk->u32Len = 0U;
+        }
+    }
+    return 0;
+}
+
+// u32Slack: 轮转失败时文件可以超出的长度
+static bool Host_bDump(uint32_t u32Synced, uint32_t u32Written, uint32_t u32Slack, const char *pcTitle)
+{
+    Host_Check_t stChk;
+    bool bPass;
+
+    memset(&stChk, 0, sizeof(stChk));
+    if (LOGJ_s32Dump(Host_s32Out, &stChk) < 0) {
+        stChk.u32Errors++;
+    }
+    if (stChk.u32Len != 0U) {
+        stChk.u32Errors++;                      // 最后一行不完整
+    }
+    bPass = (stChk.u32Errors == 0U) && (stChk.u32Lines != 0U)
+            && (stChk.u32Last + 1U >= u32Synced) && (stChk.u32Last < u32Written)
+            && (stChk.u32Bytes <= LOGJ_FILE_NUM * LOGJ_FILE_MAX + u32Slack);
+    printf("%s: %lu lines %lu..%lu, %lu bytes, synced up to %lu, written %lu, %lu errors: %s\n", pcTitle,
+           (unsigned long)stChk.u32Lines, (unsigned long)stChk.u32First, (unsigned long)stChk.u32Last,
+           (unsigned long)stChk.u32Bytes, (unsigned long)u32Synced, (unsigned long)u32Written,
+           (unsigned long)stChk.u32Errors, bPass ? "ok" : "FAIL");
+    return bPass;
+}
+
+// 写u32Num行, 每HOST_SYNC_LINES行sync一次; bSyncLast为false时最后不sync
+static uint32_t Host_u32Write(uint32_t u32Seq, uint32_t u32Num, bool bSyncLast, uint32_t *pu32Synced)
+{
+    char acLine[HOST_LINE_MAX];
+    uint32_t u32Len;
+
+    for (uint32_t i = 0; i < u32Num; i++, u32Seq++) {
+        u32Len = Host_u32Line(acLine, u32Seq);
+        if (LOGJ_s32Append(acLine, u32Len) < 0) {
+            printf("append failed at line %lu: %d\n", (unsigned long)u32Seq, (int)LOGJ_pStat()->s32LastErr);
+        }
+        if ((((u32Seq + 1U) % HOST_SYNC_LINES) == 0U) || (bSyncLast && (i + 1U == u32Num))) {
+            if (LOGJ_s32Flush() == 0) {
+                *pu32Synced = u32Seq + 1U;
+            }
+        }
+    }
+    return u32Seq;
+}
+
+static int Host_s32Mount(lfs_t *pLfs, const char *pcImg, bool bFormat)
+{
+    static uint8_t au8Erased[HOST_BLOCK_SIZE];
+    int s32Err;
+
+    if (s32ImgFd >= 0) {
+        close(s32ImgFd);
+    }
+    s32ImgFd = open(pcImg, O_RDWR | O_CREAT | (bFormat ? O_TRUNC : 0), 0644);
+    if (s32ImgFd < 0) {
+        perror(pcImg);
+        return -1;
+    }
+    if (bFormat) {
+        memset(au8Erased, 0xFF, sizeof(au8Erased));
+        for (uint32_t i = 0; i < HOST_BLOCK_COUNT; i++) {
+            if (write(s32ImgFd, au8Erased, sizeof(au8Erased)) != (ssize_t)sizeof(au8Erased)) {
+                return -1;
+            }
+        }
+        if ((s32Err = lfs_format(pLfs, &stCfg)) < 0) {
+            return s32Err;
+        }
+    }
+    memset(pLfs, 0, sizeof(*pLfs));             // 掉电: 丢掉内存里的状态
+    if ((s32Err = lfs_mount(pLfs, &stCfg)) < 0) {
+        return s32Err;
+    }
+    return LOGJ_s32Open(pLfs);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pcImg = (argc > 1) ? argv[1] : "logj.img";
+    uint32_t u32Num = (argc > 2) ? (uint32_t)atoi(argv[2]) : 20000U;
+    const LOGJ_Stat_t *pStat = LOGJ_pStat();
+    static lfs_t stLfs;
+    uint32_t u32Seq, u32Synced = 0U;
+    bool bPass = true;
+
+    if (Host_s32Mount(&stLfs, pcImg, true) != 0) {
+        printf("format/mount failed\n");
+        return 1;
+    }
+    u32Seq = Host_u32Write(0U, u32Num, true, &u32Synced);
+    bPass &= Host_bDump(u32Synced, u32Seq, 0U, "written");
+
+    // 再写一批不sync, 然后掉电
+    u32Seq = Host_u32Write(u32Seq, HOST_LOST_LINES, false, &u32Synced);
+    if (Host_s32Mount(&stLfs, pcImg, false) != 0) {
+        printf("remount failed\n");
+        return 1;
+    }
+    bPass &= Host_bDump(u32Synced, u32Seq, 0U, "power loss");
+
+    // 掉电后接着写. 丢掉的行之后序号不再连续, 从最后一行重新开始
+    {
+        Host_Check_t stChk;
+
+        memset(&stChk, 0, sizeof(stChk));
+        (void)LOGJ_s32Dump(Host_s32Out, &stChk);
+        u32Seq = Host_u32Write(stChk.u32Last + 1U, 1000U, true, &u32Synced);
+    }
+    LOGJ_Close();
+    if (Host_s32Mount(&stLfs, pcImg, false) != 0) {
+        printf("remount failed\n");
+        return 1;
+    }
+    bPass &= Host_bDump(u32Synced, u32Seq, 0U, "resumed");
+
+    // 轮转失败: 写两个文件的长度, 改名失败的几次轮转之后要重试成功
+    {
+        uint32_t u32Rot = pStat->u32Rotations, u32Drops = pStat->u32Drops;
+
+        u32RenameFails = HOST_RENAME_FAILS;
+        u32Seq = Host_u32Write(u32Seq, 2U * LOGJ_FILE_MAX / 32U, true, &u32Synced);
+        bPass &= (u32RenameFails == 0U) && (pStat->u32Rotations > u32Rot) && (pStat->u32Drops == u32Drops)
+                 && (pStat->s32LastErr == LFS_ERR_IO);
+        bPass &= Host_bDump(u32Synced, u32Seq, HOST_RENAME_FAILS * LOGJ_CHUNK, "rename fails");
+    }
+    LOGJ_Close();
+    (void)lfs_unmount(&stLfs);
+
+    printf("journal: %lu bytes written, %lu syncs, %lu rotations, %lu dropped\n",
+           (unsigned long)pStat->u32Written, (unsigned long)pStat->u32Syncs,
+           (unsigned long)pStat->u32Rotations, (unsigned long)pStat->u32Drops);
+    printf("flash: %lu progs, %lu bytes, %lu erases, %lu progs on unerased flash\n",
+           u32Progs, u32ProgBytes, u32Erases, u32BadProgs);
+    bPass &= (u32BadProgs == 0U) && (pStat->u32Rotations != 0U);
+    printf("%s\n", bPass ? "PASS" : "FAIL");
+    close(s32ImgFd);
+    return bPass ? 0 : 1;
+}
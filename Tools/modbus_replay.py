@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+STM32H747I-DISCO study
+Modbus RTU抓包回放工具
+
+把抓包文件里的请求帧逐个发给从站(串口或主机测试用的伪终端), 比较应答并统计响应时间.
+
+抓包文件格式: 每行一个请求帧(十六进制, 包含CRC, 空格可有可无),
+可以在"->"后面写期望的应答; "#"后面是注释. CRC可以写成"CRC", 由工具计算.
+    01 03 0000 0002 CRC -> 01 03 04 0000 0000 CRC
+    01 06 0001 1234 C5 A7
+
+用法:
+    python modbus_replay.py frames.txt COM6 [--baud 115200] [--parity E] [--timeout 0.1]
+    python modbus_replay.py frames.txt /dev/pts/3
+串口需要安装pyserial; 没有pyserial时, POSIX系统上直接用termios打开tty/pty.
+"""
+
+import argparse
+import os
+import sys
+import time
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def parse_frame(text):
+    text = text.strip()
+    if not text:
+        return None
+    add_crc = False
+    if text.upper().endswith('CRC'):
+        add_crc = True
+        text = text[:-3]
+    data = bytearray.fromhex(text.replace(' ', ''))
+    if add_crc:
+        crc = crc16(data)
+        data += bytes((crc & 0xFF, crc >> 8))
+    return bytes(data)
+
+
+def load_frames(path):
+    frames = []
+    with open(path, 'r') as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split('#', 1)[0]
+            if not line.strip():
+                continue
+            req, _, rsp = line.partition('->')
+            try:
+                frames.append((lineno, parse_frame(req), parse_frame(rsp)))
+            except ValueError as e:
+                sys.exit('%s:%d: %s' % (path, lineno, e))
+    return frames
+
+
+class TermiosPort(object):
+    """没有pyserial时的最小实现, 只支持POSIX tty/pty"""
+
+    def __init__(self, path, baud, parity):
+        import termios
+        import tty
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        attr = termios.tcgetattr(self.fd)
+        speed = getattr(termios, 'B%d' % baud, None)
+        if speed is not None:
+            attr[4] = attr[5] = speed
+        if parity in 'EO':
+            attr[2] |= termios.PARENB | (termios.PARODD if parity == 'O' else 0)
+        termios.tcsetattr(self.fd, termios.TCSANOW, attr)
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+    def read_until_idle(self, timeout, gap):
+        import select
+        data = b''
+        t_first = None
+        wait = timeout
+        while True:
+            r, _, _ = select.select([self.fd], [], [], wait)
+            if not r:
+                return data, t_first
+            chunk = os.read(self.fd, 256)
+            if t_first is None:
+                t_first = time.perf_counter()
+            data += chunk
+            wait = gap
+
+    def close(self):
+        os.close(self.fd)
+
+
+class SerialPort(object):
+    def __init__(self, path, baud, parity):
+        import serial
+        self.port = serial.Serial(path, baud, parity=parity, timeout=0)
+
+    def write(self, data):
+        self.port.write(data)
+        self.port.flush()
+
+    def read_until_idle(self, timeout, gap):
+        data = b''
+        t_first = None
+        deadline = time.perf_counter() + timeout
+        while True:
+            chunk = self.port.read(256)
+            now = time.perf_counter()
+            if chunk:
+                if t_first is None:
+                    t_first = now
+                data += chunk
+                deadline = now + gap
+            elif now >= deadline:
+                return data, t_first
+            else:
+                time.sleep(0.0002)
+
+    def close(self):
+        self.port.close()
+
+
+def open_port(path, baud, parity):
+    try:
+        return SerialPort(path, baud, parity)
+    except ImportError:
+        return TermiosPort(path, baud, parity)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='replay captured Modbus RTU frames to a slave')
+    ap.add_argument('frames', help='capture file, one hex request per line')
+    ap.add_argument('port', help='serial port (COMx, /dev/ttyX) or pty')
+    ap.add_argument('--baud', type=int, default=115200)
+    ap.add_argument('--parity', default='E', choices='NEO')
+    ap.add_argument('--timeout', type=float, default=0.1, help='response timeout in seconds')
+    opt = ap.parse_args()
+
+    frames = load_frames(opt.frames)
+    port = open_port(opt.port, opt.baud, opt.parity)
+    gap = max(3.5 * 11 / opt.baud, 0.002)           # 应答内的字符间隔
+    fails = 0
+    times = []
+    try:
+        for lineno, req, expect in frames:
+            port.write(req)
+            t_sent = time.perf_counter()
+            rsp, t_first = port.read_until_idle(opt.timeout, gap)
+            tag = 'ok'
+            if expect is not None and rsp != expect:
+                tag = 'FAIL (expect %s)' % expect.hex(' ')
+                fails += 1
+            elif rsp and crc16(rsp) != 0:
+                tag = 'FAIL (bad crc)'
+                fails += 1
+            if t_first is not None:
+                times.append(t_first - t_sent)
+                turn = '%8.3f ms' % ((t_first - t_sent) * 1e3)
+            else:
+                turn = '  no rsp  '
+            print('%4d: %s | %s | %s' % (lineno, turn, rsp.hex(' ') if rsp else '-', tag))
+            time.sleep(gap)
+    finally:
+        port.close()
+
+    if times:
+        print('frames %d, fail %d, turnaround min %.3f / avg %.3f / max %.3f ms'
+              % (len(frames), fails, min(times) * 1e3, sum(times) / len(times) * 1e3, max(times) * 1e3))
+    sys.exit(1 if fails else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,134 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * Modbus RTU从站的主机程序(Linux/gcc): 协议处理(modbus.c)和UART通道(uart_drv.c)用板上的同一份代码,
+ * 通道的底层换成伪终端, 寄存器表和CM4上的MB_Task相同(从站地址1, 保持寄存器0~15, 输入寄存器0~7).
+ * 启动后打印伪终端从设备的路径, 用Tools/modbus_replay.py回放抓包文件:
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -DUART_DRV_HOST -DMB_HOST -ICore/Common/Inc Tools/modbus_slave.c \
+ *       Core/Common/Src/modbus.c Core/Common/Src/uart_drv.c -o modbus_slave
+ * 用法:
+ *   ./modbus_slave [baud, 默认115200] &
+ *   python3 Tools/modbus_replay.py Tools/modbus_frames.txt /dev/pts/N
+ */
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "uart_drv.h"
+#include "modbus.h"
+
+#define SLAVE_ADDR              (1U)
+#define SLAVE_HOLDING_NUM       (16U)
+#define SLAVE_RX_SIZE           (1024U)
+
+
+static uint16_t au16Holding[SLAVE_HOLDING_NUM];
+static uint8_t au8RxBuff[SLAVE_RX_SIZE];
+static uint8_t au8Rx[MB_ADU_MAX];
+static uint8_t au8Tx[MB_ADU_MAX];
+static UartDrv_Port_t stPort;
+static UartDrv_t stDrv;
+static MB_Slave_t stSlave;
+
+// 输入寄存器: 和板上一样是运行状态, 主机上没有运行时间
+static uint8_t Slave_u8ReadStatus(uint16_t u16Addr, uint16_t *pu16Val)
+{
+    switch (u16Addr) {
+    case 2U: *pu16Val = (uint16_t)stSlave.stStat.u32Frames; break;
+    case 3U: *pu16Val = (uint16_t)stSlave.stStat.u32CrcErrors; break;
+    case 4U: *pu16Val = (uint16_t)stSlave.stStat.u32Exceptions; break;
+    case 5U: *pu16Val = (uint16_t)stDrv.stStat.u32Errors; break;
+    case 6U: *pu16Val = (uint16_t)(stDrv.stStat.u32RxLost + stDrv.stStat.u32FrameDrops); break;
+    default: *pu16Val = 0U; break;
+    }
+    return MB_EX_NONE;
+}
+
+static const MB_Reg_t astHolding[] = {
+    { 0U, SLAVE_HOLDING_NUM, au16Holding, NULL, NULL },
+};
+
+static const MB_Reg_t astInput[] = {
+    { 0U, 8U, NULL, Slave_u8ReadStatus, NULL },
+};
+
+static const MB_Map_t stMap = {
+    astHolding, (uint16_t)(sizeof(astHolding) / sizeof(astHolding[0])),
+    astInput, (uint16_t)(sizeof(astInput) / sizeof(astInput[0])),
+};
+
+// 帧结束(主机上在UartDrv_HostPoll里调用), 帧在主循环里读
+static void Slave_Frame(UartDrv_t *pDrv)
+{
+    (void)pDrv;
+}
+
+// 打开伪终端主设备, 设成原始模式和非阻塞(UartDrv_HostPoll读到没有数据为止)
+static int Slave_s32OpenPty(void)
+{
+    struct termios stTio;
+    int s32Fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((s32Fd < 0) || (grantpt(s32Fd) != 0) || (unlockpt(s32Fd) != 0)) {
+        return -1;
+    }
+    if (tcgetattr(s32Fd, &stTio) == 0) {
+        cfmakeraw(&stTio);
+        (void)tcsetattr(s32Fd, TCSANOW, &stTio);
+    }
+    (void)fcntl(s32Fd, F_SETFL, fcntl(s32Fd, F_GETFL) | O_NONBLOCK);
+    return s32Fd;
+}
+
+int main(int argc, char *argv[])
+{
+    struct pollfd stPoll;
+    uint32_t u32Len, u32RspLen, u32GapUs;
+
+    stPort.u32Baud = (argc > 1) ? (uint32_t)atoi(argv[1]) : 115200U;
+    stPort.s32Fd = Slave_s32OpenPty();
+    if (stPort.s32Fd < 0) {
+        perror("pty");
+        return 1;
+    }
+    stSlave.u8Addr = SLAVE_ADDR;
+    stSlave.pMap = &stMap;
+
+    if (!UartDrv_bInit(&stDrv, "mb", &stPort, au8RxBuff, sizeof(au8RxBuff))
+        || !UartDrv_bSetRxTimeout(&stDrv, MB_T35_CHAR10, MB_T35_MIN_US, Slave_Frame) || !UartDrv_bListen(&stDrv)) {
+        fprintf(stderr, "uart init failed\n");
+        return 1;
+    }
+    // 主机上的帧间隔: 等一个T3.5再读, 让一帧在伪终端里到齐
+    u32GapUs = UartDrv_u32TimeoutBits(&stDrv, MB_T35_CHAR10, MB_T35_MIN_US) * 1000000U / stPort.u32Baud;
+    printf("%s\n", ptsname(stPort.s32Fd));
+    fflush(stdout);
+
+    stPoll.fd = stPort.s32Fd;
+    stPoll.events = POLLIN;
+    while (poll(&stPoll, 1, -1) >= 0) {
+        if ((stPoll.revents & POLLIN) == 0) {
+            usleep(10000);                      // 从设备还没有打开(POLLHUP)
+            continue;
+        }
+        usleep(u32GapUs);
+        UartDrv_HostPoll(&stDrv);
+        while (UartDrv_bFrameReady(&stDrv)) {
+            u32Len = UartDrv_u32ReadFrame(&stDrv, au8Rx, sizeof(au8Rx), NULL);
+            u32RspLen = MB_u32Process(&stSlave, au8Rx, u32Len, au8Tx);
+            if (u32RspLen != 0U) {
+                (void)UartDrv_bSend(&stDrv, au8Tx, u32RspLen, NULL, NULL);
+                UartDrv_HostPoll(&stDrv);       // 发送完成事件
+            }
+        }
+    }
+    return 0;
+}
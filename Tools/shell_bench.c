@@ -0,0 +1,121 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * shellHandler输入处理的主机测试(Linux/gcc): 把几MB粘贴的文本(带回车和方向键转义序列)
+ * 逐字节送入shellHandler, 统计每字节的耗时. 另外导出一批命令, 让命令表的长度接近板上.
+ *
+ * 编译(在仓库根目录), 第二个用来对比不用按键索引时的遍历匹配:
+ *   gcc -O2 -funsigned-char -ISHELL/src -D_shell_command_start=__start_shellCommand \
+ *       -D_shell_command_end=__stop_shellCommand Tools/shell_bench.c SHELL/src/shell.c \
+ *       SHELL/src/shell_ext.c -o shell_bench
+ *   同上加 -DSHELL_KEY_INDEX_MAX=0 -o shell_bench_scan, 或 -DSHELL_OUTPUT_BUFFER=0 对比不合并输出
+ * 用法:
+ *   ./shell_bench [MB, 默认8]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "shell.h"
+
+#define BENCH_LINE      60U                     // 每行的字符数, 之后是回车
+
+
+static Shell stShell;
+static char acShellBuff[512];
+static unsigned long u32Written = 0;
+static unsigned long u32Writes = 0;
+
+static signed short Bench_s16Write(char *data, unsigned short len)
+{
+    (void)data;
+    u32Written += len;
+    u32Writes++;
+    return (signed short)len;
+}
+
+#if SHELL_USING_LOCK == 1
+static int Bench_s32Lock(Shell *shell)
+{
+    (void)shell;
+    return 0;
+}
+#endif
+
+static int Bench_s32Nop(void)
+{
+    return 0;
+}
+
+// 导出64个命令, 相当于板上的命令表
+#define BENCH_CMD(n)    SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0)|SHELL_CMD_TYPE(SHELL_TYPE_CMD_FUNC), \
+                                         bench##n, Bench_s32Nop, bench command);
+#define BENCH_CMD8(n)   BENCH_CMD(n##0) BENCH_CMD(n##1) BENCH_CMD(n##2) BENCH_CMD(n##3) \
+                        BENCH_CMD(n##4) BENCH_CMD(n##5) BENCH_CMD(n##6) BENCH_CMD(n##7)
+BENCH_CMD8(0) BENCH_CMD8(1) BENCH_CMD8(2) BENCH_CMD8(3)
+BENCH_CMD8(4) BENCH_CMD8(5) BENCH_CMD8(6) BENCH_CMD8(7)
+
+
+// 生成粘贴的文本: 可打印字符, 每行末尾回车, 偶尔夹着方向键
+static void Bench_Fill(char *pcBuff, size_t xLen)
+{
+    static const char acArrow[][3] = { {0x1B, '[', 'A'}, {0x1B, '[', 'B'}, {0x1B, '[', 'C'}, {0x1B, '[', 'D'} };
+    size_t i = 0;
+    uint32_t u32Seed = 1U;
+    uint32_t u32Col = 0U;
+
+    while (i < xLen) {
+        u32Seed = u32Seed * 1103515245U + 12345U;
+        if ((u32Col >= BENCH_LINE) || (i + 3U >= xLen)) {
+            pcBuff[i++] = '\r';
+            u32Col = 0U;
+        } else if (((u32Seed >> 16) & 0x3FU) == 0U) {
+            memcpy(&pcBuff[i], acArrow[(u32Seed >> 8) & 3U], 3U);
+            i += 3U;
+        } else {
+            pcBuff[i++] = (char)(' ' + ((u32Seed >> 16) % 95U));
+            u32Col++;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t xLen = (size_t)((argc > 1) ? atoi(argv[1]) : 8) * 1024U * 1024U;
+    char *pcInput = malloc(xLen);
+    struct timespec stStart, stEnd;
+    double dNs;
+
+    if (pcInput == NULL) {
+        return 1;
+    }
+    Bench_Fill(pcInput, xLen);
+
+    stShell.write = Bench_s16Write;
+#if SHELL_USING_LOCK == 1
+    stShell.lock = Bench_s32Lock;
+    stShell.unlock = Bench_s32Lock;
+#endif
+    shellInit(&stShell, acShellBuff, sizeof(acShellBuff));
+
+    clock_gettime(CLOCK_MONOTONIC, &stStart);
+    for (size_t i = 0; i < xLen; i++) {
+        shellHandler(&stShell, pcInput[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stEnd);
+
+    dNs = (double)(stEnd.tv_sec - stStart.tv_sec) * 1e9 + (double)(stEnd.tv_nsec - stStart.tv_nsec);
+    printf("%lu bytes, %u commands, key index %s: %.3f s, %.1f ns/byte, %.1f MB/s, output %lu bytes in %lu writes\n",
+           (unsigned long)xLen, (unsigned)stShell.commandList.count,
+#if SHELL_KEY_INDEX_MAX > 0
+           (stShell.commandList.keyIndex != NULL) ? "on" : "off",
+#else
+           "off",
+#endif
+           dNs / 1e9, dNs / (double)xLen, (double)xLen / 1048576.0 / (dNs / 1e9), u32Written, u32Writes);
+    free(pcInput);
+    return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * shell脚本(shellscript.c)的主机测试(Linux/gcc): 脚本执行和命令解析用板上的同一份代码(letter shell用命令表方式),
+ * littlefs的块设备在内存里. 测试命令t_log把参数记到日志串里(不显示返回值), t_fail返回1, source执行嵌套的脚本.
+ * 每种情况写一个脚本文件, 执行后检查日志串, shell输出, 返回值和统计.
+ *   1. -e: 命令返回非0或命令不存在时停在这一行, 后面的命令不执行; 没有-e时继续并记下第一个错误的行号.
+ *   2. -v: 执行前输出"> 命令行", 空行和注释不输出, tab换成空格.
+ *   3. 行太长: 超过256字节的行整行丢弃并记为错误(-e时停止), 正好256字节的行正常执行.
+ *   4. 最后一行没有行尾: 照常执行; 太长的最后一行也要报错; \r\n行尾和跨SCR_CHUNK的行.
+ *   5. 嵌套source: 脚本里的source返回SCR_ERR_BUSY, 外层脚本记为错误(-e时停止), 之后可以再执行脚本.
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -DSCR_HOST -DSHELL_USING_CMD_EXPORT=0 -DSHELL_USING_LOCK=0 -DSHELL_TASK_WHILE=0 -ISHELL/src -IFS \
+ *       -IFS/littlefs Tools/shellscript_host.c FS/shellscript.c SHELL/src/shell.c SHELL/src/shell_ext.c \
+ *       FS/littlefs/lfs.c FS/littlefs/lfs_util.c -o shellscript_host
+ * 用法:
+ *   ./shellscript_host
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lfs.h"
+#include "shell.h"
+#include "shellscript.h"
+
+#define HOST_BLOCK_SIZE         (8192U)         // BSP_FS_BLOCK_SIZE
+#define HOST_BLOCK_COUNT        (16U)
+#define HOST_PROG_SIZE          (128U)          // READ_PROG_BYTEMIN
+#define HOST_LOG_MAX            (4096U)
+#define HOST_OUT_MAX            (8192U)
+
+
+static uint8_t au8Flash[HOST_BLOCK_COUNT][HOST_BLOCK_SIZE];
+static char acShellBuff[512];
+static char acLog[HOST_LOG_MAX];                // t_log的参数, 用'|'隔开
+static char acOut[HOST_OUT_MAX];                // shell输出
+static uint32_t u32OutLen = 0U;
+static char acScript[4096];
+static char acExp[HOST_LOG_MAX];                // 期望的日志串
+static Shell stShell;
+static lfs_t stLfs;
+static bool bPass = true;
+
+
+static int Host_s32Read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    (void)c;
+    memcpy(buffer, &au8Flash[block][off], size);
+    return 0;
+}
+
+static int Host_s32Prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    const uint8_t *pu8Src = (const uint8_t *)buffer;
+
+    (void)c;
+    for (lfs_size_t i = 0; i < size; i++) {
+        au8Flash[block][off + i] &= pu8Src[i];  // NOR FLASH只能把1写成0
+    }
+    return 0;
+}
+
+static int Host_s32Erase(const struct lfs_config *c, lfs_block_t block)
+{
+    (void)c;
+    memset(au8Flash[block], 0xFF, HOST_BLOCK_SIZE);
+    return 0;
+}
+
+static int Host_s32Sync(const struct lfs_config *c)
+{
+    (void)c;
+    return 0;
+}
+
+static const struct lfs_config stCfg = {
+    .read  = Host_s32Read,
+    .prog  = Host_s32Prog,
+    .erase = Host_s32Erase,
+    .sync  = Host_s32Sync,
+    .read_size = HOST_PROG_SIZE,
+    .prog_size = HOST_PROG_SIZE,
+    .block_size = HOST_BLOCK_SIZE,
+    .block_count = HOST_BLOCK_COUNT,
+    .cache_size = 256,                          // CACHE_SIZE
+    .lookahead_size = 128,                      // LOOKAHEADE_SIZE
+    .block_cycles = 500,                        // BLOCK_CYCLES
+};
+
+static signed short Host_s16Write(char *pcData, unsigned short u16Len)
+{
+    if ((u32OutLen + u16Len) < sizeof(acOut)) {
+        memcpy(&acOut[u32OutLen], pcData, u16Len);
+        u32OutLen += u16Len;
+        acOut[u32OutLen] = '\0';
+    }
+    return (signed short)u16Len;
+}
+
+static signed short Host_s16Read(char *pcData, unsigned short u16Len)
+{
+    (void)pcData;
+    (void)u16Len;
+    return 0;
+}
+
+// t_log <arg>: 记下参数
+static int Host_Log(int argc, char *argv[])
+{
+    size_t len = strlen(acLog);
+
+    (void)snprintf(&acLog[len], sizeof(acLog) - len, "%s|", (argc > 1) ? argv[1] : "");
+    return 0;
+}
+
+// t_fail: 返回1
+static int Host_Fail(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    return 1;
+}
+
+// source <path>: 脚本里再执行脚本
+static int Host_Source(int argc, char *argv[])
+{
+    return (argc > 1) ? SCR_s32Run(&stLfs, &stShell, argv[1], 0U) : -1;
+}
+
+const ShellCommand shellCommandList[] = {
+    {.attr.value = SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_USER),
+     .data.user.name = SHELL_DEFAULT_USER,
+     .data.user.password = SHELL_DEFAULT_USER_PASSWORD,
+     .data.user.desc = "default user"},
+    SHELL_CMD_ITEM(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN) | SHELL_CMD_DISABLE_RETURN,
+                   t_log, Host_Log, log arg),
+    SHELL_CMD_ITEM(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), t_fail, Host_Fail, return 1),
+    SHELL_CMD_ITEM(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), source, Host_Source, run script),
+};
+const unsigned short shellCommandCount = sizeof(shellCommandList) / sizeof(ShellCommand);
+
+
+static void Host_WriteFile(const char *pcPath, const char *pcData, size_t len)
+{
+    lfs_file_t stFile;
+
+    if ((lfs_file_open(&stLfs, &stFile, pcPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) < 0)
+        || (lfs_file_write(&stLfs, &stFile, pcData, (lfs_size_t)len) != (lfs_ssize_t)len)
+        || (lfs_file_close(&stLfs, &stFile) < 0)) {
+        fprintf(stderr, "write %s failed\n", pcPath);
+        exit(1);
+    }
+}
+
+// 写脚本并执行, 检查返回值, 日志串, 错误数和第一个错误的行号
+static void Host_Check(const char *pcName, const char *pcScript, size_t len, uint32_t u32Flags,
+                       int s32Ret, const char *pcLog, uint32_t u32Errors, uint32_t u32ErrLine)
+{
+    const SCR_Stat_t *pStat = SCR_pStat();
+    bool bOk;
+    int s32Got;
+
+    Host_WriteFile("/t.scr", pcScript, len);
+    acLog[0] = '\0';
+    u32OutLen = 0U;
+    acOut[0] = '\0';
+    s32Got = SCR_s32Run(&stLfs, &stShell, "/t.scr", u32Flags);
+    bOk = (s32Got == s32Ret) && (strcmp(acLog, pcLog) == 0) && (pStat->u32Errors == u32Errors)
+          && (pStat->u32ErrLine == u32ErrLine) && (pStat->u32Bytes == len);
+    printf("%-28s ret %d, log \"%.24s\", %u lines, %u cmds, %u errors (first at line %u): %s\n", pcName, s32Got, acLog,
+           (unsigned)pStat->u32Lines, (unsigned)pStat->u32Cmds, (unsigned)pStat->u32Errors,
+           (unsigned)pStat->u32ErrLine, bOk ? "ok" : "FAIL");
+    bPass &= bOk;
+}
+
+#define HOST_CHECK(name, script, flags, ret, log, errors, errline) \
+    Host_Check(name, script, strlen(script), flags, ret, log, errors, errline)
+
+// 一行: 前缀 + 填充到u32Len字节(不含行尾)
+static size_t Host_Line(char *pcBuf, const char *pcPrefix, uint32_t u32Len)
+{
+    size_t len = strlen(pcPrefix);
+
+    memcpy(pcBuf, pcPrefix, len);
+    memset(&pcBuf[len], 'x', u32Len - len);
+    return u32Len;
+}
+
+int main(void)
+{
+    size_t len;
+    bool bOk;
+
+    if ((lfs_format(&stLfs, &stCfg) != 0) || (lfs_mount(&stLfs, &stCfg) != 0)) {
+        fprintf(stderr, "lfs mount failed\n");
+        return 1;
+    }
+    stShell.write = Host_s16Write;
+    stShell.read = Host_s16Read;
+    shellInit(&stShell, acShellBuff, sizeof(acShellBuff));
+
+    // 1. -e
+    HOST_CHECK("fail, no -e", "t_log a\nt_fail\nt_log b\n", 0U, 0, "a|b|", 1U, 2U);
+    HOST_CHECK("fail, -e", "t_log a\nt_fail\nt_log b\n", SCR_F_STOP, SCR_ERR_CMD, "a|", 1U, 2U);
+    HOST_CHECK("unknown, no -e", "t_log a\n\nno_such_cmd\nt_log b\nt_fail\n", 0U, 0, "a|b|", 2U, 3U);
+    HOST_CHECK("unknown, -e", "t_log a\n\nno_such_cmd\nt_log b\nt_fail\n", SCR_F_STOP, SCR_ERR_CMD, "a|", 1U, 3U);
+
+    // 2. -v
+    HOST_CHECK("echo, -v", "t_log a\n  # comment\n\n\tt_log\tb\n", SCR_F_ECHO, 0, "a|b|", 0U, 0U);
+    bOk = (strcmp(acOut, "> t_log a\r\n> t_log b\r\n") == 0);
+    printf("%-28s \"%s\": %s\n", "echo output", acOut, bOk ? "ok" : "FAIL");
+    bPass &= bOk;
+    HOST_CHECK("no echo", "t_log a\n", 0U, 0, "a|", 0U, 0U);
+    bOk = (u32OutLen == 0U);
+    printf("%-28s %u bytes: %s\n", "no echo output", (unsigned)u32OutLen, bOk ? "ok" : "FAIL");
+    bPass &= bOk;
+
+    // 3. 行太长
+    len = 0;
+    len += Host_Line(&acScript[len], "t_log a", SCR_LINE_MAX + 44U);
+    len += (size_t)sprintf(&acScript[len], "\nt_log b\n");
+    Host_Check("long line, no -e", acScript, len, 0U, 0, "b|", 1U, 1U);
+    Host_Check("long line, -e", acScript, len, SCR_F_STOP, SCR_ERR_LINE, "", 1U, 1U);
+    len = (size_t)sprintf(acScript, "t_log a\n");
+    len += Host_Line(&acScript[len], "t_log ", SCR_LINE_MAX);
+    acScript[len++] = '\n';
+    (void)sprintf(acExp, "a|%.*s|", (int)(SCR_LINE_MAX - 6U), &acScript[len - (SCR_LINE_MAX - 6U) - 1U]);
+    Host_Check("256-byte line", acScript, len, SCR_F_STOP, 0, acExp, 0U, 0U);
+
+    // 4. 最后一行没有行尾
+    HOST_CHECK("no newline", "t_log a\nt_log b", 0U, 0, "a|b|", 0U, 0U);
+    HOST_CHECK("crlf, no newline", "t_log a\r\nt_log b\r\nt_fail", SCR_F_STOP, SCR_ERR_CMD, "a|b|", 1U, 3U);
+    len = (size_t)sprintf(acScript, "t_log a\n");
+    len += Host_Line(&acScript[len], "t_log b", SCR_LINE_MAX + 1U);
+    Host_Check("long last line, no -e", acScript, len, 0U, 0, "a|", 1U, 2U);
+    Host_Check("long last line, -e", acScript, len, SCR_F_STOP, SCR_ERR_LINE, "a|", 1U, 2U);
+    len = 0;
+    acExp[0] = '\0';
+    for (uint32_t i = 0; len < (SCR_CHUNK * 3U); i++) {
+        len += (size_t)sprintf(&acScript[len], "t_log %u\n", (unsigned)(i % 10U));
+        (void)sprintf(&acExp[i * 2U], "%u|", (unsigned)(i % 10U));
+    }
+    acScript[--len] = '\0';                     // 去掉最后的行尾
+    Host_Check("lines across chunks", acScript, len, SCR_F_STOP, 0, acExp, 0U, 0U);
+
+    // 5. 嵌套source
+    HOST_CHECK("inner", "t_log b\n", 0U, 0, "b|", 0U, 0U);
+    Host_WriteFile("/inner.scr", "t_log b\n", 8U);
+    HOST_CHECK("nested, no -e", "t_log a\nsource /inner.scr\nt_log c\n", 0U, 0, "a|c|", 1U, 2U);
+    HOST_CHECK("nested, -e", "t_log a\nsource /inner.scr\nt_log c\n", SCR_F_STOP, SCR_ERR_CMD, "a|", 1U, 2U);
+    HOST_CHECK("after nested", "t_log d\n", 0U, 0, "d|", 0U, 0U);
+    bOk = (SCR_s32Run(&stLfs, &stShell, "/no_such.scr", 0U) == LFS_ERR_NOENT);
+    printf("%-28s: %s\n", "missing file", bOk ? "ok" : "FAIL");
+    bPass &= bOk;
+
+    printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
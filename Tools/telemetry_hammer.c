@@ -0,0 +1,114 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * 遥测快照(telemetry.c)顺序锁的主机测试(Linux/gcc): 一个写线程不停地用TLM_Write发布快照,
+ * 几个读线程不停地TLM_bRead, 检查读到的快照是否完整(没有新旧数据混在一起).
+ * 写线程每次把整个快照的每个字填成同一个值, 读到的快照里只要有一个字不同就是读到了写了一半的数据.
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -pthread -DTLM_HOST -ICore/Common/Inc Tools/telemetry_hammer.c \
+ *       Core/Common/Src/telemetry.c -o telemetry_hammer
+ * 用法:
+ *   ./telemetry_hammer [秒, 默认5] [读线程数, 默认3]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "telemetry.h"
+
+#define HAMMER_READERS_MAX      (8)
+#define HAMMER_WORDS            (sizeof(TLM_Data_t) / sizeof(uint32_t))
+
+typedef struct _Hammer_Reader_ {
+    pthread_t xThread;
+    unsigned long u32Reads;                     // TLM_bRead成功的次数
+    unsigned long u32Busy;                      // 重试了TLM_READ_RETRY次仍然没读到
+    unsigned long u32Torn;                      // 读到的快照不完整
+    unsigned long u32Back;                      // 读到的快照比上一次旧
+} Hammer_Reader_t;
+
+static TLM_Block_t stBlock;
+static volatile int s32Stop = 0;
+static unsigned long u32Writes = 0;
+
+static void *Hammer_Writer(void *pArg)
+{
+    union { TLM_Data_t stData; uint32_t au32Word[HAMMER_WORDS]; } uData;
+    uint32_t u32Val = 0U;
+    size_t i;
+
+    (void)pArg;
+    while (!s32Stop) {
+        u32Val++;
+        for (i = 0; i < HAMMER_WORDS; i++) {
+            uData.au32Word[i] = u32Val;
+        }
+        TLM_Write(&stBlock, &uData.stData);
+        u32Writes++;
+    }
+    return NULL;
+}
+
+static void *Hammer_Reader(void *pArg)
+{
+    Hammer_Reader_t *pReader = (Hammer_Reader_t *)pArg;
+    union { TLM_Data_t stData; uint32_t au32Word[HAMMER_WORDS]; } uData;
+    uint32_t u32Last = 0U;
+    size_t i;
+
+    while (!s32Stop) {
+        if (!TLM_bRead(&stBlock, &uData.stData)) {
+            pReader->u32Busy++;
+            continue;
+        }
+        pReader->u32Reads++;
+        for (i = 1; i < HAMMER_WORDS; i++) {
+            if (uData.au32Word[i] != uData.au32Word[0]) {
+                pReader->u32Torn++;
+                break;
+            }
+        }
+        if (uData.au32Word[0] < u32Last) {
+            pReader->u32Back++;
+        }
+        u32Last = uData.au32Word[0];
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    static Hammer_Reader_t astReader[HAMMER_READERS_MAX];
+    int s32Sec = (argc > 1) ? atoi(argv[1]) : 5;
+    int s32Num = (argc > 2) ? atoi(argv[2]) : 3;
+    unsigned long u32Torn = 0;
+    pthread_t xWriter;
+    int i;
+
+    if ((s32Num < 1) || (s32Num > HAMMER_READERS_MAX)) {
+        s32Num = 3;
+    }
+    memset(&stBlock, 0, sizeof(stBlock));
+    (void)pthread_create(&xWriter, NULL, Hammer_Writer, NULL);
+    for (i = 0; i < s32Num; i++) {
+        (void)pthread_create(&astReader[i].xThread, NULL, Hammer_Reader, &astReader[i]);
+    }
+    sleep((unsigned)s32Sec);
+    s32Stop = 1;
+    (void)pthread_join(xWriter, NULL);
+
+    printf("snapshot %u bytes, %lu writes in %d s\n", (unsigned)sizeof(TLM_Data_t), u32Writes, s32Sec);
+    for (i = 0; i < s32Num; i++) {
+        (void)pthread_join(astReader[i].xThread, NULL);
+        printf("reader %d: %lu reads, %lu busy, %lu torn, %lu backwards\n", i,
+               astReader[i].u32Reads, astReader[i].u32Busy, astReader[i].u32Torn, astReader[i].u32Back);
+        u32Torn += astReader[i].u32Torn + astReader[i].u32Back;
+    }
+    printf("%s\n", (u32Torn == 0) ? "PASS" : "FAIL");
+    return (u32Torn == 0) ? 0 : 1;
+}
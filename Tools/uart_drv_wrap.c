@@ -0,0 +1,165 @@
+/*
+ * STM32H747I-DISCO study
+ * Copyright (C) 2023 Schneider-Electric.
+ * All Rights Reserved.
+ *
+ * UART通道(uart_drv.c)接收位置回绕的主机测试(Linux/gcc): 用软件模拟循环DMA, 按板上中断的顺序调用
+ * UartDrv_RxEventFromISR(半满/全满)和UartDrv_RxTimeoutFromISR/UartDrv_RxIdleFromISR(接收超时/空闲线),
+ * 每帧写入后产生一次接收超时, 再用UartDrv_u32ReadFrame读出比较. 帧的数据是由序号决定的字节序列.
+ *   1. 正常: 半满/全满事件在接收超时之前处理.
+ *   2. 接收超时正好在回绕处: 帧结束在缓存末尾, 读DMA计数器得到位置0(或缓存长度), 全满事件在接收超时之后才处理.
+ *   3. 回绕之后的接收超时: 帧结束在回绕之后几个字节, 全满事件在接收超时之后才处理(过期, 要丢弃).
+ *   4. 空闲线事件(没有接收超时分帧的通道)正好在回绕处, 全满事件在之后处理.
+ * 每种情况检查: 每帧长度和数据都对, 接收字节数等于写入的字节数, 没有被覆盖的数据.
+ *
+ * 编译(在仓库根目录):
+ *   gcc -O2 -DUART_DRV_HOST -ICore/Common/Inc Tools/uart_drv_wrap.c Core/Common/Src/uart_drv.c -o uart_drv_wrap
+ * 用法:
+ *   ./uart_drv_wrap [每种情况的帧数, 默认2000]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uart_drv.h"
+
+#define TEST_RX_SIZE            (512U)
+#define TEST_HALF               (TEST_RX_SIZE / 2U)
+#define TEST_TAIL_MAX           (8U)            // 情况3: 回绕之后到接收超时的字节数
+
+enum {
+    TEST_NORMAL = 0,
+    TEST_RTO_AT_WRAP,
+    TEST_RTO_AFTER_WRAP,
+    TEST_IDLE_AT_WRAP,
+    TEST_CASE_NUM
+};
+
+static const char *apcCase[TEST_CASE_NUM] = {"normal", "rto at wrap", "rto after wrap", "idle at wrap"};
+static uint8_t au8RxBuff[TEST_RX_SIZE];
+static uint8_t au8Frame[TEST_RX_SIZE];
+static UartDrv_Port_t stPort;
+static UartDrv_t stDrv;
+static uint32_t u32DmaPos = 0U;                 // 模拟DMA在缓存里的位置(0 ~ TEST_RX_SIZE-1)
+static uint32_t u32Frames = 0U;                 // 接收超时回调的次数
+static uint32_t u32Wraps = 0U;                  // DMA回绕的次数
+
+
+static void Test_Frame(UartDrv_t *pDrv)
+{
+    (void)pDrv;
+    u32Frames++;
+}
+
+static uint8_t Test_u8Byte(uint32_t u32Seq, uint32_t i)
+{
+    return (uint8_t)(u32Seq * 13U + i);
+}
+
+// DMA写一个字节; 到半满/全满时产生事件, bLateTc时全满事件留给调用者
+static bool Test_bDmaByte(uint8_t u8Data, bool bLateTc)
+{
+    au8RxBuff[u32DmaPos++] = u8Data;
+    if (u32DmaPos == TEST_HALF) {
+        UartDrv_RxEventFromISR(&stDrv, (uint16_t)TEST_HALF);
+    } else if (u32DmaPos == TEST_RX_SIZE) {
+        u32DmaPos = 0U;
+        u32Wraps++;
+        if (!bLateTc) {
+            UartDrv_RxEventFromISR(&stDrv, (uint16_t)TEST_RX_SIZE);
+        }
+        return true;
+    }
+    return false;
+}
+
+// 写一帧并产生接收超时(或空闲线)事件, 返回读出的帧是否正确
+static bool Test_bFrame(uint32_t u32Case, uint32_t u32Seq)
+{
+    uint32_t u32Len = 1U + (uint32_t)(rand() % (int)(TEST_HALF - TEST_TAIL_MAX));
+    bool bLateTc = (u32Case != TEST_NORMAL);
+    bool bWrapped = false;
+    uint16_t u16Pos;
+    uint32_t i, u32Got;
+
+    // 回绕的情况: 帧结束在缓存末尾, 或回绕之后几个字节
+    if ((u32Case != TEST_NORMAL) && ((u32Seq & 1U) != 0U)) {
+        u32Len = TEST_RX_SIZE - u32DmaPos;
+        if (u32Len > TEST_HALF) {
+            u32Len -= TEST_HALF;                // 先到后半个缓存, 下一帧再结束在末尾
+        } else if (u32Case == TEST_RTO_AFTER_WRAP) {
+            u32Len += 1U + (u32Seq % TEST_TAIL_MAX);
+        }
+    }
+    for (i = 0; i < u32Len; i++) {
+        bWrapped |= Test_bDmaByte(Test_u8Byte(u32Seq, i), bLateTc);
+    }
+
+    // 接收超时读DMA计数器: 回绕后计数器重新装入缓存长度, 位置是0; 偶尔按还没重新装入(缓存长度)报告
+    u16Pos = (uint16_t)u32DmaPos;
+    if ((u16Pos == 0U) && ((u32Seq & 2U) != 0U)) {
+        u16Pos = (uint16_t)TEST_RX_SIZE;
+    }
+    if (u32Case == TEST_IDLE_AT_WRAP) {
+        UartDrv_RxIdleFromISR(&stDrv, u16Pos);
+    } else {
+        UartDrv_RxTimeoutFromISR(&stDrv, u16Pos);
+    }
+    if (bWrapped && bLateTc) {
+        UartDrv_RxEventFromISR(&stDrv, (uint16_t)TEST_RX_SIZE);    // 全满中断这时才处理
+    }
+
+    if (u32Case == TEST_IDLE_AT_WRAP) {
+        u32Got = UartDrv_u32Read(&stDrv, au8Frame, sizeof(au8Frame));
+    } else {
+        u32Got = UartDrv_u32ReadFrame(&stDrv, au8Frame, sizeof(au8Frame), NULL);
+    }
+    if (u32Got != u32Len) {
+        return false;
+    }
+    for (i = 0; i < u32Len; i++) {
+        if (au8Frame[i] != Test_u8Byte(u32Seq, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t u32Num = (argc > 1) ? (uint32_t)atoi(argv[1]) : 2000U;
+    uint32_t u32Bad, n;
+    uint64_t u64Bytes;
+    bool bOk, bPass = true;
+
+    srand(1);
+    stPort.s32Fd = 0;                           // 不读伪终端, 只要通道能启动
+    for (uint32_t c = 0; c < TEST_CASE_NUM; c++) {
+        if (!UartDrv_bInit(&stDrv, "WRAP", &stPort, au8RxBuff, sizeof(au8RxBuff))
+            || ((c != TEST_IDLE_AT_WRAP) && !UartDrv_bSetRxTimeout(&stDrv, 35U, 1750U, Test_Frame))
+            || !UartDrv_bListen(&stDrv)) {
+            fprintf(stderr, "uart init failed\n");
+            return 1;
+        }
+        u32DmaPos = 0U;
+        u32Frames = 0U;
+        u32Bad = 0U;
+        u32Wraps = 0U;
+        u64Bytes = 0U;
+        for (n = 0; n < u32Num; n++) {
+            u64Bytes -= stDrv.stStat.u32RxBytes;
+            if (!Test_bFrame(c, n)) {
+                u32Bad++;
+            }
+            u64Bytes += stDrv.stStat.u32RxBytes;
+        }
+        bOk = (u32Bad == 0U) && (stDrv.stStat.u32RxLost == 0U) && (stDrv.stStat.u32FrameDrops == 0U)
+              && ((c == TEST_IDLE_AT_WRAP) || (u32Frames == u32Num))
+              && (stDrv.u32RxHead == stDrv.u32RxTail);
+        printf("%-16s %u frames, %llu bytes, %u wraps, %u bad, lost %u, stale events %u: %s\n", apcCase[c],
+               (unsigned)u32Num, (unsigned long long)u64Bytes, (unsigned)u32Wraps, (unsigned)u32Bad,
+               (unsigned)stDrv.stStat.u32RxLost, (unsigned)stDrv.stStat.u32RxStale, bOk ? "ok" : "FAIL");
+        bPass &= bOk;
+    }
+    printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}